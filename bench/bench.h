@@ -0,0 +1,90 @@
+/**
+ * @file bench.h
+ * @author krad2
+ * @brief Timing, key generation and reporting shared by the benchmarks in this directory.
+ * @details Every benchmark is a single file that builds straight against the library sources, from the top of the
+ * repository, e.g.:
+ *
+ *     cc -O2 -I. bench/bench_delete.c rbtree.c -o bench_delete && ./bench_delete
+ *
+ * The comment at the top of each one gives its exact command line. Results are printed as plain tables, and each
+ * timing is the best of a few runs so that a stray interrupt doesn't skew it.
+ */
+
+#ifndef RBTREE_BENCH_H_
+#define RBTREE_BENCH_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/** Runs per measurement; the fastest one is reported. */
+#define BENCH_RUNS											3
+
+/**
+ * @brief Monotonic wall-clock time, in seconds.
+ */
+static inline double bench_now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Next value of a xorshift64 generator. Fast, and the same sequence on every platform for a given seed.
+ */
+static inline uint64_t bench_rand(uint64_t *state) {
+	uint64_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	return *state = x;
+}
+
+/**
+ * @brief Shuffles an array of pointers in place (Fisher-Yates).
+ */
+static inline void bench_shuffle(void **items, size_t n, uint64_t *state) {
+	for (size_t i = n; i > 1; i--) {
+		size_t j = bench_rand(state) % i;
+		void *swap = items[i - 1];
+
+		items[i - 1] = items[j];
+		items[j] = swap;
+	}
+}
+
+/**
+ * @brief qsort comparator for uint64_t.
+ */
+static inline int bench_cmp_u64(const void *left, const void *right) {
+	uint64_t a = *(const uint64_t *) left, b = *(const uint64_t *) right;
+
+	return (a > b) - (a < b);
+}
+
+/**
+ * @brief malloc that gives up on the whole benchmark if there isn't memory.
+ */
+static inline void *bench_alloc(size_t bytes) {
+	void *memory = malloc(bytes);
+
+	if (!memory) {
+		fprintf(stderr, "out of memory (%zu bytes)\n", bytes);
+		exit(1);
+	}
+
+	return memory;
+}
+
+/**
+ * @brief Parses argv[i] as a count, or returns fallback if it isn't there.
+ */
+static inline size_t bench_arg(int argc, char **argv, int i, size_t fallback) {
+	return (argc > i) ? (size_t) strtoull(argv[i], NULL, 0) : fallback;
+}
+
+#endif /* RBTREE_BENCH_H_ */
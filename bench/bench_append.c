@@ -0,0 +1,83 @@
+/**
+ * @file bench_append.c
+ * @author krad2
+ * @brief Appending and prepending sequential keys on the cached trees against a full descent.
+ * @details Inserts n sequential keys in three ways: ascending into an rcached tree, descending into an lcached tree and
+ * ascending into an lrcached tree. Each is timed against inserting the same keys with plain rb_tree_insert, which
+ * descends from the root every time; that is all the cached inserts did before the fast paths, on top of updating the
+ * cached ends. Times are ns per key.
+ *
+ *     cc -O2 -I. bench/bench_append.c rbtree.c -o bench_append
+ *     ./bench_append [n = 10000000]
+ */
+
+#include "rbtree.h"
+#include "bench/bench.h"
+
+typedef struct item {
+	uint64_t key;
+	rb_node_t node;
+} item_t;
+
+typedef enum variant {
+	variant_rcached = 0,
+	variant_lcached = 1,
+	variant_lrcached = 2
+} variant_t;
+
+static const char *variant_names[] = { "rcached, ascending", "lcached, descending", "lrcached, ascending" };
+
+static int cmp(const rb_node_t *left, const rb_node_t *right) {
+	uint64_t a = rb_entry(left, item_t, node)->key, b = rb_entry(right, item_t, node)->key;
+
+	return (a > b) - (a < b);
+}
+
+/**
+ * @brief Time per key to insert n sequential keys into the given tree, or into a plain rb_tree_t if cached is false.
+ */
+static double measure(item_t *items, size_t n, variant_t variant, bool cached) {
+	double best = 1e30;
+
+	for (size_t i = 0; i < n; i++) items[i].key = (variant == variant_lcached) ? n - i : i;
+
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		rb_tree_rcached_t rtree;
+		rb_tree_lcached_t ltree;
+		rb_tree_lrcached_t lrtree;
+		rb_tree_t tree;
+		double start, elapsed;
+
+		rb_tree_init(&tree);
+		rb_tree_rcached_init(&rtree);
+		rb_tree_lcached_init(&ltree);
+		rb_tree_lrcached_init(&lrtree);
+
+		start = bench_now();
+		if (!cached) for (size_t i = 0; i < n; i++) rb_tree_insert(&tree, &items[i].node, cmp);
+		else if (variant == variant_rcached) for (size_t i = 0; i < n; i++) rb_tree_rcached_insert(&rtree, &items[i].node, cmp);
+		else if (variant == variant_lcached) for (size_t i = 0; i < n; i++) rb_tree_lcached_insert(&ltree, &items[i].node, cmp);
+		else for (size_t i = 0; i < n; i++) rb_tree_lrcached_insert(&lrtree, &items[i].node, cmp);
+		elapsed = bench_now() - start;
+
+		if (elapsed < best) best = elapsed;
+	}
+
+	return best / (double) n;
+}
+
+int main(int argc, char **argv) {
+	size_t n = bench_arg(argc, argv, 1, 10000000);
+	item_t *items = bench_alloc(n * sizeof(*items));
+
+	printf("n = %zu, ns per key\n", n);
+	printf("%-22s %12s %12s\n", "", "descent", "fast path");
+
+	for (variant_t variant = variant_rcached; variant <= variant_lrcached; variant++) {
+		printf("%-22s %12.1f %12.1f\n", variant_names[variant], measure(items, n, variant, false) * 1e9,
+			measure(items, n, variant, true) * 1e9);
+	}
+
+	free(items);
+	return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file bench_batch.c
+ * @author krad2
+ * @brief rb_tree_insert_batch against inserting the same nodes one at a time.
+ * @details A tree of n random keys takes ten batches of m more, whose keys are either random, clustered within a
+ * narrow window, or increasing past everything already in the tree. Reported per inserted node: time, and how many
+ * times the comparator was called, which counts the batch's sort as well as its descents.
+ *
+ *     cc -O2 -I. bench/bench_batch.c rbtree.c -o bench_batch
+ *     ./bench_batch [n = 1000000] [m = 50000]
+ */
+
+#include "rbtree.h"
+#include "bench/bench.h"
+
+typedef struct item {
+	uint64_t key;
+	rb_node_t node;
+} item_t;
+
+typedef enum pattern {
+	pattern_random = 0,
+	pattern_clustered = 1,
+	pattern_monotonic = 2
+} pattern_t;
+
+static const char *pattern_names[] = { "random", "clustered", "monotonic" };
+
+/** Batches inserted per run. */
+#define ROUNDS												10
+
+/** Width of the key window a clustered batch falls in. */
+#define CLUSTER												200000
+
+static size_t calls;
+
+static int cmp(const rb_node_t *left, const rb_node_t *right) {
+	uint64_t a = rb_entry(left, item_t, node)->key, b = rb_entry(right, item_t, node)->key;
+
+	calls++;
+	return (a > b) - (a < b);
+}
+
+/**
+ * @brief Key for the i-th node of a batch.
+ */
+static uint64_t batch_key(pattern_t pattern, size_t i, uint64_t center, uint64_t *seed) {
+	if (pattern == pattern_random) return bench_rand(seed);
+	if (pattern == pattern_clustered) return center + bench_rand(seed) % CLUSTER;
+
+	/* the base keys never come near the top bit */
+	return ((uint64_t) 1 << 63) + i;
+}
+
+int main(int argc, char **argv) {
+	size_t n = bench_arg(argc, argv, 1, 1000000), m = bench_arg(argc, argv, 2, 50000);
+	item_t *base = bench_alloc(n * sizeof(*base)), *extra = bench_alloc(ROUNDS * m * sizeof(*extra));
+	rb_node_t **nodes = bench_alloc(m * sizeof(*nodes));
+
+	printf("n = %zu, %d batches of %zu\n", n, ROUNDS, m);
+	printf("%-10s %12s %12s %12s %12s\n", "keys", "loop ns", "batch ns", "loop cmps", "batch cmps");
+
+	for (pattern_t pattern = pattern_random; pattern <= pattern_monotonic; pattern++) {
+		double best[2] = { 1e30, 1e30 };
+		size_t compares[2] = { 0, 0 };
+
+		for (int run = 0; run < BENCH_RUNS; run++) {
+			for (int batched = 0; batched < 2; batched++) {
+				uint64_t seed = 0x9e3779b97f4a7c15ull;
+				double elapsed = 0;
+				rb_tree_t tree;
+
+				rb_tree_init(&tree);
+				for (size_t i = 0; i < n; i++) {
+					base[i].key = bench_rand(&seed) >> 1;
+					rb_tree_insert(&tree, &base[i].node, cmp);
+				}
+
+				calls = 0;
+				for (size_t r = 0; r < ROUNDS; r++) {
+					uint64_t center = bench_rand(&seed) >> 1;
+					double start;
+
+					for (size_t i = 0; i < m; i++) {
+						item_t *item = &extra[r * m + i];
+
+						item->key = batch_key(pattern, r * m + i, center, &seed);
+						nodes[i] = &item->node;
+					}
+
+					start = bench_now();
+					if (batched) rb_tree_insert_batch(&tree, nodes, m, cmp);
+					else for (size_t i = 0; i < m; i++) rb_tree_insert(&tree, nodes[i], cmp);
+					elapsed += bench_now() - start;
+				}
+
+				if (elapsed < best[batched]) best[batched] = elapsed;
+				compares[batched] = calls;
+			}
+		}
+
+		printf("%-10s %12.1f %12.1f %12.1f %12.1f\n", pattern_names[pattern],
+			best[0] / (double) (ROUNDS * m) * 1e9, best[1] / (double) (ROUNDS * m) * 1e9,
+			(double) compares[0] / (double) (ROUNDS * m), (double) compares[1] / (double) (ROUNDS * m));
+	}
+
+	free(nodes);
+	free(extra);
+	free(base);
+	return 0;
+}
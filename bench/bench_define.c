@@ -0,0 +1,94 @@
+/**
+ * @file bench_define.c
+ * @author krad2
+ * @brief Functions generated by RB_DEFINE_TREE against rb_tree_insert and rb_find with a comparator pointer.
+ * @details Trees of 1K, 100K and 1M random keys are built with each API, then every key is looked up again, for
+ * about 20M lookups per size. Times are ns per insert and per find.
+ *
+ *     cc -O2 -I. bench/bench_define.c rbtree.c -o bench_define
+ *     ./bench_define
+ */
+
+#include "rbtree.h"
+#include "rbtree_define.h"
+#include "bench/bench.h"
+
+typedef struct item {
+	uint64_t key;
+	rb_node_t node;
+} item_t;
+
+#define item_key(obj)										((obj)->key)
+#define item_cmp(l, r)										(((l) > (r)) - ((l) < (r)))
+RB_DEFINE_TREE(item_tree, item_t, node, item_key, item_cmp)
+
+static int cmp(const rb_node_t *left, const rb_node_t *right) {
+	uint64_t a = rb_entry(left, item_t, node)->key, b = rb_entry(right, item_t, node)->key;
+
+	return item_cmp(a, b);
+}
+
+/** Tree sizes to time. */
+static const size_t sizes[] = { 1000, 100000, 1000000 };
+
+/** Lookups per size, spread over as many passes through the keys as it takes. */
+#define LOOKUPS												20000000
+
+/**
+ * @brief Builds a tree of n random keys, then looks every key up until LOOKUPS is reached.
+ * @param[in] inlined Use the RB_DEFINE_TREE functions rather than the comparator-pointer API.
+ * @param[out] insert Time per insert.
+ * @param[out] find Time per find.
+ */
+static void measure(item_t *items, size_t n, bool inlined, double *insert, double *find) {
+	uint64_t seed = 0x853c49e6748fea9bull;
+	size_t passes = LOOKUPS / n;
+	uintptr_t sink = 0;
+	rb_tree_t tree;
+	double start, middle, end;
+
+	for (size_t i = 0; i < n; i++) items[i].key = bench_rand(&seed);
+	rb_tree_init(&tree);
+
+	start = bench_now();
+	if (inlined) for (size_t i = 0; i < n; i++) item_tree_insert(&tree, &items[i]);
+	else for (size_t i = 0; i < n; i++) rb_tree_insert(&tree, &items[i].node, cmp);
+	middle = bench_now();
+
+	for (size_t pass = 0; pass < passes; pass++) {
+		if (inlined) for (size_t i = 0; i < n; i++) sink += (uintptr_t) item_tree_find(&tree, items[i].key);
+		else for (size_t i = 0; i < n; i++) sink += (uintptr_t) rb_find(&tree, &items[i].node, cmp);
+	}
+	end = bench_now();
+
+	/* keeps the lookups from being optimized out */
+	if (!sink) fprintf(stderr, "no keys found\n");
+
+	*insert = (middle - start) / (double) n;
+	*find = (end - middle) / (double) (passes * n);
+}
+
+int main(void) {
+	printf("%-10s %14s %14s %14s %14s\n", "n", "insert fnptr", "insert inline", "find fnptr", "find inline");
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+		size_t n = sizes[s];
+		item_t *items = bench_alloc(n * sizeof(*items));
+		double insert[2] = { 1e30, 1e30 }, find[2] = { 1e30, 1e30 };
+
+		for (int run = 0; run < BENCH_RUNS; run++) {
+			for (int inlined = 0; inlined < 2; inlined++) {
+				double i, f;
+
+				measure(items, n, inlined, &i, &f);
+				if (i < insert[inlined]) insert[inlined] = i;
+				if (f < find[inlined]) find[inlined] = f;
+			}
+		}
+
+		printf("%-10zu %14.1f %14.1f %14.1f %14.1f\n", n, insert[0] * 1e9, insert[1] * 1e9, find[0] * 1e9, find[1] * 1e9);
+		free(items);
+	}
+
+	return 0;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file bench_delete.c
+ * @author krad2
+ * @brief Deleting by relinking nodes against the old way of copying a neighbor's payload over the target.
+ * @details rb_tree_delete_at swaps a two-child target with its successor by relinking pointers, so no payload ever
+ * moves. Before that, the predecessor's whole payload was copied into the target and the predecessor was unlinked
+ * instead; copy_delete below does exactly that on top of the public API, so both columns come from one build.
+ * Objects are laid out key, payload, node, and every tree holds n random keys. Two orders are timed: always
+ * deleting the root (every delete takes the two-child path), and deleting in random order.
+ *
+ *     cc -O2 -I. bench/bench_delete.c rbtree.c -o bench_delete
+ *     ./bench_delete [n = 1048576]
+ */
+
+#include "rbtree.h"
+#include "bench/bench.h"
+
+#include <string.h>
+
+/** Payload sizes to time. */
+static const size_t payloads[] = { 16, 64, 256, 1024 };
+
+/** Bytes from the start of an object to its key, payload and node. */
+#define KEY_AT												0
+#define PAYLOAD_AT											sizeof(uint64_t)
+#define node_at(payload)									(PAYLOAD_AT + (((payload) + sizeof(uintptr_t) - 1) & ~(sizeof(uintptr_t) - 1)))
+
+static size_t payload, stride;
+
+static inline char *object(rb_node_t *node) {
+	return (char *) node - node_at(payload);
+}
+
+static inline uint64_t key(const rb_node_t *node) {
+	uint64_t k;
+
+	memcpy(&k, (const char *) node - node_at(payload) + KEY_AT, sizeof(k));
+	return k;
+}
+
+static int cmp(const rb_node_t *left, const rb_node_t *right) {
+	uint64_t a = key(left), b = key(right);
+
+	return (a > b) - (a < b);
+}
+
+/**
+ * @brief The pre-relinking delete: a two-child target takes over its predecessor's key and payload, and the
+ * predecessor, which has at most one child, is unlinked in its place.
+ */
+static void copy_delete(rb_tree_t *tree, rb_node_t *target) {
+	if (rb_left(target) && rb_right(target)) {
+		rb_node_t *pred = (rb_node_t *) rb_prev(target);
+
+		memcpy(object(target), object(pred), node_at(payload));
+		target = pred;
+	}
+
+	rb_tree_delete_at(tree, target);
+}
+
+/**
+ * @brief Builds a tree of n objects with random keys, then times deleting all of them.
+ * @details Copying moves keys between objects, so random-order deletes look each key up first, through a probe
+ * object, in both columns.
+ * @param[in] root_first Delete whatever is at the root each time, rather than the keys in random order.
+ */
+static double run(char *objects, uint64_t *keys, size_t n, bool copying, bool root_first) {
+	uint64_t seed = 0x2545f4914f6cdd1dull;
+	char *probe = bench_alloc(stride);
+	rb_node_t *probe_node = (rb_node_t *) (probe + node_at(payload));
+	rb_tree_t tree;
+	double start, elapsed;
+
+	rb_tree_init(&tree);
+	for (size_t i = 0; i < n; i++) {
+		char *obj = objects + i * stride;
+
+		keys[i] = bench_rand(&seed);
+		memcpy(obj + KEY_AT, &keys[i], sizeof(keys[i]));
+		memset(obj + PAYLOAD_AT, (int) i, payload);
+		rb_tree_insert(&tree, (rb_node_t *) (obj + node_at(payload)), cmp);
+	}
+
+	for (size_t i = n; i > 1; i--) {
+		size_t j = bench_rand(&seed) % i;
+		uint64_t swap = keys[i - 1];
+
+		keys[i - 1] = keys[j];
+		keys[j] = swap;
+	}
+
+	start = bench_now();
+	if (root_first) {
+		while (!rb_is_empty(&tree)) {
+			if (copying) copy_delete(&tree, rb_root(&tree));
+			else rb_tree_delete_at(&tree, rb_root(&tree));
+		}
+	} else {
+		for (size_t i = 0; i < n; i++) {
+			rb_node_t *node;
+
+			memcpy(probe + KEY_AT, &keys[i], sizeof(keys[i]));
+			node = (rb_node_t *) rb_find(&tree, probe_node, cmp);
+
+			if (copying) copy_delete(&tree, node);
+			else rb_tree_delete_at(&tree, node);
+		}
+	}
+	elapsed = bench_now() - start;
+
+	free(probe);
+	return elapsed / (double) n;
+}
+
+static double best(char *objects, uint64_t *keys, size_t n, bool copying, bool root_first) {
+	double fastest = 1e30;
+
+	for (int i = 0; i < BENCH_RUNS; i++) {
+		double t = run(objects, keys, n, copying, root_first);
+
+		if (t < fastest) fastest = t;
+	}
+
+	return fastest;
+}
+
+int main(int argc, char **argv) {
+	size_t n = bench_arg(argc, argv, 1, (size_t) 1 << 20);
+	uint64_t *keys = bench_alloc(n * sizeof(*keys));
+
+	printf("n = %zu, ns per delete\n", n);
+	printf("%-8s %12s %12s %12s %12s\n", "payload", "root/copy", "root/relink", "random/copy", "random/relink");
+
+	for (size_t p = 0; p < sizeof(payloads) / sizeof(*payloads); p++) {
+		char *objects;
+
+		payload = payloads[p];
+		stride = node_at(payload) + sizeof(rb_node_t);
+		objects = bench_alloc(n * stride);
+
+		printf("%-8zu %12.1f %12.1f %12.1f %12.1f\n", payload,
+			best(objects, keys, n, true, true) * 1e9, best(objects, keys, n, false, true) * 1e9,
+			best(objects, keys, n, true, false) * 1e9, best(objects, keys, n, false, false) * 1e9);
+
+		free(objects);
+	}
+
+	free(keys);
+	return 0;
+}
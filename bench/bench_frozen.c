@@ -0,0 +1,126 @@
+/**
+ * @file bench_frozen.c
+ * @author krad2
+ * @brief Lower-bound lookups on a frozen snapshot, one at a time and batched, against rb_lower_bound and rb_find.
+ * @details A tree of n even keys is built over nodes scattered through memory, so that the pointer tree sees the
+ * cache misses a long-lived tree would, then frozen. Two million random queries, about half of them hits, are run
+ * through each lookup. Reported are the time to freeze and millions of lookups per second. The batch column is the
+ * scalar interleaved walk by default and the AVX2 gathers when built with -mavx2; the results are checked against
+ * rb_lower_bound either way.
+ *
+ *     cc -O2 -I. bench/bench_frozen.c rbtree.c rbtree_frozen.c -o bench_frozen
+ *     cc -O2 -mavx2 -I. bench/bench_frozen.c rbtree.c rbtree_frozen.c -o bench_frozen_avx2
+ *     ./bench_frozen [n = 1000000]
+ */
+
+#include "rbtree.h"
+#include "rbtree_frozen.h"
+#include "bench/bench.h"
+
+typedef struct item {
+	rb_node_t node;
+	uint64_t key;
+} item_t;
+
+/** Queries per lookup method. */
+#define QUERIES												2000000
+
+static int cmp(const rb_node_t *left, const rb_node_t *right) {
+	uint64_t a = rb_entry(left, item_t, node)->key, b = rb_entry(right, item_t, node)->key;
+
+	return (a > b) - (a < b);
+}
+
+static uint64_t key(const rb_node_t *node) {
+	return rb_entry(node, item_t, node)->key;
+}
+
+typedef enum method {
+	method_find = 0,
+	method_lower_bound = 1,
+	method_frozen = 2,
+	method_frozen_batch = 3
+} method_t;
+
+static const char *method_names[] = { "rb_find", "rb_lower_bound", "frozen", "frozen batch" };
+
+int main(int argc, char **argv) {
+	size_t n = bench_arg(argc, argv, 1, 1000000);
+	uint64_t seed = 0x9e3779b97f4a7c15ull;
+	item_t *items = bench_alloc(n * sizeof(*items));
+	rb_node_t **nodes = bench_alloc(n * sizeof(*nodes));
+	uint64_t *queries = bench_alloc(QUERIES * sizeof(*queries));
+	const rb_node_t **out = bench_alloc(QUERIES * sizeof(*out));
+	double best[4] = { 1e30, 1e30, 1e30, 1e30 }, start, freeze;
+	uintptr_t sink = 0;
+	rb_tree_t tree;
+	rb_frozen_t frozen;
+	item_t probe;
+
+	/* sorted keys, handed out to nodes in random order */
+	for (size_t i = 0; i < n; i++) nodes[i] = &items[i].node;
+	bench_shuffle((void **) nodes, n, &seed);
+	for (size_t i = 0; i < n; i++) rb_entry(nodes[i], item_t, node)->key = 2 * i;
+
+	rb_tree_init(&tree);
+	rb_tree_build_sorted(&tree, nodes, n);
+
+	for (size_t i = 0; i < QUERIES; i++) queries[i] = bench_rand(&seed) % (2 * n);
+
+	start = bench_now();
+	if (!rb_tree_freeze(&tree, key, &frozen)) {
+		fprintf(stderr, "out of memory freezing %zu nodes\n", n);
+		return 1;
+	}
+	freeze = bench_now() - start;
+
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		for (method_t method = method_find; method <= method_frozen_batch; method++) {
+			double elapsed;
+
+			start = bench_now();
+			if (method == method_find) {
+				for (size_t i = 0; i < QUERIES; i++) {
+					probe.key = queries[i];
+					sink += (uintptr_t) rb_find(&tree, &probe.node, cmp);
+				}
+			} else if (method == method_lower_bound) {
+				for (size_t i = 0; i < QUERIES; i++) {
+					probe.key = queries[i];
+					sink += (uintptr_t) rb_lower_bound(&tree, &probe.node, cmp);
+				}
+			} else if (method == method_frozen) {
+				for (size_t i = 0; i < QUERIES; i++) sink += (uintptr_t) rb_frozen_lower_bound(&frozen, queries[i]);
+			} else {
+				rb_frozen_lower_bound_batch(&frozen, queries, QUERIES, out);
+				sink += (uintptr_t) out[QUERIES / 2];
+			}
+			elapsed = bench_now() - start;
+
+			if (elapsed < best[method]) best[method] = elapsed;
+		}
+	}
+
+	for (size_t i = 0; i < QUERIES; i++) {
+		probe.key = queries[i];
+		if (out[i] != rb_lower_bound(&tree, &probe.node, cmp)) {
+			fprintf(stderr, "frozen batch disagrees with rb_lower_bound on %llu\n", (unsigned long long) queries[i]);
+			return 1;
+		}
+	}
+
+	/* keeps the lookups from being optimized out */
+	if (!sink) fprintf(stderr, "no lookups hit\n");
+
+	printf("n = %zu, %d queries, freeze %.1f ms\n", n, QUERIES, freeze * 1e3);
+	for (method_t method = method_find; method <= method_frozen_batch; method++) {
+		printf("%-16s %8.2f Mlookups/s\n", method_names[method], QUERIES / best[method] / 1e6);
+	}
+
+	rb_frozen_destroy(&frozen);
+	free(out);
+	free(queries);
+	free(nodes);
+	free(items);
+	return 0;
+}
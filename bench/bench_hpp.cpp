@@ -0,0 +1,128 @@
+/**
+ * @file bench_hpp.cpp
+ * @author krad2
+ * @brief rb::intrusive_tree against std::set and std::map over the same random keys.
+ * @details Trees of 1K, 100K and 1M random uint64 keys are built, every key is looked up again until about 10M
+ * lookups have been made, and the whole tree is walked in order. Times are ns per insert, per find and per element
+ * walked. The intrusive tree's objects are allocated up front, as they would be by their owner, so its inserts
+ * don't pay for an allocation and the std containers' do; that difference is part of what an intrusive tree buys.
+ *
+ *     cc -c -O2 -I. rbtree.c -o rbtree.o
+ *     c++ -std=c++17 -O2 -I. bench/bench_hpp.cpp rbtree.o -o bench_hpp
+ *     ./bench_hpp
+ */
+
+#include "rbtree.hpp"
+#include "bench/bench.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace {
+
+struct item {
+	uint64_t key;
+	rb_node_t node;
+};
+
+struct by_key {
+	using is_transparent = void;
+	bool operator()(const item &l, const item &r) const { return l.key < r.key; }
+	bool operator()(const item &l, uint64_t r) const { return l.key < r; }
+	bool operator()(uint64_t l, const item &r) const { return l < r.key; }
+};
+
+using tree_t = rb::intrusive_tree<item, &item::node, by_key>;
+
+/** Tree sizes to time. */
+const size_t sizes[] = { 1000, 100000, 1000000 };
+
+/** Lookups per size, spread over as many passes through the keys as it takes. */
+const size_t lookups = 10000000;
+
+/**
+ * @brief Times of one pass over each operation, per operation.
+ */
+struct timing {
+	double insert = 1e30, find = 1e30, walk = 1e30;
+
+	void keep_best(const timing &t) {
+		if (t.insert < insert) insert = t.insert;
+		if (t.find < find) find = t.find;
+		if (t.walk < walk) walk = t.walk;
+	}
+};
+
+/**
+ * @brief Inserts every key into a fresh container, looks them all up, then walks it, with the container's own
+ * insert, find and iteration.
+ */
+template <class Container, class Insert, class Found, class Value>
+timing measure(const std::vector<uint64_t> &keys, Insert insert, Found found, Value value) {
+	size_t n = keys.size(), passes = lookups / n, hits = 0;
+	uint64_t sum = 0;
+	Container container;
+	timing t;
+	double start;
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) insert(container, i);
+	t.insert = (bench_now() - start) / (double) n;
+
+	start = bench_now();
+	for (size_t pass = 0; pass < passes; pass++) {
+		for (size_t i = 0; i < n; i++) hits += found(container, keys[i]);
+	}
+	t.find = (bench_now() - start) / (double) (passes * n);
+
+	start = bench_now();
+	for (const auto &element : container) sum += value(element);
+	t.walk = (bench_now() - start) / (double) n;
+
+	if (hits != passes * n || !sum) fprintf(stderr, "lookups missed\n");
+	return t;
+}
+
+void report(const char *name, const timing &t) {
+	printf("%-10s %10s %10.1f %10.1f %10.1f\n", "", name, t.insert * 1e9, t.find * 1e9, t.walk * 1e9);
+}
+
+} // namespace
+
+int main() {
+	printf("%-10s %10s %10s %10s %10s\n", "n", "", "insert", "find", "walk");
+
+	for (size_t n : sizes) {
+		std::vector<uint64_t> keys(n);
+		std::vector<item> items(n);
+		uint64_t seed = 0x9e3779b97f4a7c15ull;
+		timing intrusive, set, map;
+
+		for (size_t i = 0; i < n; i++) keys[i] = items[i].key = bench_rand(&seed);
+
+		for (int run = 0; run < BENCH_RUNS; run++) {
+			intrusive.keep_best(measure<tree_t>(keys,
+				[&](tree_t &tree, size_t i) { tree.insert(items[i]); },
+				[](tree_t &tree, uint64_t key) { return tree.find(key) != tree.end(); },
+				[](const item &obj) { return obj.key; }));
+
+			set.keep_best(measure<std::set<uint64_t>>(keys,
+				[&](std::set<uint64_t> &s, size_t i) { s.insert(keys[i]); },
+				[](std::set<uint64_t> &s, uint64_t key) { return s.find(key) != s.end(); },
+				[](uint64_t key) { return key; }));
+
+			map.keep_best(measure<std::map<uint64_t, uint64_t>>(keys,
+				[&](std::map<uint64_t, uint64_t> &m, size_t i) { m.emplace(keys[i], i); },
+				[](std::map<uint64_t, uint64_t> &m, uint64_t key) { return m.find(key) != m.end(); },
+				[](const std::pair<const uint64_t, uint64_t> &entry) { return entry.first; }));
+		}
+
+		printf("%zu\n", n);
+		report("intrusive", intrusive);
+		report("std::set", set);
+		report("std::map", map);
+	}
+
+	return 0;
+}
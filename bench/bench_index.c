@@ -0,0 +1,157 @@
+/**
+ * @file bench_index.c
+ * @author krad2
+ * @brief Memory and speed of the 32-bit index tree against the pointer tree, with a 4-byte key.
+ * @details n elements with random uint32 keys are inserted, looked up by a million keys drawn from the tree, walked
+ * in order and deleted, first as pointer-tree elements and then as index-tree elements in one flat array. Reported
+ * are the element array's size and ns per operation.
+ *
+ *     cc -O2 -I. bench/bench_index.c rbtree.c rbtree_index.c -o bench_index
+ *     ./bench_index [n = 1000000]
+ */
+
+#include "rbtree.h"
+#include "rbtree_index.h"
+#include "bench/bench.h"
+
+#include <stddef.h>
+
+typedef struct pointer_item {
+	rb_node_t node;
+	uint32_t key;
+} pointer_item_t;
+
+typedef struct index_item {
+	uint32_t key;
+	rb_index_node_t node;
+} index_item_t;
+
+/** Lookups timed per tree. */
+#define LOOKUPS												1000000
+
+static int pointer_cmp(const rb_node_t *left, const rb_node_t *right) {
+	uint32_t a = rb_entry(left, pointer_item_t, node)->key, b = rb_entry(right, pointer_item_t, node)->key;
+
+	return (a > b) - (a < b);
+}
+
+static int index_cmp(const rb_index_node_t *left, const rb_index_node_t *right) {
+	uint32_t a = container_of(left, index_item_t, node)->key, b = container_of(right, index_item_t, node)->key;
+
+	return (a > b) - (a < b);
+}
+
+/**
+ * @brief Times of one pass over each operation, per operation.
+ */
+typedef struct timing {
+	double insert, find, scan, delete;
+} timing_t;
+
+static void keep_best(timing_t *best, const timing_t *t) {
+	if (t->insert < best->insert) best->insert = t->insert;
+	if (t->find < best->find) best->find = t->find;
+	if (t->scan < best->scan) best->scan = t->scan;
+	if (t->delete < best->delete) best->delete = t->delete;
+}
+
+static void pointer_run(pointer_item_t *items, const uint32_t *keys, const uint32_t *probes, size_t n, timing_t *t) {
+	rb_tree_t tree;
+	pointer_item_t probe;
+	size_t found = 0;
+	uint64_t sum = 0;
+	double start;
+
+	for (size_t i = 0; i < n; i++) items[i].key = keys[i];
+	rb_tree_init(&tree);
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) rb_tree_insert(&tree, &items[i].node, pointer_cmp);
+	t->insert = (bench_now() - start) / (double) n;
+
+	start = bench_now();
+	for (size_t i = 0; i < LOOKUPS; i++) {
+		probe.key = probes[i];
+		found += rb_find(&tree, &probe.node, pointer_cmp) != NULL;
+	}
+	t->find = (bench_now() - start) / LOOKUPS;
+
+	start = bench_now();
+	for (const rb_node_t *node = rb_first(&tree); node; node = rb_next((rb_iterator_t) node)) sum += rb_entry(node, pointer_item_t, node)->key;
+	t->scan = (bench_now() - start) / (double) n;
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) rb_tree_delete_at(&tree, &items[i].node);
+	t->delete = (bench_now() - start) / (double) n;
+
+	if (found != LOOKUPS || !sum) fprintf(stderr, "pointer tree lost keys\n");
+}
+
+static void index_run(index_item_t *items, const uint32_t *keys, const uint32_t *probes, size_t n, timing_t *t) {
+	rb_index_tree_t tree;
+	index_item_t probe;
+	size_t found = 0;
+	uint64_t sum = 0;
+	double start;
+
+	for (size_t i = 0; i < n; i++) items[i].key = keys[i];
+	rb_index_tree_init(&tree, items, sizeof(*items), offsetof(index_item_t, node));
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) rb_index_tree_insert(&tree, (rb_index_t) i, index_cmp);
+	t->insert = (bench_now() - start) / (double) n;
+
+	start = bench_now();
+	for (size_t i = 0; i < LOOKUPS; i++) {
+		probe.key = probes[i];
+		found += rb_index_find(&tree, &probe.node, index_cmp) != RB_INDEX_NIL;
+	}
+	t->find = (bench_now() - start) / LOOKUPS;
+
+	start = bench_now();
+	for (rb_index_t i = rb_index_first(&tree); i != RB_INDEX_NIL; i = rb_index_next(&tree, i)) sum += items[i].key;
+	t->scan = (bench_now() - start) / (double) n;
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) rb_index_tree_delete_at(&tree, (rb_index_t) i);
+	t->delete = (bench_now() - start) / (double) n;
+
+	if (found != LOOKUPS || !sum) fprintf(stderr, "index tree lost keys\n");
+}
+
+static void report(const char *name, size_t bytes, const timing_t *t) {
+	printf("%-8s %8.1f %8.1f %8.1f %8.1f %8.1f\n", name, (double) bytes / (1 << 20),
+		t->insert * 1e9, t->find * 1e9, t->scan * 1e9, t->delete * 1e9);
+}
+
+int main(int argc, char **argv) {
+	size_t n = bench_arg(argc, argv, 1, 1000000);
+	uint64_t seed = 0x9e3779b97f4a7c15ull;
+	uint32_t *keys = bench_alloc(n * sizeof(*keys)), *probes = bench_alloc(LOOKUPS * sizeof(*probes));
+	pointer_item_t *pointer_items = bench_alloc(n * sizeof(*pointer_items));
+	index_item_t *index_items = bench_alloc(n * sizeof(*index_items));
+	timing_t pointer = { 1e30, 1e30, 1e30, 1e30 }, index = { 1e30, 1e30, 1e30, 1e30 };
+
+	for (size_t i = 0; i < n; i++) keys[i] = (uint32_t) bench_rand(&seed);
+	for (size_t i = 0; i < LOOKUPS; i++) probes[i] = keys[bench_rand(&seed) % n];
+
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		timing_t t;
+
+		pointer_run(pointer_items, keys, probes, n, &t);
+		keep_best(&pointer, &t);
+		index_run(index_items, keys, probes, n, &t);
+		keep_best(&index, &t);
+	}
+
+	printf("n = %zu, element size: pointer %zu B, index %zu B; ns per operation\n", n, sizeof(pointer_item_t), sizeof(index_item_t));
+	printf("%-8s %8s %8s %8s %8s %8s\n", "", "MB", "insert", "find", "scan", "delete");
+	report("pointer", n * sizeof(pointer_item_t), &pointer);
+	report("index", n * sizeof(index_item_t), &index);
+
+	free(index_items);
+	free(pointer_items);
+	free(probes);
+	free(keys);
+	return 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file bench_insert_delete.c
+ * @author krad2
+ * @brief Insert and delete throughput on large trees of random keys.
+ * @details Every node is inserted, then every node is deleted in insertion order, and both passes are reported in
+ * millions of operations per second. Each size on the command line is timed in turn. For the numbers from before the
+ * rotations kept the root current, build the same file against the rbtree.c and rbtree.h of that time:
+ *
+ *     cc -O2 -I. bench/bench_insert_delete.c rbtree.c -o bench_insert_delete
+ *     ./bench_insert_delete [n = 1000000 10000000 ...]
+ *
+ *     mkdir old && git show 6e99b0c^:rbtree.c > old/rbtree.c && git show 6e99b0c^:rbtree.h > old/rbtree.h
+ *     cc -O2 -Iold -I. bench/bench_insert_delete.c old/rbtree.c -o bench_insert_delete_old
+ */
+
+#include "rbtree.h"
+#include "bench/bench.h"
+
+typedef struct item {
+	uint64_t key;
+	rb_node_t node;
+} item_t;
+
+static int cmp(const rb_node_t *left, const rb_node_t *right) {
+	uint64_t a = rb_entry(left, item_t, node)->key, b = rb_entry(right, item_t, node)->key;
+
+	return (a > b) - (a < b);
+}
+
+int main(int argc, char **argv) {
+	static const size_t defaults[] = { 1000000, 10000000 };
+	size_t sizes = (argc > 1) ? (size_t) (argc - 1) : sizeof(defaults) / sizeof(*defaults);
+
+	printf("%-12s %14s %14s\n", "n", "insert Mops/s", "delete Mops/s");
+
+	for (size_t s = 0; s < sizes; s++) {
+		size_t n = (argc > 1) ? bench_arg(argc, argv, (int) s + 1, 0) : defaults[s];
+		item_t *items = bench_alloc(n * sizeof(*items));
+		double insert = 1e30, delete = 1e30;
+
+		for (int run = 0; run < BENCH_RUNS; run++) {
+			uint64_t seed = 0x9e3779b97f4a7c15ull;
+			rb_tree_t tree;
+			double start, middle, end;
+
+			for (size_t i = 0; i < n; i++) items[i].key = bench_rand(&seed);
+			rb_tree_init(&tree);
+
+			start = bench_now();
+			for (size_t i = 0; i < n; i++) rb_tree_insert(&tree, &items[i].node, cmp);
+			middle = bench_now();
+			for (size_t i = 0; i < n; i++) rb_tree_delete_at(&tree, &items[i].node);
+			end = bench_now();
+
+			if (middle - start < insert) insert = middle - start;
+			if (end - middle < delete) delete = end - middle;
+		}
+
+		printf("%-12zu %14.2f %14.2f\n", n, (double) n / insert / 1e6, (double) n / delete / 1e6);
+		free(items);
+	}
+
+	return 0;
+}
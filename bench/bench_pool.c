@@ -0,0 +1,138 @@
+/**
+ * @file bench_pool.c
+ * @author krad2
+ * @brief In-order scans and lookups over malloc'd nodes, pooled nodes, and pooled nodes after rb_pool_compact.
+ * @details The same n random keys are put in four trees: one malloc per object, interleaved with other allocations
+ * of random sizes the way a long-running program's heap would be; objects from an rb_pool_t, in insertion order; and
+ * that pool's tree after compacting it in in-order and then breadth-first order. Each is walked once end to end with
+ * rb_next and searched with rb_find for a million keys drawn from the tree. Reported are ns per node scanned, ns per
+ * lookup, and how long each compaction took.
+ *
+ *     cc -O2 -I. bench/bench_pool.c rbtree.c rbtree_pool.c -o bench_pool
+ *     ./bench_pool [n = 1000000]
+ */
+
+#include "rbtree.h"
+#include "rbtree_pool.h"
+#include "bench/bench.h"
+
+#include <stddef.h>
+
+typedef struct item {
+	rb_node_t node;
+	uint64_t key;
+	char payload[32];
+} item_t;
+
+/** Lookups timed per tree. */
+#define LOOKUPS												1000000
+
+static int cmp(const rb_node_t *left, const rb_node_t *right) {
+	uint64_t a = rb_entry(left, item_t, node)->key, b = rb_entry(right, item_t, node)->key;
+
+	return (a > b) - (a < b);
+}
+
+/**
+ * @brief Times a full scan and LOOKUPS finds on a tree, best of BENCH_RUNS, and prints them.
+ */
+static void measure(const char *name, const rb_tree_t *tree, const uint64_t *probes, size_t n) {
+	double scan = 1e30, find = 1e30;
+
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		uint64_t sum = 0;
+		size_t found = 0;
+		item_t probe;
+		double start, elapsed;
+
+		start = bench_now();
+		for (const rb_node_t *node = rb_first(tree); node; node = rb_next((rb_iterator_t) node)) sum += rb_entry(node, item_t, node)->key;
+		elapsed = bench_now() - start;
+		if (elapsed < scan) scan = elapsed;
+
+		start = bench_now();
+		for (size_t i = 0; i < LOOKUPS; i++) {
+			probe.key = probes[i];
+			found += rb_find(tree, &probe.node, cmp) != NULL;
+		}
+		elapsed = bench_now() - start;
+		if (elapsed < find) find = elapsed;
+
+		if (found != LOOKUPS || !sum) fprintf(stderr, "%s lost keys\n", name);
+	}
+
+	printf("%-24s %12.1f %12.1f\n", name, scan / (double) n * 1e9, find / LOOKUPS * 1e9);
+}
+
+int main(int argc, char **argv) {
+	size_t n = bench_arg(argc, argv, 1, 1000000);
+	uint64_t seed = 0x9e3779b97f4a7c15ull;
+	uint64_t *keys = bench_alloc(n * sizeof(*keys)), *probes = bench_alloc(LOOKUPS * sizeof(*probes));
+	item_t **scattered = bench_alloc(n * sizeof(*scattered));
+	void **other = bench_alloc(n * sizeof(*other));
+	rb_tree_t tree;
+	rb_pool_t pool;
+	double start, inorder, breadth_first;
+
+	for (size_t i = 0; i < n; i++) keys[i] = bench_rand(&seed);
+	for (size_t i = 0; i < LOOKUPS; i++) probes[i] = keys[bench_rand(&seed) % n];
+
+	printf("n = %zu, %zu-byte objects\n", n, sizeof(item_t));
+	printf("%-24s %12s %12s\n", "", "scan ns", "find ns");
+
+	rb_tree_init(&tree);
+	for (size_t i = 0; i < n; i++) {
+		scattered[i] = bench_alloc(sizeof(item_t));
+		scattered[i]->key = keys[i];
+		rb_tree_insert(&tree, &scattered[i]->node, cmp);
+		other[i] = bench_alloc(16 + bench_rand(&seed) % 200);
+	}
+
+	measure("malloc", &tree, probes, n);
+
+	for (size_t i = 0; i < n; i++) {
+		free(other[i]);
+		free(scattered[i]);
+	}
+
+	rb_pool_init(&pool, sizeof(item_t), offsetof(item_t, node), 0);
+	rb_tree_init(&tree);
+	for (size_t i = 0; i < n; i++) {
+		item_t *obj = rb_pool_alloc(&pool);
+
+		if (!obj) {
+			fprintf(stderr, "out of memory\n");
+			return 1;
+		}
+
+		obj->key = keys[i];
+		rb_tree_insert(&tree, &obj->node, cmp);
+	}
+
+	measure("pool", &tree, probes, n);
+
+	start = bench_now();
+	if (!rb_pool_compact(&pool, &tree, rb_pool_inorder, NULL, NULL)) {
+		fprintf(stderr, "out of memory compacting\n");
+		return 1;
+	}
+	inorder = bench_now() - start;
+	measure("pool, in-order", &tree, probes, n);
+
+	start = bench_now();
+	if (!rb_pool_compact(&pool, &tree, rb_pool_breadth_first, NULL, NULL)) {
+		fprintf(stderr, "out of memory compacting\n");
+		return 1;
+	}
+	breadth_first = bench_now() - start;
+	measure("pool, breadth-first", &tree, probes, n);
+
+	printf("compaction took %.1f ms in-order, %.1f ms breadth-first\n", inorder * 1e3, breadth_first * 1e3);
+
+	rb_pool_destroy(&pool);
+	free(other);
+	free(scattered);
+	free(probes);
+	free(keys);
+	return 0;
+}
@@ -0,0 +1,200 @@
+/**
+ * @file bench_pqueue.c
+ * @author krad2
+ * @brief The min-cached tree as an event queue, popping with rb_lcached_pop_min and rb_lcached_pop_until, against
+ * an array-backed binary heap.
+ * @details The "hold" model: the queue starts full of events, and every operation takes the earliest one off and
+ * re-arms it up to a million ticks later. The heap stores pointers and orders them through a function-pointer
+ * comparator, the same as the tree does. Four ways of running the queue are timed:
+ *
+ * - delete: unlink the cached min with rb_tree_lcached_delete_at and reinsert it;
+ * - pop_min: the same with rb_lcached_pop_min;
+ * - pop_until: advance the clock a hundred ticks at a time, draining everything due with rb_lcached_pop_until and
+ *   re-arming each event from its callback;
+ * - heap: pop the top of the heap and push it back.
+ *
+ * Times are ns per event re-armed.
+ *
+ *     cc -O2 -I. bench/bench_pqueue.c rbtree.c -o bench_pqueue
+ *     ./bench_pqueue [operations = 5000000]
+ */
+
+#include "rbtree.h"
+#include "bench/bench.h"
+
+typedef struct event {
+	uint64_t when;
+	rb_node_t node;
+} event_t;
+
+typedef enum method {
+	method_delete = 0,
+	method_pop_min = 1,
+	method_pop_until = 2,
+	method_heap = 3
+} method_t;
+
+static const char *method_names[] = { "delete", "pop_min", "pop_until", "heap" };
+
+/** Queue sizes to time. */
+static const size_t sizes[] = { 10000, 1000000 };
+
+/** Events are re-armed between 1 and this many ticks later. */
+#define SPREAD												1000000
+
+static int cmp(const rb_node_t *left, const rb_node_t *right) {
+	uint64_t a = rb_entry(left, event_t, node)->when, b = rb_entry(right, event_t, node)->when;
+
+	return (a > b) - (a < b);
+}
+
+/**
+ * @struct heap
+ * @brief Array-backed binary min-heap of event pointers.
+ */
+typedef struct heap {
+	event_t **slots;
+	size_t n;
+	int (*cmp)(const event_t *left, const event_t *right);
+} heap_t;
+
+static int heap_cmp(const event_t *left, const event_t *right) {
+	return (left->when > right->when) - (left->when < right->when);
+}
+
+/* read through a volatile so the compiler can't see which comparator the heap calls and inline it */
+static int (*volatile heap_order)(const event_t *left, const event_t *right) = heap_cmp;
+
+static void heap_push(heap_t *heap, event_t *event) {
+	size_t i = heap->n++;
+
+	while (i) {
+		size_t parent = (i - 1) / 2;
+
+		if (heap->cmp(heap->slots[parent], event) <= 0) break;
+		heap->slots[i] = heap->slots[parent];
+		i = parent;
+	}
+
+	heap->slots[i] = event;
+}
+
+static event_t *heap_pop(heap_t *heap) {
+	event_t *top = heap->slots[0], *last = heap->slots[--heap->n];
+	size_t i = 0;
+
+	for (;;) {
+		size_t child = 2 * i + 1;
+
+		if (child >= heap->n) break;
+		if (child + 1 < heap->n && heap->cmp(heap->slots[child + 1], heap->slots[child]) < 0) child++;
+		if (heap->cmp(last, heap->slots[child]) <= 0) break;
+
+		heap->slots[i] = heap->slots[child];
+		i = child;
+	}
+
+	heap->slots[i] = last;
+	return top;
+}
+
+/* what rb_lcached_pop_until's callback needs to re-arm an event */
+static rb_tree_lcached_t *rearm_tree;
+static uint64_t rearm_now, rearm_seed;
+static size_t rearmed;
+
+static void rearm(rb_node_t *node) {
+	event_t *event = rb_entry(node, event_t, node);
+
+	event->when = rearm_now + 1 + bench_rand(&rearm_seed) % SPREAD;
+	rb_tree_lcached_insert(rearm_tree, node, cmp);
+	rearmed++;
+}
+
+/**
+ * @brief Fills a queue with n events and times ops re-arms through it, returning the time per re-arm.
+ */
+static double run(method_t method, event_t *events, size_t n, heap_t *heap, size_t ops) {
+	uint64_t seed = 0x2545f4914f6cdd1dull;
+	rb_tree_lcached_t tree;
+	double start;
+
+	rb_tree_lcached_init(&tree);
+	heap->n = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		events[i].when = bench_rand(&seed) % SPREAD;
+		if (method == method_heap) heap_push(heap, &events[i]);
+		else rb_tree_lcached_insert(&tree, &events[i].node, cmp);
+	}
+
+	start = bench_now();
+	if (method == method_pop_until) {
+		event_t key;
+
+		rearm_tree = &tree;
+		rearm_seed = seed;
+		rearmed = 0;
+
+		for (rearm_now = 0; rearmed < ops; rearm_now += 100) {
+			key.when = rearm_now;
+			rb_lcached_pop_until(&tree, &key.node, cmp, rearm);
+		}
+
+		return (bench_now() - start) / (double) rearmed;
+	}
+
+	for (size_t op = 0; op < ops; op++) {
+		event_t *event;
+
+		if (method == method_heap) {
+			event = heap_pop(heap);
+		} else if (method == method_pop_min) {
+			event = rb_entry(rb_lcached_pop_min(&tree), event_t, node);
+		} else {
+			event = rb_entry(tree.min, event_t, node);
+			rb_tree_lcached_delete_at(&tree, tree.min, cmp);
+		}
+
+		event->when += 1 + bench_rand(&seed) % SPREAD;
+
+		if (method == method_heap) heap_push(heap, event);
+		else rb_tree_lcached_insert(&tree, &event->node, cmp);
+	}
+
+	return (bench_now() - start) / (double) ops;
+}
+
+int main(int argc, char **argv) {
+	size_t ops = bench_arg(argc, argv, 1, 5000000);
+
+	printf("%zu operations, ns per event re-armed\n", ops);
+	printf("%-10s", "events");
+	for (method_t method = method_delete; method <= method_heap; method++) printf(" %12s", method_names[method]);
+	printf("\n");
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); s++) {
+		size_t n = sizes[s];
+		event_t *events = bench_alloc(n * sizeof(*events));
+		heap_t heap = { .slots = bench_alloc(n * sizeof(*heap.slots)), .n = 0, .cmp = heap_order };
+
+		printf("%-10zu", n);
+		for (method_t method = method_delete; method <= method_heap; method++) {
+			double best = 1e30;
+
+			for (int r = 0; r < BENCH_RUNS; r++) {
+				double t = run(method, events, n, &heap, ops);
+
+				if (t < best) best = t;
+			}
+
+			printf(" %12.1f", best * 1e9);
+		}
+		printf("\n");
+
+		free(heap.slots);
+		free(events);
+	}
+
+	return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file bench_prefix.c
+ * @author krad2
+ * @brief Prefix-first descents against the plain comparator, for integer and string keys.
+ * @details Each key set is inserted into a plain tree with rb_tree_insert and looked up with rb_find, then inserted
+ * into a second tree with rb_prefix_tree_insert and looked up with rb_prefix_find, over the same objects. The key
+ * sets are:
+ *
+ * - uint64: the key sits a cache line past the node, like a typical payload, and the prefix holds all of it, so the
+ *   prefix tree needs no comparator at all;
+ * - strings: 20 random hex characters each, allocated separately and compared with strcmp;
+ * - "user:" strings: the same, but every key starts with the same 5 bytes, leaving 3 useful bytes in the prefix.
+ *
+ * Lookups are two million hits at random. Times are ns per operation.
+ *
+ *     cc -O2 -I. bench/bench_prefix.c rbtree.c rbtree_prefix.c -o bench_prefix
+ *     ./bench_prefix [n = 1000000]
+ */
+
+#include "rbtree.h"
+#include "rbtree_prefix.h"
+#include "bench/bench.h"
+
+#include <string.h>
+
+typedef struct number {
+	rb_prefix_node_t node;
+	char payload[64];
+	uint64_t key;
+} number_t;
+
+typedef struct name {
+	rb_prefix_node_t node;
+	char *key;
+} name_t;
+
+/** Lookups timed per tree. */
+#define LOOKUPS												2000000
+
+static int number_cmp(const rb_node_t *left, const rb_node_t *right) {
+	uint64_t a = rb_entry(rb_prefix_entry(left), number_t, node)->key, b = rb_entry(rb_prefix_entry(right), number_t, node)->key;
+
+	return (a > b) - (a < b);
+}
+
+static int name_cmp(const rb_node_t *left, const rb_node_t *right) {
+	return strcmp(rb_entry(rb_prefix_entry(left), name_t, node)->key, rb_entry(rb_prefix_entry(right), name_t, node)->key);
+}
+
+/**
+ * @brief Best insert and find times of both trees over the same prefix nodes.
+ * @param[in] nodes Nodes with their prefixes set.
+ * @param[in] probes Indices into nodes to look up.
+ * @param[in] cmp Comparator for the plain tree.
+ * @param[in] prefix_cmp Comparator for prefix ties, or NULL if the prefix is the whole key.
+ * @param[out] times Plain insert, prefix insert, plain find and prefix find, per operation.
+ */
+static void measure(rb_prefix_node_t **nodes, size_t n, const size_t *probes,
+	int (*cmp)(const rb_node_t *left, const rb_node_t *right),
+	int (*prefix_cmp)(const rb_node_t *left, const rb_node_t *right), double times[4]) {
+	for (int i = 0; i < 4; i++) times[i] = 1e30;
+
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		for (int prefix = 0; prefix < 2; prefix++) {
+			rb_tree_t tree;
+			size_t found = 0;
+			double start, insert, find;
+
+			rb_tree_init(&tree);
+
+			start = bench_now();
+			if (prefix) for (size_t i = 0; i < n; i++) rb_prefix_tree_insert(&tree, nodes[i], prefix_cmp);
+			else for (size_t i = 0; i < n; i++) rb_tree_insert(&tree, &nodes[i]->node, cmp);
+			insert = (bench_now() - start) / (double) n;
+
+			start = bench_now();
+			if (prefix) for (size_t i = 0; i < LOOKUPS; i++) found += rb_prefix_find(&tree, nodes[probes[i]], prefix_cmp) != NULL;
+			else for (size_t i = 0; i < LOOKUPS; i++) found += rb_find(&tree, &nodes[probes[i]]->node, cmp) != NULL;
+			find = (bench_now() - start) / LOOKUPS;
+
+			if (found != LOOKUPS) fprintf(stderr, "lookups missed\n");
+
+			if (insert < times[prefix]) times[prefix] = insert;
+			if (find < times[2 + prefix]) times[2 + prefix] = find;
+		}
+	}
+}
+
+static void report(const char *name, const double times[4]) {
+	printf("%-16s %12.1f %12.1f %12.1f %12.1f\n", name, times[0] * 1e9, times[1] * 1e9, times[2] * 1e9, times[3] * 1e9);
+}
+
+int main(int argc, char **argv) {
+	size_t n = bench_arg(argc, argv, 1, 1000000);
+	uint64_t seed = 0x9e3779b97f4a7c15ull;
+	rb_prefix_node_t **nodes = bench_alloc(n * sizeof(*nodes));
+	size_t *probes = bench_alloc(LOOKUPS * sizeof(*probes));
+	number_t *numbers = bench_alloc(n * sizeof(*numbers));
+	name_t *names = bench_alloc(n * sizeof(*names));
+	double times[4];
+
+	for (size_t i = 0; i < LOOKUPS; i++) probes[i] = bench_rand(&seed) % n;
+
+	printf("n = %zu, ns per operation\n", n);
+	printf("%-16s %12s %12s %12s %12s\n", "keys", "insert", "prefix", "find", "prefix");
+
+	for (size_t i = 0; i < n; i++) {
+		numbers[i].key = bench_rand(&seed);
+		numbers[i].node.prefix = rb_prefix_of_uint64(numbers[i].key);
+		nodes[i] = &numbers[i].node;
+	}
+
+	measure(nodes, n, probes, number_cmp, NULL, times);
+	report("uint64", times);
+
+	for (int shared = 0; shared < 2; shared++) {
+		for (size_t i = 0; i < n; i++) {
+			names[i].key = bench_alloc(32);
+			if (shared) snprintf(names[i].key, 32, "user:%016llx", (unsigned long long) bench_rand(&seed));
+			else snprintf(names[i].key, 32, "%016llx%04x", (unsigned long long) bench_rand(&seed), (unsigned) (bench_rand(&seed) & 0xffff));
+
+			names[i].node.prefix = rb_prefix_of_string(names[i].key);
+			nodes[i] = &names[i].node;
+		}
+
+		measure(nodes, n, probes, name_cmp, name_cmp, times);
+		report(shared ? "\"user:\" strings" : "strings", times);
+
+		for (size_t i = 0; i < n; i++) free(names[i].key);
+	}
+
+	free(names);
+	free(numbers);
+	free(probes);
+	free(nodes);
+	return 0;
+}
@@ -0,0 +1,191 @@
+/**
+ * @file bench_set.c
+ * @author krad2
+ * @brief Union, intersection and difference against an insert loop, and how they scale across threads.
+ * @details Two trees of unique random keys are bulk-built from sorted arrays, with half of b's keys also in a. Each
+ * set operation runs on the calling thread alone, then through an rb_fork_pool_t with 1, 2, 4, ... cores (the caller
+ * plus cores - 1 workers), up to the given maximum. Every result is checked against a merge of the sorted key arrays.
+ *
+ *     cc -O2 -pthread -I. bench/bench_set.c rbtree.c rbtree_fork.c -o bench_set
+ *     ./bench_set [n = 2000000] [m = n] [max cores = 64]
+ */
+
+#include "rbtree.h"
+#include "rbtree_fork.h"
+#include "bench/bench.h"
+
+typedef struct item {
+	rb_node_t node;
+	uint64_t key;
+} item_t;
+
+typedef enum op {
+	op_union = 0,
+	op_intersect = 1,
+	op_difference = 2
+} op_t;
+
+static const char *op_names[] = { "union", "intersect", "difference" };
+
+static int cmp(const rb_node_t *left, const rb_node_t *right) {
+	uint64_t a = rb_entry(left, item_t, node)->key, b = rb_entry(right, item_t, node)->key;
+
+	return (a > b) - (a < b);
+}
+
+/**
+ * @brief Sorts and dedupes keys in place, returning how many are left.
+ */
+static size_t unique(uint64_t *keys, size_t n) {
+	size_t out = 0;
+
+	qsort(keys, n, sizeof(*keys), bench_cmp_u64);
+	for (size_t i = 0; i < n; i++) {
+		if (!out || keys[out - 1] != keys[i]) keys[out++] = keys[i];
+	}
+
+	return out;
+}
+
+/**
+ * @brief Builds a tree over items holding the sorted keys.
+ */
+static void build(rb_tree_t *tree, item_t *items, rb_node_t **nodes, const uint64_t *keys, size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		items[i].key = keys[i];
+		nodes[i] = &items[i].node;
+	}
+
+	rb_tree_init(tree);
+	rb_tree_build_sorted(tree, nodes, n);
+}
+
+/**
+ * @brief Size of the result each operation should leave in a, from a merge of the two key arrays.
+ */
+static size_t expected(op_t op, const uint64_t *a, size_t n, const uint64_t *b, size_t m) {
+	size_t i = 0, j = 0, both = 0;
+
+	while (i < n && j < m) {
+		if (a[i] < b[j]) i++;
+		else if (a[i] > b[j]) j++;
+		else {
+			both++;
+			i++;
+			j++;
+		}
+	}
+
+	if (op == op_union) return n + m - both;
+	if (op == op_intersect) return both;
+	return n - both;
+}
+
+static size_t count(const rb_tree_t *tree) {
+	size_t n = 0;
+
+	for (const rb_node_t *node = rb_is_empty(tree) ? NULL : rb_first(tree); node; node = rb_next((rb_iterator_t) node)) n++;
+	return n;
+}
+
+typedef struct setup {
+	const uint64_t *a_keys, *b_keys;
+	size_t n, m;
+	item_t *a_items, *b_items;
+	rb_node_t **nodes;
+} setup_t;
+
+/**
+ * @brief Best time of BENCH_RUNS runs of one operation, with fresh trees every run. Exits if a result is wrong.
+ */
+static double measure(const setup_t *s, op_t op, const rb_fork_t *fork) {
+	double best = 1e30;
+
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		rb_tree_t a, b;
+		double start, elapsed;
+
+		build(&a, s->a_items, s->nodes, s->a_keys, s->n);
+		build(&b, s->b_items, s->nodes, s->b_keys, s->m);
+
+		start = bench_now();
+		if (op == op_union) rb_tree_union(&a, &b, cmp, NULL, fork);
+		else if (op == op_intersect) rb_tree_intersect(&a, &b, cmp, NULL, fork);
+		else rb_tree_difference(&a, &b, cmp, NULL, fork);
+		elapsed = bench_now() - start;
+		if (elapsed < best) best = elapsed;
+
+		if (count(&a) != expected(op, s->a_keys, s->n, s->b_keys, s->m)) {
+			fprintf(stderr, "%s gave the wrong number of nodes\n", op_names[op]);
+			exit(1);
+		}
+	}
+
+	return best;
+}
+
+int main(int argc, char **argv) {
+	size_t n = bench_arg(argc, argv, 1, 2000000), m = bench_arg(argc, argv, 2, n), cores = bench_arg(argc, argv, 3, 64);
+	uint64_t seed = 0x9e3779b97f4a7c15ull, *a_keys = bench_alloc(n * sizeof(*a_keys)), *b_keys = bench_alloc(m * sizeof(*b_keys));
+	setup_t s;
+	double start, elapsed, loop = 1e30;
+
+	for (size_t i = 0; i < n; i++) a_keys[i] = bench_rand(&seed);
+	for (size_t i = 0; i < m; i++) b_keys[i] = (i & 1) ? bench_rand(&seed) : a_keys[bench_rand(&seed) % n];
+	n = unique(a_keys, n);
+	m = unique(b_keys, m);
+
+	s.a_keys = a_keys;
+	s.b_keys = b_keys;
+	s.n = n;
+	s.m = m;
+	s.a_items = bench_alloc(n * sizeof(*s.a_items));
+	s.b_items = bench_alloc(m * sizeof(*s.b_items));
+	s.nodes = bench_alloc(((n > m) ? n : m) * sizeof(*s.nodes));
+
+	/* what the set operations replace: pull each node out of b and insert it into a */
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		rb_tree_t a, b;
+
+		build(&a, s.a_items, s.nodes, a_keys, n);
+		build(&b, s.b_items, s.nodes, b_keys, m);
+
+		start = bench_now();
+		while (!rb_is_empty(&b)) {
+			rb_node_t *node = (rb_node_t *) rb_first(&b);
+
+			rb_tree_delete_at(&b, node);
+			rb_tree_insert_unique(&a, node, cmp, NULL);
+		}
+		elapsed = bench_now() - start;
+		if (elapsed < loop) loop = elapsed;
+	}
+
+	printf("n = %zu, m = %zu\n", n, m);
+	printf("insert loop (union)        %9.1f ms\n", loop * 1e3);
+
+	for (op_t op = op_union; op <= op_difference; op++) printf("%-10s sequential      %9.1f ms\n", op_names[op], measure(&s, op, NULL) * 1e3);
+
+	printf("\n%-6s %12s %12s %12s\n", "cores", "union", "intersect", "difference");
+	for (size_t c = 1; c <= cores; c *= 2) {
+		rb_fork_pool_t pool;
+
+		if (!rb_fork_pool_init(&pool, c - 1)) {
+			fprintf(stderr, "couldn't start %zu workers\n", c - 1);
+			return 1;
+		}
+
+		printf("%-6zu", c);
+		for (op_t op = op_union; op <= op_difference; op++) printf(" %9.1f ms", measure(&s, op, &pool.fork) * 1e3);
+		printf("\n");
+
+		rb_fork_pool_destroy(&pool);
+	}
+
+	free(s.nodes);
+	free(s.b_items);
+	free(s.a_items);
+	free(b_keys);
+	free(a_keys);
+	return 0;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file bench_slim.c
+ * @author krad2
+ * @brief Memory and speed of the parent-less slim tree against rb_tree_t, with an 8-byte key.
+ * @details n elements with random uint64 keys are inserted, looked up by a million keys drawn from the tree, walked
+ * in order, and finally deleted by search in random order, first as rb_tree_t elements and then as slim elements.
+ * Reported are the element array's size and ns per operation.
+ *
+ *     cc -O2 -I. bench/bench_slim.c rbtree.c rbtree_slim.c -o bench_slim
+ *     ./bench_slim [n = 1000000]
+ */
+
+#include "rbtree.h"
+#include "rbtree_slim.h"
+#include "bench/bench.h"
+
+typedef struct pointer_item {
+	rb_node_t node;
+	uint64_t key;
+} pointer_item_t;
+
+typedef struct slim_item {
+	rb_slim_node_t node;
+	uint64_t key;
+} slim_item_t;
+
+/** Lookups timed per tree. */
+#define LOOKUPS												1000000
+
+static int pointer_cmp(const rb_node_t *left, const rb_node_t *right) {
+	uint64_t a = rb_entry(left, pointer_item_t, node)->key, b = rb_entry(right, pointer_item_t, node)->key;
+
+	return (a > b) - (a < b);
+}
+
+static int slim_cmp(const rb_slim_node_t *left, const rb_slim_node_t *right) {
+	uint64_t a = container_of(left, slim_item_t, node)->key, b = container_of(right, slim_item_t, node)->key;
+
+	return (a > b) - (a < b);
+}
+
+/**
+ * @brief Times of one pass over each operation, per operation.
+ */
+typedef struct timing {
+	double insert, find, scan, delete;
+} timing_t;
+
+static void keep_best(timing_t *best, const timing_t *t) {
+	if (t->insert < best->insert) best->insert = t->insert;
+	if (t->find < best->find) best->find = t->find;
+	if (t->scan < best->scan) best->scan = t->scan;
+	if (t->delete < best->delete) best->delete = t->delete;
+}
+
+static void pointer_run(pointer_item_t *items, const uint64_t *keys, const uint64_t *probes, const size_t *order,
+	size_t n, timing_t *t) {
+	rb_tree_t tree;
+	pointer_item_t probe;
+	size_t found = 0;
+	uint64_t sum = 0;
+	double start;
+
+	for (size_t i = 0; i < n; i++) items[i].key = keys[i];
+	rb_tree_init(&tree);
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) rb_tree_insert(&tree, &items[i].node, pointer_cmp);
+	t->insert = (bench_now() - start) / (double) n;
+
+	start = bench_now();
+	for (size_t i = 0; i < LOOKUPS; i++) {
+		probe.key = probes[i];
+		found += rb_find(&tree, &probe.node, pointer_cmp) != NULL;
+	}
+	t->find = (bench_now() - start) / LOOKUPS;
+
+	start = bench_now();
+	for (const rb_node_t *node = rb_first(&tree); node; node = rb_next((rb_iterator_t) node)) sum += rb_entry(node, pointer_item_t, node)->key;
+	t->scan = (bench_now() - start) / (double) n;
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) rb_tree_delete(&tree, &items[order[i]].node, pointer_cmp);
+	t->delete = (bench_now() - start) / (double) n;
+
+	if (found != LOOKUPS || !sum || !rb_is_empty(&tree)) fprintf(stderr, "pointer tree lost keys\n");
+}
+
+static void slim_run(slim_item_t *items, const uint64_t *keys, const uint64_t *probes, const size_t *order,
+	size_t n, timing_t *t) {
+	rb_slim_tree_t tree;
+	rb_slim_iter_t iter;
+	slim_item_t probe;
+	size_t found = 0, deleted = 0;
+	uint64_t sum = 0;
+	double start;
+
+	for (size_t i = 0; i < n; i++) items[i].key = keys[i];
+	rb_slim_tree_init(&tree);
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) rb_slim_tree_insert(&tree, &items[i].node, slim_cmp);
+	t->insert = (bench_now() - start) / (double) n;
+
+	start = bench_now();
+	for (size_t i = 0; i < LOOKUPS; i++) {
+		probe.key = probes[i];
+		found += rb_slim_find(&tree, &probe.node, slim_cmp) != NULL;
+	}
+	t->find = (bench_now() - start) / LOOKUPS;
+
+	start = bench_now();
+	for (const rb_slim_node_t *node = rb_slim_first(&tree, &iter); node; node = rb_slim_next(&iter)) sum += container_of(node, slim_item_t, node)->key;
+	t->scan = (bench_now() - start) / (double) n;
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) deleted += rb_slim_tree_delete(&tree, &items[order[i]].node, slim_cmp);
+	t->delete = (bench_now() - start) / (double) n;
+
+	if (found != LOOKUPS || !sum || deleted != n || tree.root) fprintf(stderr, "slim tree lost keys\n");
+}
+
+static void report(const char *name, size_t bytes, const timing_t *t) {
+	printf("%-8s %8.1f %8.1f %8.1f %8.1f %8.1f\n", name, (double) bytes / (1 << 20),
+		t->insert * 1e9, t->find * 1e9, t->scan * 1e9, t->delete * 1e9);
+}
+
+int main(int argc, char **argv) {
+	size_t n = bench_arg(argc, argv, 1, 1000000);
+	uint64_t seed = 0x9e3779b97f4a7c15ull;
+	uint64_t *keys = bench_alloc(n * sizeof(*keys)), *probes = bench_alloc(LOOKUPS * sizeof(*probes));
+	size_t *order = bench_alloc(n * sizeof(*order));
+	pointer_item_t *pointer_items = bench_alloc(n * sizeof(*pointer_items));
+	slim_item_t *slim_items = bench_alloc(n * sizeof(*slim_items));
+	timing_t pointer = { 1e30, 1e30, 1e30, 1e30 }, slim = { 1e30, 1e30, 1e30, 1e30 };
+
+	for (size_t i = 0; i < n; i++) {
+		keys[i] = bench_rand(&seed);
+		order[i] = i;
+	}
+
+	for (size_t i = n; i > 1; i--) {
+		size_t j = bench_rand(&seed) % i, swap = order[i - 1];
+
+		order[i - 1] = order[j];
+		order[j] = swap;
+	}
+
+	for (size_t i = 0; i < LOOKUPS; i++) probes[i] = keys[bench_rand(&seed) % n];
+
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		timing_t t;
+
+		pointer_run(pointer_items, keys, probes, order, n, &t);
+		keep_best(&pointer, &t);
+		slim_run(slim_items, keys, probes, order, n, &t);
+		keep_best(&slim, &t);
+	}
+
+	printf("n = %zu, element size: pointer %zu B, slim %zu B; ns per operation\n", n, sizeof(pointer_item_t), sizeof(slim_item_t));
+	printf("%-8s %8s %8s %8s %8s %8s\n", "", "MB", "insert", "find", "scan", "delete");
+	report("pointer", n * sizeof(pointer_item_t), &pointer);
+	report("slim", n * sizeof(slim_item_t), &slim);
+
+	free(slim_items);
+	free(pointer_items);
+	free(order);
+	free(probes);
+	free(keys);
+	return 0;
+}
@@ -0,0 +1,183 @@
+/**
+ * @file bench_timer.c
+ * @author krad2
+ * @brief rb_timer against a hashed timer wheel under two kinds of timer churn.
+ * @details The wheel has one-tick slots, each a circular doubly linked list, so add and cancel are O(1); a timer more
+ * than a lap out stays in its slot until its lap comes round. Both run the same operations on the same number of
+ * timers, with the clock advancing one tick every ten operations:
+ *
+ * - idle timeouts: every timer is armed far out, and each operation pushes a random one further out again, the way a
+ *   connection's idle timeout is reset on activity;
+ * - retransmits: each operation cancels a random timer if it's pending and otherwise arms it a few hundred ticks out.
+ *   With the defaults a timer is picked again only every 20000 ticks or so, so most of them fire.
+ *
+ * Times are ns per operation, with how many timers fired as a check that both did the same work.
+ *
+ *     cc -O2 -I. bench/bench_timer.c rbtree.c rbtree_timer.c -o bench_timer
+ *     ./bench_timer [timers = 200000] [operations = 10000000]
+ */
+
+#include "rbtree_timer.h"
+#include "bench/bench.h"
+
+/** Slots in the wheel, one per tick. */
+#define WHEEL_SLOTS											4096
+
+typedef struct wheel_timer {
+	struct wheel_timer *next;
+	struct wheel_timer *prev;
+	uint64_t expires;
+	bool pending;
+} wheel_timer_t;
+
+typedef struct wheel {
+	wheel_timer_t slots[WHEEL_SLOTS];
+	uint64_t now;
+} wheel_t;
+
+typedef enum load {
+	load_idle = 0,
+	load_retransmit = 1
+} load_t;
+
+static const char *load_names[] = { "idle timeouts", "retransmits" };
+
+static size_t fired;
+
+static void wheel_init(wheel_t *wheel) {
+	for (size_t i = 0; i < WHEEL_SLOTS; i++) wheel->slots[i].next = wheel->slots[i].prev = &wheel->slots[i];
+	wheel->now = 0;
+}
+
+static void wheel_add(wheel_t *wheel, wheel_timer_t *timer, uint64_t expires) {
+	wheel_timer_t *head = &wheel->slots[expires % WHEEL_SLOTS];
+
+	timer->expires = expires;
+	timer->next = head->next;
+	timer->prev = head;
+	head->next->prev = timer;
+	head->next = timer;
+	timer->pending = true;
+}
+
+static bool wheel_cancel(wheel_timer_t *timer) {
+	if (!timer->pending) return false;
+
+	timer->prev->next = timer->next;
+	timer->next->prev = timer->prev;
+	timer->pending = false;
+	return true;
+}
+
+/**
+ * @brief Walks every slot up to now, firing whatever in it is due and leaving timers for later laps in place.
+ */
+static void wheel_expire(wheel_t *wheel, uint64_t now) {
+	for (; wheel->now <= now; wheel->now++) {
+		wheel_timer_t *head = &wheel->slots[wheel->now % WHEEL_SLOTS];
+
+		for (wheel_timer_t *timer = head->next, *next; timer != head; timer = next) {
+			next = timer->next;
+			if (timer->expires <= now) {
+				wheel_cancel(timer);
+				fired++;
+			}
+		}
+	}
+}
+
+static void fire(rb_timer_t *timer) {
+	(void) timer;
+	fired++;
+}
+
+/**
+ * @brief Runs one load against one implementation, returning the time per operation.
+ * @param[in] tree Use rb_timer rather than the wheel.
+ */
+static double run(load_t load, bool tree, wheel_t *wheel, wheel_timer_t *wheel_timers, rb_timer_base_t *base,
+	rb_timer_t *timers, size_t n, size_t ops) {
+	uint64_t seed = 0x2545f4914f6cdd1dull, now = 0;
+	double start;
+
+	fired = 0;
+	wheel_init(wheel);
+	rb_timer_base_init(base);
+	for (size_t i = 0; i < n; i++) {
+		wheel_timers[i].pending = false;
+		rb_timer_init(&timers[i], fire);
+	}
+
+	if (load == load_idle) {
+		for (size_t i = 0; i < n; i++) {
+			uint64_t expires = 30000 + bench_rand(&seed) % 1000;
+
+			if (tree) rb_timer_add(base, &timers[i], expires);
+			else wheel_add(wheel, &wheel_timers[i], expires);
+		}
+	}
+
+	start = bench_now();
+	for (size_t op = 0; op < ops; op++) {
+		size_t i = bench_rand(&seed) % n;
+
+		if (load == load_idle) {
+			uint64_t expires = now + 30000 + bench_rand(&seed) % 1000;
+
+			if (tree) {
+				rb_timer_modify(base, &timers[i], expires);
+			} else {
+				wheel_cancel(&wheel_timers[i]);
+				wheel_add(wheel, &wheel_timers[i], expires);
+			}
+		} else {
+			uint64_t expires = now + 200 + bench_rand(&seed) % 200;
+
+			if (tree) {
+				if (!rb_timer_cancel(base, &timers[i])) rb_timer_add(base, &timers[i], expires);
+			} else {
+				if (!wheel_cancel(&wheel_timers[i])) wheel_add(wheel, &wheel_timers[i], expires);
+			}
+		}
+
+		if (op % 10 == 9) {
+			now++;
+			if (tree) rb_timer_expire(base, now);
+			else wheel_expire(wheel, now);
+		}
+	}
+
+	return (bench_now() - start) / (double) ops;
+}
+
+int main(int argc, char **argv) {
+	size_t n = bench_arg(argc, argv, 1, 200000), ops = bench_arg(argc, argv, 2, 10000000);
+	wheel_t *wheel = bench_alloc(sizeof(*wheel));
+	wheel_timer_t *wheel_timers = bench_alloc(n * sizeof(*wheel_timers));
+	rb_timer_t *timers = bench_alloc(n * sizeof(*timers));
+	rb_timer_base_t base;
+
+	printf("%zu timers, %zu operations, ns per operation\n", n, ops);
+	printf("%-14s %12s %10s %12s %10s\n", "", "wheel", "fired", "rb_timer", "fired");
+
+	for (load_t load = load_idle; load <= load_retransmit; load++) {
+		double best[2] = { 1e30, 1e30 };
+		size_t count[2];
+
+		for (int r = 0; r < BENCH_RUNS; r++) {
+			for (int tree = 0; tree < 2; tree++) {
+				double t = run(load, tree, wheel, wheel_timers, &base, timers, n, ops);
+
+				if (t < best[tree]) best[tree] = t;
+				count[tree] = fired;
+			}
+		}
+
+		printf("%-14s %12.1f %10zu %12.1f %10zu\n", load_names[load], best[0] * 1e9, count[0], best[1] * 1e9, count[1]);
+	}
+
+	free(timers);
+	free(wheel_timers);
+	free(wheel);
+	return 0;
+}
@@ -6,7 +6,7 @@
  * @see https://en.wikipedia.org/wiki/Red%E2%80%93black_tree
  */
 
-#include "rbtree.h"
+#include "rbtree_augmented.h"
 
 /** 
  * @defgroup rb_check Helper pointer check macros
@@ -93,8 +93,7 @@ static inline void __rb_set_parent(rb_node_t *rb, rb_node_t *parent) {
 	if (rb) rb->__rb_parent_color = rb_color(rb) | ((uintptr_t) parent);
 }
 
-static inline void __rb_replace_child(rb_node_t *root, rb_node_t *old, rb_node_t *nw) {
-    RB_NULL_CHECK(root);
+static inline void __rb_replace_child(rb_tree_t *tree, rb_node_t *root, rb_node_t *old, rb_node_t *nw) {
     RB_NULL_CHECK(old);
 
 	if (root) {
@@ -102,7 +101,9 @@ static inline void __rb_replace_child(rb_node_t *root, rb_node_t *old, rb_node_t
 		/* Links 'new' in place of 'old' on the side of 'root' that 'old' was on. */
 		if (rb_left(root) == old) rb_left(root) = nw;
     	else if (rb_right(root) == old) rb_right(root) = nw;
-	}
+
+	/* 'old' had no parent, so 'new' is the tree's root now. */
+	} else rb_root(tree) = nw;
 
 	__rb_set_parent(nw, root);
 }
@@ -121,7 +122,10 @@ static inline void __rb_set_parent_and_color(rb_node_t *rb, rb_node_t *parent, r
  * @{
  */
 
-static inline void __rb_left_rotate(rb_node_t *root) {
+/**
+ * @brief Rotates the subtree at root to the left, moving the tree's root along with it if needed.
+ */
+static inline void __rb_left_rotate(rb_tree_t *tree, rb_node_t *root, const rb_augment_t *aug) {
     rb_node_t *upper_root, *pivot;
 
     upper_root = rb_parent(root); 					/** 'master tree' containing the subtree being rotated */
@@ -134,10 +138,15 @@ static inline void __rb_left_rotate(rb_node_t *root) {
     __rb_set_parent(rb_left(pivot), pivot);
 
     __rb_set_parent(pivot, upper_root);				/** update the subtree's connection to the master */
-    __rb_replace_child(upper_root, root, pivot);
+    __rb_replace_child(tree, upper_root, root, pivot);
+
+	if (aug) aug->rotate(root, pivot);				/** the pivot now spans what the old root did */
 }
 
-static inline void __rb_right_rotate(rb_node_t *root) {
+/**
+ * @brief Rotates the subtree at root to the right, moving the tree's root along with it if needed.
+ */
+static inline void __rb_right_rotate(rb_tree_t *tree, rb_node_t *root, const rb_augment_t *aug) {
     rb_node_t *upper_root, *pivot;
 
     upper_root = rb_parent(root);					/** 'master tree' containing the subtree being rotated */
@@ -150,7 +159,9 @@ static inline void __rb_right_rotate(rb_node_t *root) {
     __rb_set_parent(rb_right(pivot), pivot);
 
     __rb_set_parent(pivot, upper_root);				/** update the subtree's connection to the master */
-    __rb_replace_child(upper_root, root, pivot);
+    __rb_replace_child(tree, upper_root, root, pivot);
+
+	if (aug) aug->rotate(root, pivot);				/** the pivot now spans what the old root did */
 }
 
 /** @} */
@@ -290,8 +301,10 @@ static inline void __rb_insert_basic(rb_node_t *root, rb_node_t *node, int (*cmp
 
 /**
  * @brief Performs rb_insert_fixup on node, correcting all subtrees above it.
+ * @details Rotations update the tree's root in place, so no walk back up is needed afterwards.
+ * @return True if a red root had to be blackened, i.e. the tree's black height grew by one.
  */
-static inline void __rb_insert_rebalance(rb_node_t *node) {
+static inline bool __rb_insert_rebalance(rb_tree_t *tree, rb_node_t *node, const rb_augment_t *aug) {
     rb_node_t *parent, *uncle, *grandparent;
 
     for (;;) {
@@ -301,18 +314,20 @@ static inline void __rb_insert_rebalance(rb_node_t *node) {
 
 		/* hitting the root means we're done - make sure it's black afterwards */
         if (parent == NULL) {
+			bool grew = rb_is_red(node);
+
 			__rb_set_black(node);
-            return;
+            return grew;
         }
 
 		/* if the node we've hit is black then our the invariant is re-satisfied */
 		if (rb_is_black(node)) {
-			return;
+			return false;
 		}
 
 		/* same thing as above, but needed for 0 - 1 nodes to prevent a segfault. */
 		if (rb_is_black(parent)) {
-			return;
+			return false;
 		}
 
 		/* try a recolor first */
@@ -327,7 +342,7 @@ static inline void __rb_insert_rebalance(rb_node_t *node) {
 		/* left-left */
 		if ((parent == rb_left(grandparent)) && (node == rb_left(parent))) {
 			__rb_swap_colors(parent, grandparent);
-   			__rb_right_rotate(grandparent);
+   			__rb_right_rotate(tree, grandparent, aug);
 		}
 
 		/* left-right */
@@ -335,7 +350,7 @@ static inline void __rb_insert_rebalance(rb_node_t *node) {
 			rb_node_t *center, *center_parent, *center_grandparent;
 
 			/* convert it to the left-left case */
-			__rb_left_rotate(parent); 
+			__rb_left_rotate(tree, parent, aug); 
 
 			/**
 			 * Our frame of reference has changed, so reestablish it for the LL transform. 
@@ -347,13 +362,13 @@ static inline void __rb_insert_rebalance(rb_node_t *node) {
 			center_grandparent = rb_parent(center_parent);
 
 			__rb_swap_colors(center_parent, center_grandparent);
-   			__rb_right_rotate(center_grandparent);
+   			__rb_right_rotate(tree, center_grandparent, aug);
 		}
 
 		/* right-right */
 		else if ((parent == rb_right(grandparent)) && (node == rb_right(parent))) {
 			__rb_swap_colors(parent, grandparent);
-    		__rb_left_rotate(grandparent);
+    		__rb_left_rotate(tree, grandparent, aug);
 		}
 
 		/* right-left */
@@ -361,7 +376,7 @@ static inline void __rb_insert_rebalance(rb_node_t *node) {
 			rb_node_t *center, *center_parent, *center_grandparent;
 
 			/* convert it to the right-right case */
-			__rb_right_rotate(parent);
+			__rb_right_rotate(tree, parent, aug);
 
 			/**
 			 * Our frame of reference has changed, so reestablish it for the RR transform. 
@@ -373,7 +388,7 @@ static inline void __rb_insert_rebalance(rb_node_t *node) {
 			center_grandparent = rb_parent(center_parent);
 
 			__rb_swap_colors(center_parent, center_grandparent);
-    		__rb_left_rotate(center_grandparent);
+    		__rb_left_rotate(tree, center_grandparent, aug);
 		}
 
 		/* move to the next level after rebalancing the current one */
@@ -381,6 +396,19 @@ static inline void __rb_insert_rebalance(rb_node_t *node) {
     }
 }
 
+/**
+ * @brief Hangs node off of one of the tree's ends, at the empty slot on its outer side, and rebalances from there.
+ * @details Only the new leaf's path up to the root can need fixing, and the fixup is amortized O(1), so this skips the descent entirely.
+ * @param[in] tree Tree the end belongs to.
+ * @param[in] edge The tree's cached min or max.
+ * @param[in] link The edge's left slot if it's the min, or its right slot if it's the max.
+ * @param[in] node Node to insert.
+ */
+static inline void __rb_insert_edge(rb_tree_t *tree, rb_node_t *edge, rb_node_t **link, rb_node_t *node) {
+	rb_link_node(node, edge, link);
+	__rb_insert_rebalance(tree, node, NULL);
+}
+
 /**
  * @fn rb_tree_insert_at
  * @brief Inserts a node into an rb_tree as close as possible to and after the provided iterator.
@@ -407,12 +435,13 @@ void rb_tree_insert_at(rb_tree_t *tree, rb_node_t *node, rb_iterator_t hint, int
 	/** 
 	 * then check the right edge, and see if it suggests that the node is appropriately placed.
 	 * a NULL right edge is fine, that just means we are appending to the right edge of the tree.
+	 * an equal successor is not: equal keys go after each other, and the tree's cached max relies on that.
 	 */
-	int hint_right_cmp = next_pos ? cmp((const rb_node_t *) next_pos, (const rb_node_t *) node) : 0;
+	int hint_right_cmp = next_pos ? cmp((const rb_node_t *) next_pos, (const rb_node_t *) node) : 1;
 
 	/* we default to a standard root-anchored insert if the hint is bad. */
 	bool hint_is_less = (hint_left_cmp < 0);
-	bool hint_successor_is_more = (hint_right_cmp >= 0);
+	bool hint_successor_is_more = (hint_right_cmp > 0);
 	bool hint_is_valid = hint_is_less && hint_successor_is_more;
 	if (hint_is_valid) {
 
@@ -421,17 +450,7 @@ void rb_tree_insert_at(rb_tree_t *tree, rb_node_t *node, rb_iterator_t hint, int
 
 		/* insert it starting from the hint */
 		__rb_insert_basic(hint, node, cmp);
-		__rb_insert_rebalance(node);
-
-		/** 
-		 * 'node' (and possibly the whole tree have since been nodified 
-		 * so we trace 'node' back up to find the new root, and then save that 
-		 */
-		while (rb_parent(node) != NULL) {
-			node = rb_parent(node);
-		}
-
-		rb_root(tree) = node;
+		__rb_insert_rebalance(tree, node, NULL);
 	} else rb_tree_insert(tree, node, cmp);
 }
 
@@ -451,7 +470,7 @@ void rb_tree_lcached_insert_at(rb_tree_lcached_t *tree, rb_node_t *node, rb_iter
 	RB_NULL_CHECK(cmp);
 
 	/* subsequent inserts may be smaller, so we update the min accordingly */ 
-    if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_min(tree)) <= 0) rb_min(tree) = node;
+    if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_min(tree)) < 0) rb_min(tree) = node;
 
 	rb_tree_insert_at(tree, node, hint, cmp);
 }
@@ -493,7 +512,7 @@ void rb_tree_lrcached_insert_at(rb_tree_lrcached_t *tree, rb_node_t *node, rb_it
 	RB_NULL_CHECK(cmp);
 
 	/* subsequent inserts may be smaller, so we update the min accordingly */ 
-    if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_min(tree)) <= 0) rb_min(tree) = node;
+    if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_min(tree)) < 0) rb_min(tree) = node;
 
 	/* subsequent inserts may be bigger, so update the max accordingly */
 	if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_max(tree)) >= 0) rb_max(tree) = node;
@@ -501,6 +520,19 @@ void rb_tree_lrcached_insert_at(rb_tree_lrcached_t *tree, rb_node_t *node, rb_it
 	rb_tree_insert_at(tree, node, hint, cmp);
 } 
 
+/**
+ * @fn rb_insert_color
+ * @brief Rebalances the tree after a node has been linked in with rb_link_node.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Freshly linked node.
+ */
+void rb_insert_color(rb_tree_t *tree, rb_node_t *node) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(node);
+
+	__rb_insert_rebalance(tree, node, NULL);
+}
+
 /**
  * @fn rb_tree_insert
  * @brief Inserts a node into an rb_tree, guided by a comparator.
@@ -515,6 +547,7 @@ void rb_tree_insert(rb_tree_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t
 
 	/* base case, tree is empty so we just initialize the root node to this one */
     if (rb_is_empty(tree)) {
+		__rb_node_init(node);
         rb_root(tree) = node;
         __rb_set_parent_and_color(rb_root(tree), NULL, RB_BLACK);
 
@@ -524,17 +557,7 @@ void rb_tree_insert(rb_tree_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t
 		/* the node needs to be fresh and must not come in corrupted */
 		__rb_node_init(node);
 		__rb_insert_basic(rb_root(tree), node, cmp);
-		__rb_insert_rebalance(node);
-
-		/** 
-		 * 'node' (and possibly the whole tree have since been nodified 
-		 * so we trace 'node' back up to find the new root, and then save that 
-		 */
-		while (rb_parent(node) != NULL) {
-			node = rb_parent(node);
-		}
-
-		rb_root(tree) = node;
+		__rb_insert_rebalance(tree, node, NULL);
 	}
 }
 
@@ -551,12 +574,20 @@ void rb_tree_lcached_insert(rb_tree_lcached_t *tree, rb_node_t *node, int (*cmp)
 	RB_NULL_CHECK(cmp);
 
 	/* base case of no nodes means that the first is also the min */
-    if (rb_is_empty(tree)) rb_min(tree) = node; 
+    if (rb_is_empty(tree)) {
+		rb_min(tree) = node;
+		rb_tree_insert((rb_tree_t *) tree, node, cmp);
+		return;
+	}
 
-	/* subsequent inserts may be smaller, so we update the min accordingly */ 
-    if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_min(tree)) <= 0) rb_min(tree) = node;
+	/* a new min goes right under the old one, since the min never has a left child (equal keys go to the right of it) */
+    if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_min(tree)) < 0) {
+		__rb_insert_edge((rb_tree_t *) tree, rb_min(tree), &rb_left(rb_min(tree)), node);
+		rb_min(tree) = node;
+		return;
+	}
 
-	/* then we do a standard insert */
+	/* otherwise we do a standard insert */
     rb_tree_insert((rb_tree_t *) tree, node, cmp);
 }
 
@@ -573,12 +604,20 @@ void rb_tree_rcached_insert(rb_tree_rcached_t *tree, rb_node_t *node, int (*cmp)
 	RB_NULL_CHECK(cmp);
 	
 	/* base case of no nodes means that the first is also the max */
-	if (rb_is_empty(tree)) rb_max(tree) = node;
+	if (rb_is_empty(tree)) {
+		rb_max(tree) = node;
+		rb_tree_insert((rb_tree_t *) tree, node, cmp);
+		return;
+	}
 
-	/* subsequent inserts may be bigger, so update the max accordingly */
-	if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_max(tree)) >= 0) rb_max(tree) = node;
+	/* a new max goes right under the old one, since the max never has a right child */
+	if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_max(tree)) >= 0) {
+		__rb_insert_edge((rb_tree_t *) tree, rb_max(tree), &rb_right(rb_max(tree)), node);
+		rb_max(tree) = node;
+		return;
+	}
 
-	/* then we do a standard insert */
+	/* otherwise we do a standard insert */
     rb_tree_insert((rb_tree_t *) tree, node, cmp);
 }
 
@@ -598,425 +637,1838 @@ void rb_tree_lrcached_insert(rb_tree_lrcached_t *tree, rb_node_t *node, int (*cm
 	if (rb_is_empty(tree)) {
 		rb_min(tree) = node;
 		rb_max(tree) = node;
+		rb_tree_insert((rb_tree_t *) tree, node, cmp);
+		return;
 	}
 
-	/* subsequent inserts may change these cached values, so update as needed */
-	if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_min(tree)) <= 0) rb_min(tree) = node;
-	if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_max(tree)) >= 0) rb_max(tree) = node;
+	/* appends are checked first, since ascending keys are the common case for a tree that caches both ends */
+	if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_max(tree)) >= 0) {
+		__rb_insert_edge((rb_tree_t *) tree, rb_max(tree), &rb_right(rb_max(tree)), node);
+		rb_max(tree) = node;
+		return;
+	}
 
-	rb_tree_insert(tree, node, cmp);
+	if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_min(tree)) < 0) {
+		__rb_insert_edge((rb_tree_t *) tree, rb_min(tree), &rb_left(rb_min(tree)), node);
+		rb_min(tree) = node;
+		return;
+	}
+
+	rb_tree_insert((rb_tree_t *) tree, node, cmp);
 }
 
 /** @} */
 
 /**
- * @defgroup rb_deletion Red-black tree deletion functions (and helpers)
+ * @defgroup rb_unique Insertion that rejects duplicate keys.
  * @{
  */
 
 /**
- * @brief Finds the first element greater than the target node.
+ * @brief Descends once looking for node's key, linking node in at the leaf it ends on if the key isn't there.
+ * @param[out] leftmost Set if node went in as the new minimum, i.e. the descent never turned right.
+ * @param[out] rightmost Set if node went in as the new maximum, i.e. the descent never turned left.
+ * @return The node with an equal key, or NULL if node was inserted.
  */
-static inline const rb_node_t *__rb_node_successor(const rb_node_t *target) {
-	RB_NULL_CHECK(target, NULL);
-	rb_node_t *successor;
+static inline rb_node_t *__rb_insert_unique(rb_tree_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), bool *leftmost, bool *rightmost) {
+	rb_node_t **link = &rb_root(tree);
+	rb_node_t *parent = NULL;
+
+	*leftmost = true;
+	*rightmost = true;
+
+	while (*link) {
+		int comparison = cmp((const rb_node_t *) node, (const rb_node_t *) *link);
+
+		parent = *link;
+		if (comparison < 0) {
+			link = &rb_left(parent);
+			*rightmost = false;
+		} else if (comparison > 0) {
+			link = &rb_right(parent);
+			*leftmost = false;
+		} else return parent;
+	}
 
-	/* if the target is not a leaf node, the one right after is the successor */
-	if (rb_left(target) && rb_right(target)) {
-		successor = (rb_node_t *) rb_next((rb_iterator_t) target);
+	/* the slot the descent fell out of is exactly where the node goes */
+	rb_link_node(node, parent, link);
+	__rb_insert_rebalance(tree, node, NULL);
+	return NULL;
+}
+
+/* --- */
 
-	/* if there is 1 child, that's always the successor */
-	} else if (!rb_right(target)) {
-		successor = rb_left(target);
-	} else if (!rb_left(target)) {
-		successor = rb_right(target);
+/**
+ * @fn rb_tree_insert_unique
+ * @brief Inserts a node into an rb_tree unless a node with an equal key is already there, in a single descent.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Pointer to an rb_node instance embedded in something else.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ * @param[out] existing If not NULL, set to the node that blocked the insert, or NULL if node went in.
+ * @return True if node was inserted, false if an equal key was found instead.
+ */
+bool rb_tree_insert_unique(rb_tree_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_node_t **existing) {
+	RB_NULL_CHECK(tree, false);
+	RB_NULL_CHECK(node, false);
+	RB_NULL_CHECK(cmp, false);
 
-	/* no children means there's no replacement for you and you just get deleted */
-	} else {
-		successor = NULL;
-	}
+	bool leftmost, rightmost;
+	rb_node_t *found = __rb_insert_unique(tree, node, cmp, &leftmost, &rightmost);
 
-    return successor;
+	if (existing) *existing = found;
+	return !found;
 }
 
 /**
- * @brief Finds the first element greater than the target node.
+ * @fn rb_tree_lcached_insert_unique
+ * @brief Same as rb_tree_insert_unique, keeping the cached min current.
  */
-static inline const rb_node_t *__rb_node_predecessor(const rb_node_t *target) {
-	RB_NULL_CHECK(target, NULL);
-	rb_node_t *successor;
+bool rb_tree_lcached_insert_unique(rb_tree_lcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_node_t **existing) {
+	RB_NULL_CHECK(tree, false);
+	RB_NULL_CHECK(node, false);
+	RB_NULL_CHECK(cmp, false);
 
-	/* if the target is not a leaf node, the one right before is the successor */
-	if (rb_left(target) && rb_right(target)) {
-		successor = (rb_node_t *) rb_prev((rb_iterator_t) target);
-
-	/* if there is 1 child, that's always the successor */
-	} else if (!rb_right(target)) {
-		successor = rb_left(target);
-	} else if (!rb_left(target)) {
-		successor = rb_right(target);
+	bool leftmost, rightmost;
+	rb_node_t *found = __rb_insert_unique((rb_tree_t *) tree, node, cmp, &leftmost, &rightmost);
 
-	/* no children means there's no replacement for you and you just get deleted */
-	} else {
-		successor = NULL;
-	}
+	/* the descent already told us whether the node landed on the left edge, so no extra comparison is needed */
+	if (!found && leftmost) rb_min(tree) = node;
 
-    return successor;
+	if (existing) *existing = found;
+	return !found;
 }
 
 /**
- * @brief Deletes a node by connecting its subtrees to its parent.
+ * @fn rb_tree_rcached_insert_unique
+ * @brief Same as rb_tree_insert_unique, keeping the cached max current.
  */
-static inline void __rb_delete_node(rb_node_t *target) {
-	RB_NULL_CHECK(target);
+bool rb_tree_rcached_insert_unique(rb_tree_rcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_node_t **existing) {
+	RB_NULL_CHECK(tree, false);
+	RB_NULL_CHECK(node, false);
+	RB_NULL_CHECK(cmp, false);
 
-	rb_node_t *child;
+	bool leftmost, rightmost;
+	rb_node_t *found = __rb_insert_unique((rb_tree_t *) tree, node, cmp, &leftmost, &rightmost);
 
-	if (rb_left(target)) child = rb_left(target);
-	else if (rb_right(target)) child = rb_right(target);
-	else child = NULL;
+	if (!found && rightmost) rb_max(tree) = node;
 
-    __rb_replace_child(rb_parent(target), target, child);
-	__rb_set_parent(child, rb_parent(target));
-    __rb_node_clear(target);
+	if (existing) *existing = found;
+	return !found;
 }
 
 /**
- * @brief Basic copy-and-remove algorithm used by BST basic delete.
- * @param[in] src Deletion target, i.e. copy source node.
- * @param[in] dst Node that gets replaced.
- * @param[in] copy Copy callback for the deletion.
+ * @fn rb_tree_lrcached_insert_unique
+ * @brief Same as rb_tree_insert_unique, keeping the cached min and max current.
  */
-static inline void __rb_move_and_delete(rb_node_t *src, rb_node_t *dst, void (*copy)(const rb_node_t *src, rb_node_t *dst)) {
+bool rb_tree_lrcached_insert_unique(rb_tree_lrcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_node_t **existing) {
+	RB_NULL_CHECK(tree, false);
+	RB_NULL_CHECK(node, false);
+	RB_NULL_CHECK(cmp, false);
 
-	/* if we had 1 child (so a replacement) then we copy the replacement and delete that */
-	if (src) {
-		copy((void *) src, (void *) dst);
-    	__rb_delete_node(src);
+	bool leftmost, rightmost;
+	rb_node_t *found = __rb_insert_unique((rb_tree_t *) tree, node, cmp, &leftmost, &rightmost);
 
-	/* else we just delete ourselves */
-	} else {
-		__rb_delete_node(dst);
-	}
-}
+	if (!found && leftmost) rb_min(tree) = node;
+	if (!found && rightmost) rb_max(tree) = node;
 
-static inline void __rb_delete_basic(rb_node_t *replacement, rb_node_t *target, void (*copy)(const rb_node_t *src, rb_node_t *dst)) {
-	__rb_move_and_delete(replacement, target, copy);
+	if (existing) *existing = found;
+	return !found;
 }
 
 /**
- * @brief Performs rb_delete_fixup on the subtree centered on node, correcting all surrounding trees.
+ * @fn rb_tree_find_or_insert
+ * @brief Returns the node in an rb_tree whose key equals node's, inserting node first if there is none, in a single descent.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Pointer to an rb_node instance embedded in something else.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ * @return The node already in the tree, or node itself if it was just inserted.
  */
-static inline void __rb_delete_rebalance(rb_node_t *node) {
-    rb_node_t *parent, *sibling;
-    rb_node_t *sibling_lchild, *sibling_rchild;
+rb_node_t *rb_tree_find_or_insert(rb_tree_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	rb_node_t *existing = NULL;
+	return rb_tree_insert_unique(tree, node, cmp, &existing) ? node : existing;
+}
 
-    for (;;) {
-        parent = rb_parent(node);
+/**
+ * @fn rb_tree_lcached_find_or_insert
+ * @brief Same as rb_tree_find_or_insert, keeping the cached min current.
+ */
+rb_node_t *rb_tree_lcached_find_or_insert(rb_tree_lcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	rb_node_t *existing = NULL;
+	return rb_tree_lcached_insert_unique(tree, node, cmp, &existing) ? node : existing;
+}
 
-		/* if we hit the root, we're done, and the root must always be black. */
-        if (parent == NULL) {
-			__rb_set_black(node);
-            break;
-        }
+/**
+ * @fn rb_tree_rcached_find_or_insert
+ * @brief Same as rb_tree_find_or_insert, keeping the cached max current.
+ */
+rb_node_t *rb_tree_rcached_find_or_insert(rb_tree_rcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	rb_node_t *existing = NULL;
+	return rb_tree_rcached_insert_unique(tree, node, cmp, &existing) ? node : existing;
+}
 
-		/* deleting a red doesn't break any invariants. */
-		if (rb_is_red(node)) {
-			__rb_set_black(node);
-			break;
-		}
+/**
+ * @fn rb_tree_lrcached_find_or_insert
+ * @brief Same as rb_tree_find_or_insert, keeping the cached min and max current.
+ */
+rb_node_t *rb_tree_lrcached_find_or_insert(rb_tree_lrcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	rb_node_t *existing = NULL;
+	return rb_tree_lrcached_insert_unique(tree, node, cmp, &existing) ? node : existing;
+}
 
-        /* otherwise black height property is in violation and we'll need the sibling, etc. */
-        sibling = __rb_sibling(node);
+/** @} */
 
-        /* if we have a red nearby, let's try to dump the double black into that nearby red... 
-		 * that'll prep us for the next case
-		 */
-        if (rb_is_red(sibling)) {
-			__rb_set_black(sibling); 									/* migrate the red upwards */
-			__rb_set_red(parent);
+/**
+ * @defgroup rb_batch Batched insertion.
+ * @{
+ */
 
-			if (sibling == rb_right(parent)) __rb_left_rotate(parent);  /* rotation will make a black w/ red children tree. */
-			else __rb_right_rotate(parent);
+/**
+ * @brief Merges two sorted lists chained through right pointers, taking from 'a' on ties so the merge is stable.
+ */
+static inline rb_node_t *__rb_list_merge(rb_node_t *a, rb_node_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	rb_node_t head;
+	rb_node_t *tail = &head;
+
+	while (a && b) {
+		if (cmp((const rb_node_t *) b, (const rb_node_t *) a) < 0) {
+			rb_right(tail) = b;
+			b = rb_right(b);
+		} else {
+			rb_right(tail) = a;
+			a = rb_right(a);
+		}
 
-			sibling = __rb_sibling(node);								/* our frame of reference has now changed. */
-        }
+		tail = rb_right(tail);
+	}
 
-        /* new sibling is ALWAYS black, so we have to dump the double black somewhere else */
-        sibling_lchild = sibling ? rb_left(sibling) : NULL;
-        sibling_rchild = sibling ? rb_right(sibling) : NULL;
+	rb_right(tail) = a ? a : b;
+	return rb_right(&head);
+}
 
-        /* if the nephew / niece can't take the black recolor, try to propagate it up and dissolve it further up */
-        if (rb_is_black(sibling_lchild) && rb_is_black(sibling_rchild)) {
-	    	__rb_set_red(sibling);
-			node = parent;
-			continue;
-        }
+/**
+ * @brief Stable-sorts n nodes into a list chained through their right pointers, and returns its head.
+ * @details The nodes aren't in a tree yet, so their own links serve as the list and nothing needs to be allocated.
+ * A batch that's already in order is caught with a single pass and just chained up.
+ */
+static rb_node_t *__rb_list_sort(rb_node_t **nodes, size_t n, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
 
-        /* otherwise, we can do some rotations to find a red to drop the double-black into. */
-        if (sibling == rb_right(parent)) {
+	/* bins[i] holds a sorted run of 2^i nodes, and older runs always sit in higher bins */
+	rb_node_t *bins[sizeof(size_t) * 8] = { NULL };
+	rb_node_t *list = NULL;
+	size_t i, bin;
+	bool sorted = true;
 
-            /* if the only red available is on the left side of the sibling, pull the red up and adjust black height */
-            if (rb_is_black(sibling_rchild)) {
+	for (i = 1; i < n && sorted; i++) {
+		sorted = cmp((const rb_node_t *) nodes[i], (const rb_node_t *) nodes[i - 1]) >= 0;
+	}
 
-				/* right-left case right here */
-				__rb_set_black(sibling_lchild);
-				__rb_set_red(sibling);
-                __rb_right_rotate(sibling);	
-     
-				sibling = __rb_sibling(node);
-				sibling_lchild = sibling ? rb_left(sibling) : NULL;
-        		sibling_rchild = sibling ? rb_right(sibling) : NULL;
-            }
+	if (sorted) {
+		for (i = n; i > 0; i--) {
+			rb_right(nodes[i - 1]) = list;
+			list = nodes[i - 1];
+		}
 
-            /* right-right case */
-			__rb_set_color(sibling, rb_color(parent));
-            __rb_set_black(parent);
-            __rb_set_black(sibling_rchild);
-            __rb_left_rotate(parent);
-            break;
+		return list;
+	}
 
-        } else {
+	/* add nodes one at a time like a binary counter, merging equal-sized runs as they carry */
+	for (i = 0; i < n; i++) {
+		list = nodes[i];
+		rb_right(list) = NULL;
 
-            /* left-right case */
-            if (rb_is_black(sibling_lchild)) {
-				__rb_set_black(sibling_rchild);
-				__rb_set_red(sibling);
-                __rb_left_rotate(sibling);
+		for (bin = 0; bins[bin]; bin++) {
+			list = __rb_list_merge(bins[bin], list, cmp);
+			bins[bin] = NULL;
+		}
 
-				sibling = __rb_sibling(node);
-				sibling_lchild = sibling ? rb_left(sibling) : NULL;
-        		sibling_rchild = sibling ? rb_right(sibling) : NULL;
-            }
+		bins[bin] = list;
+	}
 
-			/* left-left case */
-            __rb_set_color(sibling, rb_color(parent));
-            __rb_set_black(parent);
-            __rb_set_black(sibling_lchild);
-            __rb_right_rotate(parent);
-            break;
-        }
+	/* fold whatever runs are left, newest first */
+	list = NULL;
+	for (bin = 0; bin < sizeof(bins) / sizeof(bins[0]); bin++) {
+		if (bins[bin]) list = __rb_list_merge(bins[bin], list, cmp);
 	}
+
+	return list;
 }
 
 /**
- * @fn rb_tree_delete_at
- * @brief Deletes a node from a rbtree at an iterator.
- * @param[in] tree Pointer to an rb_tree instance.
- * @param[in] node Iterator into the tree.
- * @param[in] hint Pointer to a valid rb.
- * @param[in] cmp Comparator callback used to traverse the tree.
- * @param[in] copy Copy callback used for successor node deletion.
+ * @brief Links node in after finger, which must not compare greater than node.
+ * @details Climbs from the finger only as far as the smallest subtree that must hold the node's slot, then descends from there.
+ * Only the turning points of the climb are compared, so a node d positions away costs O(log d) comparisons when it
+ * shares a low ancestor with the finger, and O(log n) when the climb has to go as far as the root.
  */
-void rb_tree_delete_at(rb_tree_t *tree, rb_iterator_t node, void (*copy)(const rb_node_t *src, rb_node_t *dst)) {
-	RB_NULL_CHECK(tree);
-	RB_NULL_CHECK(node);
-	RB_NULL_CHECK(copy);
+static inline void __rb_insert_finger(rb_node_t *finger, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	rb_node_t *anchor = finger;
 
-	rb_node_t *replacement, *cursor;
+	for (;;) {
+		rb_node_t *cursor = anchor;
+		rb_node_t *bound = rb_parent(cursor);
 
-	/* we don't need to find the node, only its replacement */
-    replacement = (rb_node_t *) __rb_node_predecessor(node);    
-
-	/* then we rebalance and propagate changes from the base up */
-	if (replacement) __rb_delete_rebalance(replacement);	
-	else __rb_delete_rebalance(node);
-	
-	/* retrace the root because the rotations might've changed it */
-    cursor = node;
-	while (rb_parent(cursor) != NULL) {
-        cursor = rb_parent(cursor);
-    }
-
-	/* now that all the references in the tree are correctly updated and valid, we can delete this node problem-free */
-	__rb_delete_basic(replacement, node, copy);
+		/* the first ancestor with the anchor on its left is the upper bound of the anchor's subtree */
+		while (bound && cursor == rb_right(bound)) {
+			cursor = bound;
+			bound = rb_parent(bound);
+		}
 
-	/* if the root is cleared, then the tree doesn't exist anymore */
-    if (rb_is_disconnected(rb_root(tree))) {                             
-        rb_root(tree) = NULL;
-    } else {
-		rb_root(tree) = cursor;
+		/* if nothing bounds it, or the bound is past the node, the slot is somewhere under the anchor */
+		if (!bound || cmp((const rb_node_t *) node, (const rb_node_t *) bound) < 0) break;
+		anchor = bound;
 	}
+
+	__rb_insert_basic(anchor, node, cmp);
 }
 
 /**
- * @fn rb_tree_lcached_delete_at
- * @brief Deletes a node from a rbtree at an iterator. Updates the min.
- * @param[in] tree Pointer to an rb_tree instance.
- * @param[in] node Iterator into the tree.
- * @param[in] hint Pointer to a valid rb.
- * @param[in] cmp Comparator callback used to traverse the tree.
- * @param[in] copy Copy callback used for successor node deletion.
+ * @brief Sorts the batch, then inserts it front to back with each node serving as the finger for the next.
+ * @param[out] first Smallest node in the batch.
+ * @param[out] last Largest node in the batch.
  */
-void rb_tree_lcached_delete_at(rb_tree_lcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*copy)(const rb_node_t *src, rb_node_t *dst)) {
+static inline void __rb_insert_batch(rb_tree_t *tree, rb_node_t **nodes, size_t n, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_node_t **first, rb_node_t **last) {
+	rb_node_t *node = __rb_list_sort(nodes, n, cmp);
+	rb_node_t *finger = NULL;
 
-	/* check if the min of the tree changed */
-    bool min_changed = false;
-    if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_min(tree)) == 0) min_changed = true;
+	*first = node;
 
-	/* delete, update references, do whatever you need to do */
-    rb_tree_delete_at((rb_tree_t *) tree, node, copy);
-    
-	/* then update the min */
-	if (rb_is_empty(tree)) {
-		rb_min(tree) = NULL;
-    } else if (min_changed) {
-        rb_min(tree) = (rb_iterator_t) rb_first((rb_tree_t *) tree);
-    }
-}
+	while (node) {
 
-/**
- * @fn rb_tree_rcached_delete_at
- * @brief Deletes a node from a rbtree at an iterator. Updates the max.
- * @param[in] tree Pointer to an rb_tree instance.
- * @param[in] node Iterator into the tree.
- * @param[in] hint Pointer to a valid rb.
- * @param[in] cmp Comparator callback used to traverse the tree.
- * @param[in] copy Copy callback used for successor node deletion.
- */
-void rb_tree_rcached_delete_at(rb_tree_rcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*copy)(const rb_node_t *src, rb_node_t *dst)) {
+		/* the insert rewrites the node's links, so grab the rest of the list beforehand */
+		rb_node_t *next = rb_right(node);
 
-	/* check if the max of the tree changed */
-    bool max_changed = false;
-    if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_max(tree)) == 0) max_changed = true;
+		if (finger) {
+			__rb_node_init(node);
+			__rb_insert_finger(finger, node, cmp);
+			__rb_insert_rebalance(tree, node, NULL);
+		} else rb_tree_insert(tree, node, cmp);
 
-	/* delete, update references, do whatever you need to do */
-    rb_tree_delete_at((rb_tree_t *) tree, node, copy);
+		finger = node;
+		node = next;
+	}
 
-	/* then update the max */
-    if (rb_is_empty(tree)) {
-		rb_max(tree) = NULL;
-    } else if (max_changed) {
-        rb_max(tree) = (rb_iterator_t) rb_last((rb_tree_t *) tree);
-    }
+	*last = finger;
 }
 
+/* --- */
+
 /**
- * @fn rb_tree_lrcached_delete_at
- * @brief Deletes a node from a rbtree at an iterator. Updates the min and the max.
+ * @fn rb_tree_insert_batch
+ * @brief Inserts n nodes into an rb_tree, sorting them first so that each descent starts from the previous insertion.
+ * @details Nodes close together in key order only pay for the distance between them instead of a full descent from the root.
+ * Equal keys end up in the same order as if the nodes had been inserted one at a time, front to back.
  * @param[in] tree Pointer to an rb_tree instance.
- * @param[in] node Iterator into the tree.
- * @param[in] hint Pointer to a valid rb.
- * @param[in] cmp Comparator callback used to traverse the tree.
- * @param[in] copy Copy callback used for successor node deletion.
+ * @param[in] nodes Array of n nodes in any order. The array itself is left as is.
+ * @param[in] n Number of nodes.
+ * @param[in] cmp Comparator callback used to sort the batch and traverse the tree.
  */
-void rb_tree_lrcached_delete_at(rb_tree_lrcached_t *tree, rb_iterator_t node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*copy)(const rb_node_t *src, rb_node_t *dst)) {
-
-	/* check if the min of the tree changed */
-	bool min_changed = false;
-    if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_min(tree)) == 0) min_changed = true;
-
-    bool max_changed = false;
-    if (cmp((const rb_node_t *) node, (const rb_node_t *) rb_max(tree)) == 0) max_changed = true;
-
-	/* delete, update references, do whatever you need to do */
-    rb_tree_delete_at((rb_tree_t *) tree, node, copy);
+void rb_tree_insert_batch(rb_tree_t *tree, rb_node_t **nodes, size_t n, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(nodes);
+	RB_NULL_CHECK(cmp);
 
-	/* then update the max */
-    if (rb_is_empty(tree)) {
-		rb_min(tree) = NULL;
-		rb_max(tree) = NULL;
-    } else if (min_changed) {
-        rb_min(tree) = (rb_iterator_t) rb_first((rb_tree_t *) tree);
-    } else if (max_changed) {
-        rb_max(tree) = (rb_iterator_t) rb_last((rb_tree_t *) tree);
-    }
+	rb_node_t *first, *last;
+	__rb_insert_batch(tree, nodes, n, cmp, &first, &last);
 }
 
 /**
- * @fn rb_tree_delete
- * @brief Deletes a node from an rbtree after finding it manually.
- * @param[in] tree Pointer to an rb_tree instance.
- * @param[in] node Iterator into the tree.
- * @param[in] hint Pointer to a valid rb.
- * @param[in] cmp Comparator callback used to traverse the tree.
- * @param[in] copy Copy callback used for successor node deletion.
+ * @fn rb_tree_lcached_insert_batch
+ * @brief Same as rb_tree_insert_batch, keeping the cached min current.
  */
-void rb_tree_delete(rb_tree_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*copy)(const rb_node_t *src, rb_node_t *dst)) {
+void rb_tree_lcached_insert_batch(rb_tree_lcached_t *tree, rb_node_t **nodes, size_t n, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
 	RB_NULL_CHECK(tree);
-	RB_NULL_CHECK(node);
+	RB_NULL_CHECK(nodes);
 	RB_NULL_CHECK(cmp);
-	RB_NULL_CHECK(copy);
 
-	rb_node_t *target;
-
-	/* make sure the node exists */	
-    target = (rb_node_t *) rb_find(tree, node, cmp);
-    RB_NULL_CHECK(target);
+	rb_node_t *first, *last;
+	bool empty = rb_is_empty(tree);
 
-    rb_tree_delete_at(tree, target, copy);
+	__rb_insert_batch((rb_tree_t *) tree, nodes, n, cmp, &first, &last);
+	if (first && (empty || cmp((const rb_node_t *) first, (const rb_node_t *) rb_min(tree)) < 0)) rb_min(tree) = first;
 }
 
 /**
- * @fn rb_tree_lcached_delete
- * @brief Deletes a node from an rbtree after finding it manually. Updates the min.
- * @param[in] tree Pointer to an rb_tree instance.
- * @param[in] node Iterator into the tree.
- * @param[in] hint Pointer to a valid rb.
- * @param[in] cmp Comparator callback used to traverse the tree.
- * @param[in] copy Copy callback used for successor node deletion.
+ * @fn rb_tree_rcached_insert_batch
+ * @brief Same as rb_tree_insert_batch, keeping the cached max current.
  */
-void rb_tree_lcached_delete(rb_tree_lcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*copy)(const rb_node_t *src, rb_node_t *dst)) {
+void rb_tree_rcached_insert_batch(rb_tree_rcached_t *tree, rb_node_t **nodes, size_t n, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
 	RB_NULL_CHECK(tree);
-	RB_NULL_CHECK(node);
+	RB_NULL_CHECK(nodes);
 	RB_NULL_CHECK(cmp);
-	RB_NULL_CHECK(copy);
-	
-	rb_node_t *target;
 
-	/* make sure the node exists */	
-    target = (rb_node_t *) rb_find((rb_tree_t *) tree, node, cmp);
-    RB_NULL_CHECK(target);
+	rb_node_t *first, *last;
+	bool empty = rb_is_empty(tree);
 
-    rb_tree_lcached_delete_at(tree, target, cmp, copy);
+	__rb_insert_batch((rb_tree_t *) tree, nodes, n, cmp, &first, &last);
+	if (last && (empty || cmp((const rb_node_t *) last, (const rb_node_t *) rb_max(tree)) >= 0)) rb_max(tree) = last;
 }
 
 /**
- * @fn rb_tree_rcached_delete
- * @brief Deletes a node from an rbtree after finding it manually. Updates the max.
- * @param[in] tree Pointer to an rb_tree instance.
- * @param[in] node Iterator into the tree.
- * @param[in] hint Pointer to a valid rb.
- * @param[in] cmp Comparator callback used to traverse the tree.
- * @param[in] copy Copy callback used for successor node deletion.
+ * @fn rb_tree_lrcached_insert_batch
+ * @brief Same as rb_tree_insert_batch, keeping the cached min and max current.
  */
-void rb_tree_rcached_delete(rb_tree_rcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*copy)(const rb_node_t *src, rb_node_t *dst)) {
+void rb_tree_lrcached_insert_batch(rb_tree_lrcached_t *tree, rb_node_t **nodes, size_t n, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
 	RB_NULL_CHECK(tree);
-	RB_NULL_CHECK(node);
+	RB_NULL_CHECK(nodes);
 	RB_NULL_CHECK(cmp);
-	RB_NULL_CHECK(copy);
 
-	rb_node_t *target;
+	rb_node_t *first, *last;
+	bool empty = rb_is_empty(tree);
 
-	/* make sure the node exists */	
-    target = (rb_node_t *) rb_find((rb_tree_t *) tree, node, cmp);
-    RB_NULL_CHECK(target);
+	__rb_insert_batch((rb_tree_t *) tree, nodes, n, cmp, &first, &last);
+	if (first && (empty || cmp((const rb_node_t *) first, (const rb_node_t *) rb_min(tree)) < 0)) rb_min(tree) = first;
+	if (last && (empty || cmp((const rb_node_t *) last, (const rb_node_t *) rb_max(tree)) >= 0)) rb_max(tree) = last;
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_build Bulk construction from presorted nodes.
+ * @{
+ */
+
+/**
+ * @brief Where the builder draws its nodes from, in order: an array if there is one, otherwise a list chained through right pointers.
+ */
+typedef struct __rb_build_source {
+	rb_node_t **array;
+	rb_node_t *list;
+} __rb_build_source_t;
+
+/**
+ * @brief Returns the next node in sorted order and advances past it.
+ */
+static inline rb_node_t *__rb_build_take(__rb_build_source_t *source) {
+	rb_node_t *node;
+
+	if (source->array) return *source->array++;
+
+	/* the list link lives in the node we're about to overwrite, so step off of it first */
+	node = source->list;
+	source->list = rb_right(node);
+	return node;
+}
+
+/**
+ * @brief Builds a subtree of n nodes under parent by splitting around the middle, taking nodes in order.
+ * @details Both halves of every split differ by at most one node, so every path to a leaf ends on one of the bottom two levels.
+ * Painting only the bottom level red, when it isn't full, makes every path carry the same number of black nodes.
+ * @param[in] source Node source, consumed in order.
+ * @param[in] n Number of nodes in this subtree.
+ * @param[in] depth Depth of this subtree's root.
+ * @param[in] red_depth Depth whose nodes are painted red, or SIZE_MAX if the tree is perfect and every node is black.
+ * @param[in] parent Parent of this subtree's root.
+ */
+static rb_node_t *__rb_build_subtree(__rb_build_source_t *source, size_t n, size_t depth, size_t red_depth, rb_node_t *parent) {
+	rb_node_t *left, *node;
+
+	if (n == 0) return NULL;
+
+	/* in-order: the left half has to come off of the source before the middle node does */
+	left = __rb_build_subtree(source, n / 2, depth + 1, red_depth, NULL);
+	node = __rb_build_take(source);
+
+	__rb_set_parent_and_color(node, parent, (depth == red_depth) ? RB_RED : RB_BLACK);
+	rb_left(node) = left;
+	__rb_set_parent(left, node);
+	rb_right(node) = __rb_build_subtree(source, n - n / 2 - 1, depth + 1, red_depth, node);
+
+	return node;
+}
+
+/**
+ * @brief Replaces the tree's contents with the n nodes of source.
+ */
+static inline void __rb_build(rb_tree_t *tree, __rb_build_source_t *source, size_t n) {
+	size_t height = 0;
+
+	/* the bottom level sits at floor(log2(n)), and it's only completely filled if n is one short of a power of 2 */
+	while ((n >> height) > 1) height++;
+	rb_root(tree) = __rb_build_subtree(source, n, 0, ((n & (n + 1)) == 0) ? SIZE_MAX : height, NULL);
+}
+
+/* --- */
+
+/**
+ * @fn rb_tree_build_sorted
+ * @brief Links an array of nodes, already in sorted order, into a balanced rb_tree in O(n) without comparing anything.
+ * @details Whatever the tree held before is dropped. Equal neighbors are fine and keep their order, same as rb_tree_insert.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] nodes Array of n nodes, in the order the tree's comparator would put them.
+ * @param[in] n Number of nodes.
+ */
+void rb_tree_build_sorted(rb_tree_t *tree, rb_node_t **nodes, size_t n) {
+	RB_NULL_CHECK(tree);
+
+	__rb_build_source_t source = { .array = nodes, .list = NULL };
+
+	if (n == 0) {
+		rb_root(tree) = NULL;
+		return;
+	}
+
+	RB_NULL_CHECK(nodes);
+	__rb_build(tree, &source, n);
+}
+
+/**
+ * @fn rb_tree_lcached_build_sorted
+ * @brief Same as rb_tree_build_sorted, also setting the cached min.
+ */
+void rb_tree_lcached_build_sorted(rb_tree_lcached_t *tree, rb_node_t **nodes, size_t n) {
+	RB_NULL_CHECK(tree);
+
+	rb_tree_build_sorted((rb_tree_t *) tree, nodes, n);
+	rb_min(tree) = n ? nodes[0] : NULL;
+}
+
+/**
+ * @fn rb_tree_rcached_build_sorted
+ * @brief Same as rb_tree_build_sorted, also setting the cached max.
+ */
+void rb_tree_rcached_build_sorted(rb_tree_rcached_t *tree, rb_node_t **nodes, size_t n) {
+	RB_NULL_CHECK(tree);
+
+	rb_tree_build_sorted((rb_tree_t *) tree, nodes, n);
+	rb_max(tree) = n ? nodes[n - 1] : NULL;
+}
+
+/**
+ * @fn rb_tree_lrcached_build_sorted
+ * @brief Same as rb_tree_build_sorted, also setting the cached min and max.
+ */
+void rb_tree_lrcached_build_sorted(rb_tree_lrcached_t *tree, rb_node_t **nodes, size_t n) {
+	RB_NULL_CHECK(tree);
+
+	rb_tree_build_sorted((rb_tree_t *) tree, nodes, n);
+	rb_min(tree) = n ? nodes[0] : NULL;
+	rb_max(tree) = n ? nodes[n - 1] : NULL;
+}
+
+/**
+ * @fn rb_tree_build_sorted_list
+ * @brief Links a list of nodes, already in sorted order, into a balanced rb_tree in O(n) without comparing anything.
+ * @details The list is threaded through the nodes' own right pointers and ends at NULL, so it needs no storage of its own.
+ * Whatever the tree held before is dropped.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] head First node of the list, or NULL for an empty tree.
+ */
+void rb_tree_build_sorted_list(rb_tree_t *tree, rb_node_t *head) {
+	RB_NULL_CHECK(tree);
+
+	__rb_build_source_t source = { .array = NULL, .list = head };
+	size_t n = 0;
+
+	/* the split points depend on the length, so count it up front */
+	for (const rb_node_t *node = head; node; node = rb_right(node)) n++;
+
+	if (n == 0) {
+		rb_root(tree) = NULL;
+		return;
+	}
+
+	__rb_build(tree, &source, n);
+}
+
+/**
+ * @fn rb_tree_lcached_build_sorted_list
+ * @brief Same as rb_tree_build_sorted_list, also setting the cached min.
+ */
+void rb_tree_lcached_build_sorted_list(rb_tree_lcached_t *tree, rb_node_t *head) {
+	RB_NULL_CHECK(tree);
+
+	rb_tree_build_sorted_list((rb_tree_t *) tree, head);
+	rb_min(tree) = head;
+}
+
+/**
+ * @fn rb_tree_rcached_build_sorted_list
+ * @brief Same as rb_tree_build_sorted_list, also setting the cached max.
+ */
+void rb_tree_rcached_build_sorted_list(rb_tree_rcached_t *tree, rb_node_t *head) {
+	RB_NULL_CHECK(tree);
+
+	rb_tree_build_sorted_list((rb_tree_t *) tree, head);
+	rb_max(tree) = head ? (rb_node_t *) rb_last((rb_tree_t *) tree) : NULL;
+}
+
+/**
+ * @fn rb_tree_lrcached_build_sorted_list
+ * @brief Same as rb_tree_build_sorted_list, also setting the cached min and max.
+ */
+void rb_tree_lrcached_build_sorted_list(rb_tree_lrcached_t *tree, rb_node_t *head) {
+	RB_NULL_CHECK(tree);
+
+	rb_tree_build_sorted_list((rb_tree_t *) tree, head);
+	rb_min(tree) = head;
+	rb_max(tree) = head ? (rb_node_t *) rb_last((rb_tree_t *) tree) : NULL;
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_deletion Red-black tree deletion functions (and helpers)
+ * @{
+ */
+
+/**
+ * @brief Performs rb_delete_fixup on the subtree centered on node, correcting all surrounding trees.
+ * @details Rotations update the tree's root in place, so no walk back up is needed afterwards.
+ */
+static inline void __rb_delete_rebalance(rb_tree_t *tree, rb_node_t *node, const rb_augment_t *aug) {
+    rb_node_t *parent, *sibling;
+    rb_node_t *sibling_lchild, *sibling_rchild;
+
+    for (;;) {
+        parent = rb_parent(node);
+
+		/* if we hit the root, we're done, and the root must always be black. */
+        if (parent == NULL) {
+			__rb_set_black(node);
+            break;
+        }
+
+		/* deleting a red doesn't break any invariants. */
+		if (rb_is_red(node)) {
+			__rb_set_black(node);
+			break;
+		}
+
+        /* otherwise black height property is in violation and we'll need the sibling, etc. */
+        sibling = __rb_sibling(node);
+
+        /* if we have a red nearby, let's try to dump the double black into that nearby red... 
+		 * that'll prep us for the next case
+		 */
+        if (rb_is_red(sibling)) {
+			__rb_set_black(sibling); 									/* migrate the red upwards */
+			__rb_set_red(parent);
+
+			if (sibling == rb_right(parent)) __rb_left_rotate(tree, parent, aug);  /* rotation will make a black w/ red children tree. */
+			else __rb_right_rotate(tree, parent, aug);
+
+			sibling = __rb_sibling(node);								/* our frame of reference has now changed. */
+        }
+
+        /* new sibling is ALWAYS black, so we have to dump the double black somewhere else */
+        sibling_lchild = sibling ? rb_left(sibling) : NULL;
+        sibling_rchild = sibling ? rb_right(sibling) : NULL;
+
+        /* if the nephew / niece can't take the black recolor, try to propagate it up and dissolve it further up */
+        if (rb_is_black(sibling_lchild) && rb_is_black(sibling_rchild)) {
+	    	__rb_set_red(sibling);
+			node = parent;
+			continue;
+        }
+
+        /* otherwise, we can do some rotations to find a red to drop the double-black into. */
+        if (sibling == rb_right(parent)) {
+
+            /* if the only red available is on the left side of the sibling, pull the red up and adjust black height */
+            if (rb_is_black(sibling_rchild)) {
+
+				/* right-left case right here */
+				__rb_set_black(sibling_lchild);
+				__rb_set_red(sibling);
+                __rb_right_rotate(tree, sibling, aug);	
+     
+				sibling = __rb_sibling(node);
+				sibling_lchild = sibling ? rb_left(sibling) : NULL;
+        		sibling_rchild = sibling ? rb_right(sibling) : NULL;
+            }
+
+            /* right-right case */
+			__rb_set_color(sibling, rb_color(parent));
+            __rb_set_black(parent);
+            __rb_set_black(sibling_rchild);
+            __rb_left_rotate(tree, parent, aug);
+            break;
+
+        } else {
+
+            /* left-right case */
+            if (rb_is_black(sibling_lchild)) {
+				__rb_set_black(sibling_rchild);
+				__rb_set_red(sibling);
+                __rb_left_rotate(tree, sibling, aug);
+
+				sibling = __rb_sibling(node);
+				sibling_lchild = sibling ? rb_left(sibling) : NULL;
+        		sibling_rchild = sibling ? rb_right(sibling) : NULL;
+            }
+
+			/* left-left case */
+            __rb_set_color(sibling, rb_color(parent));
+            __rb_set_black(parent);
+            __rb_set_black(sibling_lchild);
+            __rb_right_rotate(tree, parent, aug);
+            break;
+        }
+	}
+}
+
+/**
+ * @brief Trades tree positions between target and its in-order successor.
+ * @details Only the links and colors change hands, so neither node moves in memory and no payload is copied.
+ * Afterwards, target sits where the successor was and has at most a right child.
+ * @param[in] target Node with two children.
+ * @param[in] successor Leftmost node of target's right subtree.
+ */
+static inline void __rb_swap_successor(rb_tree_t *tree, rb_node_t *target, rb_node_t *successor) {
+	rb_node_t *parent = rb_parent(target);
+	rb_node_t *left = rb_left(target);
+	rb_node_t *right = rb_right(target);
+	rb_node_t *successor_parent = rb_parent(successor);
+	rb_node_t *successor_right = rb_right(successor);
+	rb_color_t target_color = rb_color(target);
+	rb_color_t successor_color = rb_color(successor);
+
+	/* the successor takes over the target's link from above, along with its color */
+	__rb_replace_child(tree, parent, target, successor);
+	__rb_set_parent_and_color(successor, parent, target_color);
+
+	/* the successor is the leftmost node of its subtree, so it has no left subtree of its own to lose */
+	rb_left(successor) = left;
+	__rb_set_parent(left, successor);
+
+	/* if the successor was the target's right child, the target simply hangs off of it on that side */
+	if (successor == right) {
+		rb_right(successor) = target;
+		__rb_set_parent(target, successor);
+	} else {
+		rb_right(successor) = right;
+		__rb_set_parent(right, successor);
+
+		rb_left(successor_parent) = target;
+		__rb_set_parent(target, successor_parent);
+	}
+
+	/* the target adopts whatever the successor left behind */
+	rb_left(target) = NULL;
+	rb_right(target) = successor_right;
+	__rb_set_parent(successor_right, target);
+	__rb_set_color(target, successor_color);
+}
+
+/**
+ * @brief Unlinks target from its tree by relinking its neighbors, like the kernel's rb_erase.
+ * @details No other node changes address or payload. The root is kept current along the way.
+ * @param[in] tree Tree containing the target.
+ * @param[in] target Node to unlink.
+ * @param[in] aug Augmentation callbacks, or NULL for a plain tree.
+ */
+static inline void __rb_erase(rb_tree_t *tree, rb_node_t *target, const rb_augment_t *aug) {
+	rb_node_t *parent, *child;
+
+	/* with two children, swap into the successor's spot first so at most one child is left to splice */
+	if (rb_left(target) && rb_right(target)) {
+		rb_node_t *successor = (rb_node_t *) rb_next(target);
+		__rb_swap_successor(tree, target, successor);
+
+		/* the successor spans the target's old subtree, and everything from the target up to it lost the successor */
+		if (aug) {
+			aug->copy(target, successor);
+			aug->propagate(target, successor);
+		}
+	}
+
+	child = rb_left(target) ? rb_left(target) : rb_right(target);
+
+	/** 
+	 * removing a black leaf shortens its path, so fix that up while the target still holds its place.
+	 * a red leaf can just go, and a lone child is always red, so it can take over the target's black.
+	 */
+	if (!child && rb_is_black(target)) __rb_delete_rebalance(tree, target, aug);
+
+	parent = rb_parent(target);
+	__rb_replace_child(tree, parent, target, child);
+	if (child) __rb_set_black(child);
+	__rb_node_clear(target);
+
+	/* every subtree that held the target is one node lighter now */
+	if (aug && parent) aug->propagate(parent, NULL);
+}
+
+/**
+ * @fn rb_tree_delete_at
+ * @brief Deletes a node from a rbtree at an iterator.
+ * @details The node is spliced out by relinking pointers, so every other node keeps its address and payload.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Iterator into the tree.
+ */
+void rb_tree_delete_at(rb_tree_t *tree, rb_iterator_t node) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(node);
+
+	/* the rotations and the splice keep the root up to date as they go */
+	__rb_erase(tree, node, NULL);
+}
+
+/**
+ * @fn rb_tree_lcached_delete_at
+ * @brief Deletes a node from a rbtree at an iterator. Updates the min.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Iterator into the tree.
+ * @param[in] cmp Unused; the min is tracked by identity. Kept for API compatibility.
+ */
+void rb_tree_lcached_delete_at(rb_tree_lcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(node);
+	(void) cmp;
+
+	/* the min is the leftmost node, so if it's going away its successor takes over - no comparison or rb_first needed */
+	if (node == rb_min(tree)) rb_min(tree) = (rb_iterator_t) rb_next(node);
+
+	/* delete, update references, do whatever you need to do */
+    rb_tree_delete_at((rb_tree_t *) tree, node);
+}
+
+/**
+ * @fn rb_tree_rcached_delete_at
+ * @brief Deletes a node from a rbtree at an iterator. Updates the max.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Iterator into the tree.
+ * @param[in] cmp Unused; the max is tracked by identity. Kept for API compatibility.
+ */
+void rb_tree_rcached_delete_at(rb_tree_rcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(node);
+	(void) cmp;
+
+	/* likewise, the max hands off to its predecessor */
+	if (node == rb_max(tree)) rb_max(tree) = (rb_iterator_t) rb_prev(node);
+
+	/* delete, update references, do whatever you need to do */
+    rb_tree_delete_at((rb_tree_t *) tree, node);
+}
+
+/**
+ * @fn rb_tree_lrcached_delete_at
+ * @brief Deletes a node from a rbtree at an iterator. Updates the min and the max.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Iterator into the tree.
+ * @param[in] cmp Unused; the min and max are tracked by identity. Kept for API compatibility.
+ */
+void rb_tree_lrcached_delete_at(rb_tree_lrcached_t *tree, rb_iterator_t node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(node);
+	(void) cmp;
+
+	/* the ends step inward to their neighbors; a lone node is both, and both come out NULL */
+	if (node == rb_min(tree)) rb_min(tree) = (rb_iterator_t) rb_next(node);
+	if (node == rb_max(tree)) rb_max(tree) = (rb_iterator_t) rb_prev(node);
+
+	/* delete, update references, do whatever you need to do */
+    rb_tree_delete_at((rb_tree_t *) tree, node);
+}
+
+/**
+ * @fn rb_tree_delete
+ * @brief Deletes a node from an rbtree after finding it manually.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Iterator into the tree.
+ * @param[in] hint Pointer to a valid rb.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+void rb_tree_delete(rb_tree_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(node);
+	RB_NULL_CHECK(cmp);
+
+	rb_node_t *target;
+
+	/* make sure the node exists */	
+    target = (rb_node_t *) rb_find(tree, node, cmp);
+    RB_NULL_CHECK(target);
+
+    rb_tree_delete_at(tree, target);
+}
+
+/**
+ * @fn rb_tree_lcached_delete
+ * @brief Deletes a node from an rbtree after finding it manually. Updates the min.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Iterator into the tree.
+ * @param[in] hint Pointer to a valid rb.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+void rb_tree_lcached_delete(rb_tree_lcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(node);
+	RB_NULL_CHECK(cmp);
+	
+	rb_node_t *target;
+
+	/* make sure the node exists */	
+    target = (rb_node_t *) rb_find((rb_tree_t *) tree, node, cmp);
+    RB_NULL_CHECK(target);
+
+    rb_tree_lcached_delete_at(tree, target, cmp);
+}
+
+/**
+ * @fn rb_tree_rcached_delete
+ * @brief Deletes a node from an rbtree after finding it manually. Updates the max.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Iterator into the tree.
+ * @param[in] hint Pointer to a valid rb.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+void rb_tree_rcached_delete(rb_tree_rcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(node);
+	RB_NULL_CHECK(cmp);
+
+	rb_node_t *target;
+
+	/* make sure the node exists */	
+    target = (rb_node_t *) rb_find((rb_tree_t *) tree, node, cmp);
+    RB_NULL_CHECK(target);
+
+    rb_tree_rcached_delete_at(tree, target, cmp);
+}
+
+/**
+ * @fn rb_tree_lrcached_delete
+ * @brief Deletes a node from an rbtree after finding it manually. Updates the min and the max.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Iterator into the tree.
+ * @param[in] hint Pointer to a valid rb.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+void rb_tree_lrcached_delete(rb_tree_lrcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(node);
+	RB_NULL_CHECK(cmp);
+
+	rb_node_t *target;
+
+	/* make sure the node exists */	
+    target = (rb_node_t *) rb_find((rb_tree_t *) tree, node, cmp);
+    RB_NULL_CHECK(target);
+
+    rb_tree_lrcached_delete_at(tree, target, cmp);
+}
+
+/**
+ * @fn rb_delete_key
+ * @brief Finds a node matching a bare key and deletes it from the tree.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] key Pointer to the key to be deleted.
+ * @param[in] cmp_key Callback comparing the key against a node.
+ * @return The unlinked node, or NULL if nothing matched.
+ */
+rb_node_t *rb_delete_key(rb_tree_t *tree, const void *key, int (*cmp_key)(const void *key, const rb_node_t *node)) {
+	RB_NULL_CHECK(tree, NULL);
+	RB_NULL_CHECK(cmp_key, NULL);
+
+	rb_node_t *target;
+
+	/* a missing key isn't an error here, the caller just gets NULL back */
+	target = (rb_node_t *) rb_find_key(tree, key, cmp_key);
+	if (!target) return NULL;
+
+	rb_tree_delete_at(tree, target);
+	return target;
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_pop Priority-queue style removal from the front of a min-cached tree.
+ * @{
+ */
+
+/**
+ * @fn rb_lcached_pop_min
+ * @brief Unlinks and returns the min of a min-cached tree, or NULL if it's empty.
+ * @details The min's successor becomes the new min, so there is no comparison and no walk down from the root.
+ * @param[in] tree Pointer to an rb_tree instance.
+ */
+rb_node_t *rb_lcached_pop_min(rb_tree_lcached_t *tree) {
+	RB_NULL_CHECK(tree, NULL);
+
+	rb_node_t *min = rb_min(tree);
+	if (!min) return NULL;
+
+	/* the min has no left child, so its successor is either its right child's leftmost node or its parent */
+	rb_min(tree) = (rb_iterator_t) rb_next(min);
+	rb_tree_delete_at((rb_tree_t *) tree, min);
+
+	return min;
+}
+
+/**
+ * @fn rb_lcached_pop_until
+ * @brief Unlinks every node that doesn't compare greater than key, in order, handing each one to a callback.
+ * @details Nodes are unlinked before the callback sees them, so it may free or reinsert them. Anything reinserted
+ * at or below key is popped again.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] key Pointer to the node to drain up to, inclusive.
+ * @param[in] cmp Comparator callback the tree is ordered by.
+ * @param[in] cb Callback receiving each unlinked node, or NULL.
+ * @return Number of nodes unlinked.
+ */
+size_t rb_lcached_pop_until(rb_tree_lcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node)) {
+	RB_NULL_CHECK(tree, 0);
+	RB_NULL_CHECK(key, 0);
+	RB_NULL_CHECK(cmp, 0);
+
+	size_t count = 0;
+	rb_node_t *min;
+
+	/* one comparison per node drained, plus one for the node that stops it */
+	while ((min = rb_min(tree)) && cmp((const rb_node_t *) min, key) <= 0) {
+		rb_min(tree) = (rb_iterator_t) rb_next(min);
+		rb_tree_delete_at((rb_tree_t *) tree, min);
+
+		/* the min is fixed before the callback runs, in case it inserts back into the tree */
+		if (cb) cb(min);
+		count++;
+	}
+
+	return count;
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_replace Red-black tree in-place replacement functions.
+ * @{
+ */
+
+/**
+ * @fn rb_replace_node
+ * @brief Puts replacement into victim's exact position in O(1), without comparing or rebalancing anything.
+ * @details The replacement must sort the same as the victim, so this suits updating a record whose key hasn't changed.
+ * The victim comes out disconnected. Not for order-statistic trees, whose sizes it leaves stale; use
+ * rb_tree_os_replace_node there.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] victim Node in the tree.
+ * @param[in] replacement Node not in any tree.
+ */
+void rb_replace_node(rb_tree_t *tree, rb_node_t *victim, rb_node_t *replacement) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(victim);
+	RB_NULL_CHECK(replacement);
+
+	/* same parent, color and children, so the shape and every invariant carry over untouched */
+	*replacement = *victim;
+
+	/* then point the neighbors at the replacement instead */
+	__rb_replace_child(tree, rb_parent(victim), victim, replacement);
+	__rb_set_parent(rb_left(victim), replacement);
+	__rb_set_parent(rb_right(victim), replacement);
+
+	__rb_node_clear(victim);
+}
+
+/**
+ * @fn rb_lcached_replace_node
+ * @brief Same as rb_replace_node, keeping the cached min current.
+ */
+void rb_lcached_replace_node(rb_tree_lcached_t *tree, rb_node_t *victim, rb_node_t *replacement) {
+	RB_NULL_CHECK(tree);
+
+	if (rb_min(tree) == victim) rb_min(tree) = replacement;
+	rb_replace_node((rb_tree_t *) tree, victim, replacement);
+}
+
+/**
+ * @fn rb_rcached_replace_node
+ * @brief Same as rb_replace_node, keeping the cached max current.
+ */
+void rb_rcached_replace_node(rb_tree_rcached_t *tree, rb_node_t *victim, rb_node_t *replacement) {
+	RB_NULL_CHECK(tree);
+
+	if (rb_max(tree) == victim) rb_max(tree) = replacement;
+	rb_replace_node((rb_tree_t *) tree, victim, replacement);
+}
+
+/**
+ * @fn rb_lrcached_replace_node
+ * @brief Same as rb_replace_node, keeping the cached min and max current.
+ */
+void rb_lrcached_replace_node(rb_tree_lrcached_t *tree, rb_node_t *victim, rb_node_t *replacement) {
+	RB_NULL_CHECK(tree);
+
+	if (rb_min(tree) == victim) rb_min(tree) = replacement;
+	if (rb_max(tree) == victim) rb_max(tree) = replacement;
+	rb_replace_node((rb_tree_t *) tree, victim, replacement);
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_split_join Splitting trees apart at a key and joining them back together.
+ * @{
+ */
+
+/**
+ * @brief Number of black nodes on any path from node down to a leaf, not counting the NULL leaf itself.
+ */
+static inline size_t __rb_black_height(const rb_node_t *node) {
+	size_t height = 0;
+
+	for (; node; node = rb_left(node)) height += rb_is_black(node);
+	return height;
+}
+
+/**
+ * @brief Joins two standalone subtrees around a pivot and returns the new root.
+ * @details Both roots must be black, or NULL. The shorter tree is hung off of the taller one's inner spine at the
+ * first black node of equal black height, under a red pivot, and the ordinary insert fixup repairs any red-red
+ * pair that leaves. The work is proportional to the difference in heights, not to either tree's size.
+ * @param[in] left Root of the subtree sorting before pivot.
+ * @param[in] left_height Black height of left.
+ * @param[in] pivot Node sorting between the two subtrees, not in any tree.
+ * @param[in] right Root of the subtree sorting after pivot.
+ * @param[in] right_height Black height of right.
+ * @param[out] height Black height of the joined tree.
+ */
+static rb_node_t *__rb_join(rb_node_t *left, size_t left_height, rb_node_t *pivot, rb_node_t *right, size_t right_height, size_t *height) {
+	rb_tree_t tree;
+	rb_node_t *parent = NULL, *cursor;
+	size_t cursor_height;
+
+	/* same height means the pivot can simply sit on top */
+	if (left_height == right_height) {
+		__rb_set_parent_and_color(pivot, NULL, RB_BLACK);
+		rb_left(pivot) = left;
+		rb_right(pivot) = right;
+		__rb_set_parent(left, pivot);
+		__rb_set_parent(right, pivot);
+
+		*height = left_height + 1;
+		return pivot;
+	}
+
+	/* otherwise walk down the taller tree's inner spine until the subtree there is as tall as the shorter tree */
+	if (left_height > right_height) {
+		cursor = left;
+		cursor_height = left_height;
+
+		while (cursor_height != right_height || rb_is_red(cursor)) {
+			cursor_height -= rb_is_black(cursor);
+			parent = cursor;
+			cursor = rb_right(cursor);
+		}
+
+		rb_left(pivot) = cursor;
+		rb_right(pivot) = right;
+		rb_right(parent) = pivot;
+		rb_root(&tree) = left;
+	} else {
+		cursor = right;
+		cursor_height = right_height;
+
+		while (cursor_height != left_height || rb_is_red(cursor)) {
+			cursor_height -= rb_is_black(cursor);
+			parent = cursor;
+			cursor = rb_left(cursor);
+		}
+
+		rb_left(pivot) = left;
+		rb_right(pivot) = cursor;
+		rb_left(parent) = pivot;
+		rb_root(&tree) = right;
+	}
+
+	/* a red pivot keeps every black height intact, so only a red parent above it can be wrong */
+	__rb_set_parent_and_color(pivot, parent, RB_RED);
+	__rb_set_parent(rb_left(pivot), pivot);
+	__rb_set_parent(rb_right(pivot), pivot);
+
+	*height = ((left_height > right_height) ? left_height : right_height) + __rb_insert_rebalance(&tree, pivot, NULL);
+	return rb_root(&tree);
+}
+
+/**
+ * @brief Joins two standalone subtrees with no pivot, borrowing the right one's first node for it.
+ * @param[in] left Root of the subtree sorting first, black or NULL.
+ * @param[in] left_height Black height of left.
+ * @param[in] right Root of the subtree sorting last, black or NULL.
+ * @param[out] height Black height of the joined tree.
+ */
+static rb_node_t *__rb_join2(rb_node_t *left, size_t left_height, rb_node_t *right, size_t *height) {
+	rb_tree_t tree;
+	rb_node_t *pivot;
+
+	if (!right) {
+		*height = left_height;
+		return left;
+	}
+
+	/* the delete can shorten what's left of right, so its height is taken again afterwards */
+	for (pivot = right; rb_left(pivot); pivot = rb_left(pivot));
+	rb_root(&tree) = right;
+	__rb_erase(&tree, pivot, NULL);
+
+	return __rb_join(left, left_height, pivot, rb_root(&tree), __rb_black_height(rb_root(&tree)), height);
+}
+
+/**
+ * @brief Cuts a child of a black node loose as a standalone subtree, and returns it.
+ * @details Standalone subtrees need black roots, and blackening a red one makes it one level taller.
+ * @param[in] child Child to cut loose, or NULL.
+ * @param[in,out] height Black height of child, which is its parent's less one. Updated if child had to be blackened.
+ */
+static inline rb_node_t *__rb_detach(rb_node_t *child, size_t *height) {
+	if (!child) return NULL;
+
+	__rb_set_parent(child, NULL);
+	if (rb_is_red(child)) {
+		__rb_set_black(child);
+		(*height)++;
+	}
+
+	return child;
+}
+
+/**
+ * @brief Splits the subtree at node into the nodes comparing less than key and the rest, as two standalone subtrees.
+ * @details Follows the search path for key, cutting each node's children loose and joining them back up on the
+ * correct side. The joins along the way telescope, so the whole split is O(log n).
+ * @param[in] node Root of the subtree, which must be black, or NULL.
+ * @param[in] height Black height of node.
+ * @param[in] key Pointer to the node to split at.
+ * @param[in] cmp Comparator callback the tree is ordered by.
+ * @param[out] left Root of the nodes comparing less than key.
+ * @param[out] left_height Black height of left.
+ * @param[out] right Root of the rest.
+ * @param[out] right_height Black height of right.
+ * @param[out] match If not NULL, the first node found comparing equal to key is cut out into it rather than put on
+ * the right, leaving only the nodes comparing greater there. Set to NULL if there is no such node. Only meaningful if
+ * the keys are unique.
+ */
+static void __rb_split(rb_node_t *node, size_t height, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_node_t **left, size_t *left_height, rb_node_t **right, size_t *right_height, rb_node_t **match) {
+	rb_node_t *child_left, *child_right, *rest;
+	size_t child_left_height, child_right_height, rest_height;
+	int result;
+
+	if (!node) {
+		*left = *right = NULL;
+		*left_height = *right_height = 0;
+		if (match) *match = NULL;
+		return;
+	}
+
+	child_left_height = child_right_height = height - 1;
+	child_left = __rb_detach(rb_left(node), &child_left_height);
+	child_right = __rb_detach(rb_right(node), &child_right_height);
+
+	result = cmp(node, key);
+
+	/* with unique keys, the match's children are exactly the two halves already */
+	if (result == 0 && match) {
+		*left = child_left;
+		*left_height = child_left_height;
+		*right = child_right;
+		*right_height = child_right_height;
+		*match = node;
+		return;
+	}
+
+	if (result < 0) {
+		__rb_split(child_right, child_right_height, key, cmp, &rest, &rest_height, right, right_height, match);
+		*left = __rb_join(child_left, child_left_height, node, rest, rest_height, left_height);
+	} else {
+		__rb_split(child_left, child_left_height, key, cmp, left, left_height, &rest, &rest_height, match);
+		*right = __rb_join(rest, rest_height, node, child_right, child_right_height, right_height);
+	}
+}
+
+/* --- */
+
+/**
+ * @fn rb_tree_split
+ * @brief Moves the nodes of a tree comparing less than key into left and the rest into right, in O(log n).
+ * @details Nodes are relinked, never copied, and key is compared once per level. tree comes out empty, unless it's also passed
+ * as left or right, and whatever left and right held before is dropped.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] key Pointer to the node to split at. It doesn't have to be in the tree.
+ * @param[in] cmp Comparator callback the tree is ordered by.
+ * @param[out] left Pointer to an rb_tree instance receiving the nodes less than key.
+ * @param[out] right Pointer to an rb_tree instance receiving the rest.
+ */
+void rb_tree_split(rb_tree_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_tree_t *left, rb_tree_t *right) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(key);
+	RB_NULL_CHECK(cmp);
+	RB_NULL_CHECK(left);
+	RB_NULL_CHECK(right);
+
+	rb_node_t *root = rb_root(tree), *l, *r;
+	size_t left_height, right_height;
+
+	rb_root(tree) = NULL;
+	__rb_split(root, __rb_black_height(root), key, cmp, &l, &left_height, &r, &right_height, NULL);
+
+	rb_root(left) = l;
+	rb_root(right) = r;
+}
+
+/**
+ * @fn rb_tree_lcached_split
+ * @brief Same as rb_tree_split, keeping both halves' cached min current.
+ */
+void rb_tree_lcached_split(rb_tree_lcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_tree_lcached_t *left, rb_tree_lcached_t *right) {
+	RB_NULL_CHECK(tree);
+
+	rb_node_t *min = rb_min(tree);
+
+	rb_tree_split((rb_tree_t *) tree, key, cmp, (rb_tree_t *) left, (rb_tree_t *) right);
+	rb_min(tree) = NULL;
+
+	/* the old min heads whichever half isn't empty first; only the right half's min has to be looked up */
+	rb_min(left) = rb_is_empty(left) ? NULL : min;
+	rb_min(right) = rb_is_empty(right) ? NULL : (rb_is_empty(left) ? min : (rb_node_t *) rb_first((rb_tree_t *) right));
+}
+
+/**
+ * @fn rb_tree_rcached_split
+ * @brief Same as rb_tree_split, keeping both halves' cached max current.
+ */
+void rb_tree_rcached_split(rb_tree_rcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_tree_rcached_t *left, rb_tree_rcached_t *right) {
+	RB_NULL_CHECK(tree);
+
+	rb_node_t *max = rb_max(tree);
+
+	rb_tree_split((rb_tree_t *) tree, key, cmp, (rb_tree_t *) left, (rb_tree_t *) right);
+	rb_max(tree) = NULL;
+
+	rb_max(right) = rb_is_empty(right) ? NULL : max;
+	rb_max(left) = rb_is_empty(left) ? NULL : (rb_is_empty(right) ? max : (rb_node_t *) rb_last((rb_tree_t *) left));
+}
+
+/**
+ * @fn rb_tree_lrcached_split
+ * @brief Same as rb_tree_split, keeping both halves' cached min and max current.
+ */
+void rb_tree_lrcached_split(rb_tree_lrcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_tree_lrcached_t *left, rb_tree_lrcached_t *right) {
+	RB_NULL_CHECK(tree);
+
+	rb_node_t *min = rb_min(tree), *max = rb_max(tree);
+
+	rb_tree_split((rb_tree_t *) tree, key, cmp, (rb_tree_t *) left, (rb_tree_t *) right);
+	rb_min(tree) = rb_max(tree) = NULL;
+
+	if (rb_is_empty(left)) {
+		rb_min(left) = rb_max(left) = NULL;
+		rb_min(right) = min;
+		rb_max(right) = max;
+	} else if (rb_is_empty(right)) {
+		rb_min(left) = min;
+		rb_max(left) = max;
+		rb_min(right) = rb_max(right) = NULL;
+	} else {
+		rb_min(left) = min;
+		rb_max(left) = (rb_node_t *) rb_last((rb_tree_t *) left);
+		rb_min(right) = (rb_node_t *) rb_first((rb_tree_t *) right);
+		rb_max(right) = max;
+	}
+}
+
+/**
+ * @fn rb_tree_join
+ * @brief Joins left, pivot and right into left in O(log n). right comes out empty.
+ * @details Every node in left must sort no later than pivot, and pivot no later than every node in right; nothing
+ * is compared to check. The cost depends on how different the two trees' heights are, not on their sizes.
+ * @param[in] left Pointer to an rb_tree instance, which receives the result.
+ * @param[in] pivot Node not in any tree, or NULL to borrow right's first node as the pivot.
+ * @param[in] right Pointer to an rb_tree instance.
+ */
+void rb_tree_join(rb_tree_t *left, rb_node_t *pivot, rb_tree_t *right) {
+	RB_NULL_CHECK(left);
+	RB_NULL_CHECK(right);
+
+	size_t left_height = __rb_black_height(rb_root(left)), right_height = __rb_black_height(rb_root(right)), height;
+
+	/* plain concatenation: right's first node already sits between the two */
+	if (!pivot) rb_root(left) = __rb_join2(rb_root(left), left_height, rb_root(right), &height);
+	else rb_root(left) = __rb_join(rb_root(left), left_height, pivot, rb_root(right), right_height, &height);
+
+	rb_root(right) = NULL;
+}
+
+/**
+ * @fn rb_tree_lcached_join
+ * @brief Same as rb_tree_join, keeping the cached min current.
+ */
+void rb_tree_lcached_join(rb_tree_lcached_t *left, rb_node_t *pivot, rb_tree_lcached_t *right) {
+	RB_NULL_CHECK(left);
+	RB_NULL_CHECK(right);
+
+	/* the result's min is left's if it has one, and otherwise the pivot, borrowed from right or not */
+	rb_node_t *min = !rb_is_empty(left) ? rb_min(left) : (pivot ? pivot : rb_min(right));
+
+	rb_tree_join((rb_tree_t *) left, pivot, (rb_tree_t *) right);
+	rb_min(left) = min;
+	rb_min(right) = NULL;
+}
+
+/**
+ * @fn rb_tree_rcached_join
+ * @brief Same as rb_tree_join, keeping the cached max current.
+ */
+void rb_tree_rcached_join(rb_tree_rcached_t *left, rb_node_t *pivot, rb_tree_rcached_t *right) {
+	RB_NULL_CHECK(left);
+	RB_NULL_CHECK(right);
+
+	rb_node_t *max = !rb_is_empty(right) ? rb_max(right) : (pivot ? pivot : rb_max(left));
+
+	rb_tree_join((rb_tree_t *) left, pivot, (rb_tree_t *) right);
+	rb_max(left) = max;
+	rb_max(right) = NULL;
+}
+
+/**
+ * @fn rb_tree_lrcached_join
+ * @brief Same as rb_tree_join, keeping the cached min and max current.
+ */
+void rb_tree_lrcached_join(rb_tree_lrcached_t *left, rb_node_t *pivot, rb_tree_lrcached_t *right) {
+	RB_NULL_CHECK(left);
+	RB_NULL_CHECK(right);
+
+	rb_node_t *min = !rb_is_empty(left) ? rb_min(left) : (pivot ? pivot : rb_min(right));
+	rb_node_t *max = !rb_is_empty(right) ? rb_max(right) : (pivot ? pivot : rb_max(left));
+
+	rb_tree_join((rb_tree_t *) left, pivot, (rb_tree_t *) right);
+	rb_min(left) = min;
+	rb_max(left) = max;
+	rb_min(right) = rb_max(right) = NULL;
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_set_ops Set union, intersection and difference, built on split and join.
+ * @{
+ */
+
+/**
+ * @brief Everything a set operation needs that stays the same all the way down.
+ */
+typedef struct __rb_set_env {
+	int (*cmp)(const rb_node_t *left, const rb_node_t *right);
+	void (*cb)(rb_node_t *node);
+	const rb_fork_t *fork;
+} __rb_set_env_t;
+
+/**
+ * @brief One step of a set operation: combines a standalone subtree of a with a subtree of b, leaving the result in a.
+ */
+typedef struct __rb_set_task {
+	const __rb_set_env_t *env;
+	rb_node_t *a;
+	size_t a_height;
+	rb_node_t *b;
+	size_t b_height;
+	size_t depth;
+} __rb_set_task_t;
+
+/**
+ * @brief Disconnects every node of a standalone subtree and hands each one to cb, children first.
+ * @return Number of nodes dropped.
+ */
+static size_t __rb_set_drop(rb_node_t *node, void (*cb)(rb_node_t *node)) {
+	rb_node_t *left, *right;
+	size_t count;
+
+	if (!node) return 0;
+
+	/* read the links before cb gets a chance to free the node */
+	left = rb_left(node);
+	right = rb_right(node);
+	count = __rb_set_drop(left, cb) + __rb_set_drop(right, cb);
+
+	__rb_node_clear(node);
+	if (cb) cb(node);
+
+	return count + 1;
+}
+
+/**
+ * @brief Runs fn on both halves of a task, through the fork hook while the task is shallow enough, inline otherwise.
+ * @details The halves never share a node, so they're safe to run at the same time.
+ */
+static inline void __rb_set_both(void (*fn)(void *arg), const __rb_set_task_t *task, __rb_set_task_t *left, __rb_set_task_t *right) {
+	const rb_fork_t *fork = task->env->fork;
+
+	left->env = right->env = task->env;
+	left->depth = right->depth = task->depth + 1;
+
+	if (fork && fork->run && task->depth < fork->depth) {
+		fork->run(fn, left, right, fork->ctx);
+	} else {
+		fn(left);
+		fn(right);
+	}
+}
+
+/**
+ * @brief Union step: b's root splits a in two, each half of a is merged with the matching child of b, and the
+ * results are joined back around b's root, or around a's own copy of that key if it has one.
+ */
+static void __rb_set_union(void *arg) {
+	__rb_set_task_t *task = arg, left, right;
+	rb_node_t *pivot, *match;
+
+	if (!task->a) {
+		task->a = task->b;
+		task->a_height = task->b_height;
+		return;
+	}
+
+	if (!task->b) return;
+
+	pivot = task->b;
+	left.b_height = right.b_height = task->b_height - 1;
+	left.b = __rb_detach(rb_left(pivot), &left.b_height);
+	right.b = __rb_detach(rb_right(pivot), &right.b_height);
+
+	__rb_split(task->a, task->a_height, pivot, task->env->cmp, &left.a, &left.a_height, &right.a, &right.a_height, &match);
+	__rb_set_both(__rb_set_union, task, &left, &right);
+
+	/* a's node wins a tie, so b's is the one that goes */
+	if (match) {
+		__rb_node_clear(pivot);
+		if (task->env->cb) task->env->cb(pivot);
+		pivot = match;
+	}
+
+	task->a = __rb_join(left.a, left.a_height, pivot, right.a, right.a_height, &task->a_height);
+}
+
+/**
+ * @brief Intersection step: same as a union step, but only a's copy of b's root survives, and anything of a left
+ * facing an empty part of b goes.
+ */
+static void __rb_set_intersect(void *arg) {
+	__rb_set_task_t *task = arg, left, right;
+	rb_node_t *match;
+
+	if (!task->a) return;
+
+	if (!task->b) {
+		__rb_set_drop(task->a, task->env->cb);
+		task->a = NULL;
+		task->a_height = 0;
+		return;
+	}
+
+	/* b is only read, so its children are passed down as they are */
+	left.b = rb_left(task->b);
+	right.b = rb_right(task->b);
+
+	__rb_split(task->a, task->a_height, task->b, task->env->cmp, &left.a, &left.a_height, &right.a, &right.a_height, &match);
+	__rb_set_both(__rb_set_intersect, task, &left, &right);
+
+	if (match) task->a = __rb_join(left.a, left.a_height, match, right.a, right.a_height, &task->a_height);
+	else task->a = __rb_join2(left.a, left.a_height, right.a, &task->a_height);
+}
+
+/**
+ * @brief Difference step: a's copy of b's root goes, and the two halves are joined back together without it.
+ */
+static void __rb_set_difference(void *arg) {
+	__rb_set_task_t *task = arg, left, right;
+	rb_node_t *match;
+
+	if (!task->a || !task->b) return;
+
+	left.b = rb_left(task->b);
+	right.b = rb_right(task->b);
+
+	__rb_split(task->a, task->a_height, task->b, task->env->cmp, &left.a, &left.a_height, &right.a, &right.a_height, &match);
+
+	if (match) {
+		__rb_node_clear(match);
+		if (task->env->cb) task->env->cb(match);
+	}
+
+	__rb_set_both(__rb_set_difference, task, &left, &right);
+	task->a = __rb_join2(left.a, left.a_height, right.a, &task->a_height);
+}
+
+/**
+ * @brief Runs a set operation over two whole trees and returns the root of the result.
+ */
+static inline rb_node_t *__rb_set_run(void (*fn)(void *arg), rb_node_t *a, rb_node_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork) {
+	__rb_set_env_t env = { .cmp = cmp, .cb = cb, .fork = fork };
+	__rb_set_task_t task = {
+		.env = &env,
+		.a = a,
+		.a_height = __rb_black_height(a),
+		.b = b,
+		.b_height = __rb_black_height(b),
+		.depth = 0
+	};
+
+	fn(&task);
+	return task.a;
+}
+
+/* --- */
+
+/**
+ * @fn rb_tree_union
+ * @brief Moves every node of b whose key isn't already in a into a, in O(m log(n/m + 1)) for trees of m <= n nodes.
+ * @details Both trees must hold unique keys. Nodes are relinked, never copied or allocated, and b comes out empty.
+ * Where both trees hold a key, a's node stays and b's is disconnected and handed to cb.
+ * @param[in] a Pointer to an rb_tree instance, which receives the result.
+ * @param[in] b Pointer to an rb_tree instance ordered by the same comparator.
+ * @param[in] cmp Comparator callback both trees are ordered by.
+ * @param[in] cb Callback receiving each node left out, or NULL. It can run on several threads at once if fork is set.
+ * @param[in] fork Hook for running independent halves concurrently, or NULL to run everything on the calling thread.
+ */
+void rb_tree_union(rb_tree_t *a, rb_tree_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork) {
+	RB_NULL_CHECK(a);
+	RB_NULL_CHECK(b);
+	RB_NULL_CHECK(cmp);
+
+	rb_root(a) = __rb_set_run(__rb_set_union, rb_root(a), rb_root(b), cmp, cb, fork);
+	rb_root(b) = NULL;
+}
+
+/**
+ * @fn rb_tree_lcached_union
+ * @brief Same as rb_tree_union, keeping the cached min current.
+ */
+void rb_tree_lcached_union(rb_tree_lcached_t *a, rb_tree_lcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork) {
+	RB_NULL_CHECK(a);
+	RB_NULL_CHECK(b);
+
+	rb_tree_union((rb_tree_t *) a, (rb_tree_t *) b, cmp, cb, fork);
+	rb_min(a) = rb_is_empty(a) ? NULL : (rb_iterator_t) rb_first((rb_tree_t *) a);
+	rb_min(b) = NULL;
+}
+
+/**
+ * @fn rb_tree_rcached_union
+ * @brief Same as rb_tree_union, keeping the cached max current.
+ */
+void rb_tree_rcached_union(rb_tree_rcached_t *a, rb_tree_rcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork) {
+	RB_NULL_CHECK(a);
+	RB_NULL_CHECK(b);
+
+	rb_tree_union((rb_tree_t *) a, (rb_tree_t *) b, cmp, cb, fork);
+	rb_max(a) = rb_is_empty(a) ? NULL : (rb_iterator_t) rb_last((rb_tree_t *) a);
+	rb_max(b) = NULL;
+}
+
+/**
+ * @fn rb_tree_lrcached_union
+ * @brief Same as rb_tree_union, keeping the cached min and max current.
+ */
+void rb_tree_lrcached_union(rb_tree_lrcached_t *a, rb_tree_lrcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork) {
+	RB_NULL_CHECK(a);
+	RB_NULL_CHECK(b);
+
+	rb_tree_union((rb_tree_t *) a, (rb_tree_t *) b, cmp, cb, fork);
+	rb_min(a) = rb_is_empty(a) ? NULL : (rb_iterator_t) rb_first((rb_tree_t *) a);
+	rb_max(a) = rb_is_empty(a) ? NULL : (rb_iterator_t) rb_last((rb_tree_t *) a);
+	rb_min(b) = rb_max(b) = NULL;
+}
+
+/**
+ * @fn rb_tree_intersect
+ * @brief Drops every node of a whose key isn't in b, in O(m log(n/m + 1)) plus the nodes dropped.
+ * @details Both trees must hold unique keys. b is only read, so it stays as it is.
+ * @param[in] a Pointer to an rb_tree instance, which receives the result.
+ * @param[in] b Pointer to an rb_tree instance ordered by the same comparator.
+ * @param[in] cmp Comparator callback both trees are ordered by.
+ * @param[in] cb Callback receiving each node dropped from a, disconnected, or NULL. It can run on several threads
+ * at once if fork is set.
+ * @param[in] fork Hook for running independent halves concurrently, or NULL to run everything on the calling thread.
+ */
+void rb_tree_intersect(rb_tree_t *a, const rb_tree_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork) {
+	RB_NULL_CHECK(a);
+	RB_NULL_CHECK(b);
+	RB_NULL_CHECK(cmp);
+
+	rb_root(a) = __rb_set_run(__rb_set_intersect, rb_root(a), rb_root(b), cmp, cb, fork);
+}
+
+/**
+ * @fn rb_tree_lcached_intersect
+ * @brief Same as rb_tree_intersect, keeping the cached min current.
+ */
+void rb_tree_lcached_intersect(rb_tree_lcached_t *a, const rb_tree_lcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork) {
+	RB_NULL_CHECK(a);
+
+	rb_tree_intersect((rb_tree_t *) a, (const rb_tree_t *) b, cmp, cb, fork);
+	rb_min(a) = rb_is_empty(a) ? NULL : (rb_iterator_t) rb_first((rb_tree_t *) a);
+}
+
+/**
+ * @fn rb_tree_rcached_intersect
+ * @brief Same as rb_tree_intersect, keeping the cached max current.
+ */
+void rb_tree_rcached_intersect(rb_tree_rcached_t *a, const rb_tree_rcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork) {
+	RB_NULL_CHECK(a);
+
+	rb_tree_intersect((rb_tree_t *) a, (const rb_tree_t *) b, cmp, cb, fork);
+	rb_max(a) = rb_is_empty(a) ? NULL : (rb_iterator_t) rb_last((rb_tree_t *) a);
+}
+
+/**
+ * @fn rb_tree_lrcached_intersect
+ * @brief Same as rb_tree_intersect, keeping the cached min and max current.
+ */
+void rb_tree_lrcached_intersect(rb_tree_lrcached_t *a, const rb_tree_lrcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork) {
+	RB_NULL_CHECK(a);
+
+	rb_tree_intersect((rb_tree_t *) a, (const rb_tree_t *) b, cmp, cb, fork);
+	rb_min(a) = rb_is_empty(a) ? NULL : (rb_iterator_t) rb_first((rb_tree_t *) a);
+	rb_max(a) = rb_is_empty(a) ? NULL : (rb_iterator_t) rb_last((rb_tree_t *) a);
+}
+
+/**
+ * @fn rb_tree_difference
+ * @brief Drops every node of a whose key is also in b, in O(m log(n/m + 1)).
+ * @details Both trees must hold unique keys. b is only read, so it stays as it is.
+ * @param[in] a Pointer to an rb_tree instance, which receives the result.
+ * @param[in] b Pointer to an rb_tree instance ordered by the same comparator.
+ * @param[in] cmp Comparator callback both trees are ordered by.
+ * @param[in] cb Callback receiving each node dropped from a, disconnected, or NULL. It can run on several threads
+ * at once if fork is set.
+ * @param[in] fork Hook for running independent halves concurrently, or NULL to run everything on the calling thread.
+ */
+void rb_tree_difference(rb_tree_t *a, const rb_tree_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork) {
+	RB_NULL_CHECK(a);
+	RB_NULL_CHECK(b);
+	RB_NULL_CHECK(cmp);
+
+	rb_root(a) = __rb_set_run(__rb_set_difference, rb_root(a), rb_root(b), cmp, cb, fork);
+}
+
+/**
+ * @fn rb_tree_lcached_difference
+ * @brief Same as rb_tree_difference, keeping the cached min current.
+ */
+void rb_tree_lcached_difference(rb_tree_lcached_t *a, const rb_tree_lcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork) {
+	RB_NULL_CHECK(a);
+
+	rb_tree_difference((rb_tree_t *) a, (const rb_tree_t *) b, cmp, cb, fork);
+	rb_min(a) = rb_is_empty(a) ? NULL : (rb_iterator_t) rb_first((rb_tree_t *) a);
+}
+
+/**
+ * @fn rb_tree_rcached_difference
+ * @brief Same as rb_tree_difference, keeping the cached max current.
+ */
+void rb_tree_rcached_difference(rb_tree_rcached_t *a, const rb_tree_rcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork) {
+	RB_NULL_CHECK(a);
 
-    rb_tree_rcached_delete_at(tree, target, cmp, copy);
+	rb_tree_difference((rb_tree_t *) a, (const rb_tree_t *) b, cmp, cb, fork);
+	rb_max(a) = rb_is_empty(a) ? NULL : (rb_iterator_t) rb_last((rb_tree_t *) a);
 }
 
 /**
- * @fn rb_tree_lrcached_delete
- * @brief Deletes a node from an rbtree after finding it manually. Updates the min and the max.
+ * @fn rb_tree_lrcached_difference
+ * @brief Same as rb_tree_difference, keeping the cached min and max current.
+ */
+void rb_tree_lrcached_difference(rb_tree_lrcached_t *a, const rb_tree_lrcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork) {
+	RB_NULL_CHECK(a);
+
+	rb_tree_difference((rb_tree_t *) a, (const rb_tree_t *) b, cmp, cb, fork);
+	rb_min(a) = rb_is_empty(a) ? NULL : (rb_iterator_t) rb_first((rb_tree_t *) a);
+	rb_max(a) = rb_is_empty(a) ? NULL : (rb_iterator_t) rb_last((rb_tree_t *) a);
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_delete_range Removing a whole key range at once.
+ * @{
+ */
+
+/**
+ * @brief Cuts [lo, hi) out of the tree with two splits and a join, and returns the root of the part cut out.
+ * @details Nothing is touched if the range is empty.
+ */
+static inline rb_node_t *__rb_cut_range(rb_tree_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	rb_node_t *left, *middle, *right;
+	size_t left_height, middle_height, right_height, height;
+	const rb_node_t *first = rb_lower_bound(tree, lo, cmp);
+
+	/* a lookup is much cheaper than splitting and rejoining the whole search path for nothing */
+	if (!first || cmp(first, hi) >= 0) return NULL;
+
+	__rb_split(rb_root(tree), __rb_black_height(rb_root(tree)), lo, cmp, &left, &left_height, &middle, &middle_height, NULL);
+	__rb_split(middle, middle_height, hi, cmp, &middle, &middle_height, &right, &right_height, NULL);
+	rb_root(tree) = __rb_join2(left, left_height, right, &height);
+
+	return middle;
+}
+
+/* --- */
+
+/**
+ * @fn rb_tree_delete_range
+ * @brief Deletes every node in [lo, hi) in O(log n + k) for k nodes deleted, handing each one to a callback.
+ * @details The range is detached with two splits and one join, rather than k separate deletes, and only then walked
+ * to release its nodes. They come out disconnected, and the callback may free them. Not for augmented trees.
  * @param[in] tree Pointer to an rb_tree instance.
- * @param[in] node Iterator into the tree.
- * @param[in] hint Pointer to a valid rb.
- * @param[in] cmp Comparator callback used to traverse the tree.
- * @param[in] copy Copy callback used for successor node deletion.
+ * @param[in] lo Pointer to the node the range starts at, inclusive. It doesn't have to be in the tree.
+ * @param[in] hi Pointer to the node the range ends at, exclusive. It doesn't have to be in the tree.
+ * @param[in] cmp Comparator callback the tree is ordered by.
+ * @param[in] cb Callback receiving each deleted node, or NULL.
+ * @return Number of nodes deleted.
  */
-void rb_tree_lrcached_delete(rb_tree_lrcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*copy)(const rb_node_t *src, rb_node_t *dst)) {
-	RB_NULL_CHECK(tree);
-	RB_NULL_CHECK(node);
-	RB_NULL_CHECK(cmp);
-	RB_NULL_CHECK(copy);
+size_t rb_tree_delete_range(rb_tree_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node)) {
+	RB_NULL_CHECK(tree, 0);
+	RB_NULL_CHECK(lo, 0);
+	RB_NULL_CHECK(hi, 0);
+	RB_NULL_CHECK(cmp, 0);
 
-	rb_node_t *target;
+	return __rb_set_drop(__rb_cut_range(tree, lo, hi, cmp), cb);
+}
 
-	/* make sure the node exists */	
-    target = (rb_node_t *) rb_find((rb_tree_t *) tree, node, cmp);
-    RB_NULL_CHECK(target);
+/**
+ * @fn rb_tree_lcached_delete_range
+ * @brief Same as rb_tree_delete_range, keeping the cached min current.
+ */
+size_t rb_tree_lcached_delete_range(rb_tree_lcached_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node)) {
+	RB_NULL_CHECK(tree, 0);
+
+	rb_node_t *middle = __rb_cut_range((rb_tree_t *) tree, lo, hi, cmp);
+
+	/* the min only moves if it was part of the range, and the range has to be settled before cb can free it */
+	if (middle && cmp(rb_min(tree), lo) >= 0) rb_min(tree) = rb_is_empty(tree) ? NULL : (rb_iterator_t) rb_first((rb_tree_t *) tree);
+
+	return __rb_set_drop(middle, cb);
+}
+
+/**
+ * @fn rb_tree_rcached_delete_range
+ * @brief Same as rb_tree_delete_range, keeping the cached max current.
+ */
+size_t rb_tree_rcached_delete_range(rb_tree_rcached_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node)) {
+	RB_NULL_CHECK(tree, 0);
+
+	rb_node_t *middle = __rb_cut_range((rb_tree_t *) tree, lo, hi, cmp);
+
+	if (middle && cmp(rb_max(tree), hi) < 0) rb_max(tree) = rb_is_empty(tree) ? NULL : (rb_iterator_t) rb_last((rb_tree_t *) tree);
+
+	return __rb_set_drop(middle, cb);
+}
+
+/**
+ * @fn rb_tree_lrcached_delete_range
+ * @brief Same as rb_tree_delete_range, keeping the cached min and max current.
+ */
+size_t rb_tree_lrcached_delete_range(rb_tree_lrcached_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node)) {
+	RB_NULL_CHECK(tree, 0);
+
+	rb_node_t *middle = __rb_cut_range((rb_tree_t *) tree, lo, hi, cmp);
+
+	if (middle) {
+		if (cmp(rb_min(tree), lo) >= 0) rb_min(tree) = rb_is_empty(tree) ? NULL : (rb_iterator_t) rb_first((rb_tree_t *) tree);
+		if (cmp(rb_max(tree), hi) < 0) rb_max(tree) = rb_is_empty(tree) ? NULL : (rb_iterator_t) rb_last((rb_tree_t *) tree);
+	}
 
-    rb_tree_lrcached_delete_at(tree, target, cmp, copy);
+	return __rb_set_drop(middle, cb);
 }
 
 /** @} */
@@ -1072,6 +2524,451 @@ const rb_iterator_t rb_find(const rb_tree_t *tree, const rb_node_t *key, int (*c
     return __rb_find(rb_root(tree), key, cmp);
 }
 
+/**
+ * @brief Finds the first node that does not compare less than key. Returns NULL if there is none.
+ * @param[in] anchor Root of the subtree to search.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+static inline rb_iterator_t __rb_lower_bound(const rb_node_t *anchor, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(key, NULL);
+	RB_NULL_CHECK(cmp, NULL);
+
+	rb_iterator_t cursor = (rb_iterator_t) anchor;
+	rb_iterator_t bound = NULL;
+
+	/* same descent as __rb_find(), but an equal node doesn't stop it - there may be more of them to the left */
+	while (cursor != NULL) {
+		if (cmp(key, (const rb_node_t *) cursor) <= 0) {
+			bound = cursor;
+			cursor = rb_left(cursor);
+		} else {
+			cursor = rb_right(cursor);
+		}
+	}
+
+	return bound;
+}
+
+/**
+ * @brief Finds the first node that compares greater than key. Returns NULL if there is none.
+ * @param[in] anchor Root of the subtree to search.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+static inline rb_iterator_t __rb_upper_bound(const rb_node_t *anchor, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(key, NULL);
+	RB_NULL_CHECK(cmp, NULL);
+
+	rb_iterator_t cursor = (rb_iterator_t) anchor;
+	rb_iterator_t bound = NULL;
+
+	/* same as __rb_lower_bound(), except equal nodes are skipped over to the right */
+	while (cursor != NULL) {
+		if (cmp(key, (const rb_node_t *) cursor) < 0) {
+			bound = cursor;
+			cursor = rb_left(cursor);
+		} else {
+			cursor = rb_right(cursor);
+		}
+	}
+
+	return bound;
+}
+
+/* --- */
+
+/**
+ * @fn rb_lower_bound
+ * @brief Returns the first node that does not compare less than key, or NULL.
+ * @param[in] tree Root of the full tree to search.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+const rb_iterator_t rb_lower_bound(const rb_tree_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree, NULL);
+	return __rb_lower_bound(rb_root(tree), key, cmp);
+}
+
+/**
+ * @fn rb_lcached_lower_bound
+ * @brief Returns the first node that does not compare less than key, or NULL. Answers from the min if the key is at or below it.
+ * @param[in] tree Root of the full tree to search.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+const rb_iterator_t rb_lcached_lower_bound(const rb_tree_lcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree, NULL);
+	if (rb_is_empty(tree)) return NULL;
+
+	/* anything at or below the min is bounded by the min itself */
+	if (cmp(key, (const rb_node_t *) rb_min(tree)) <= 0) return rb_min(tree);
+
+	return __rb_lower_bound(rb_root(tree), key, cmp);
+}
+
+/**
+ * @fn rb_rcached_lower_bound
+ * @brief Returns the first node that does not compare less than key, or NULL. Answers from the max if the key is past it.
+ * @param[in] tree Root of the full tree to search.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+const rb_iterator_t rb_rcached_lower_bound(const rb_tree_rcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree, NULL);
+	if (rb_is_empty(tree)) return NULL;
+
+	/* nothing is at or past a key bigger than the max */
+	if (cmp(key, (const rb_node_t *) rb_max(tree)) > 0) return NULL;
+
+	return __rb_lower_bound(rb_root(tree), key, cmp);
+}
+
+/**
+ * @fn rb_lrcached_lower_bound
+ * @brief Combination of rb_lcached_lower_bound and rb_rcached_lower_bound.
+ * @param[in] tree Root of the full tree to search.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+const rb_iterator_t rb_lrcached_lower_bound(const rb_tree_lrcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree, NULL);
+	if (rb_is_empty(tree)) return NULL;
+
+	if (cmp(key, (const rb_node_t *) rb_min(tree)) <= 0) return rb_min(tree);
+	if (cmp(key, (const rb_node_t *) rb_max(tree)) > 0) return NULL;
+
+	return __rb_lower_bound(rb_root(tree), key, cmp);
+}
+
+/**
+ * @fn rb_upper_bound
+ * @brief Returns the first node that compares greater than key, or NULL.
+ * @param[in] tree Root of the full tree to search.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+const rb_iterator_t rb_upper_bound(const rb_tree_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree, NULL);
+	return __rb_upper_bound(rb_root(tree), key, cmp);
+}
+
+/**
+ * @fn rb_lcached_upper_bound
+ * @brief Returns the first node that compares greater than key, or NULL. Answers from the min if the key is below it.
+ * @param[in] tree Root of the full tree to search.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+const rb_iterator_t rb_lcached_upper_bound(const rb_tree_lcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree, NULL);
+	if (rb_is_empty(tree)) return NULL;
+
+	/* anything strictly below the min is bounded by the min itself */
+	if (cmp(key, (const rb_node_t *) rb_min(tree)) < 0) return rb_min(tree);
+
+	return __rb_upper_bound(rb_root(tree), key, cmp);
+}
+
+/**
+ * @fn rb_rcached_upper_bound
+ * @brief Returns the first node that compares greater than key, or NULL. Answers from the max if the key is at or past it.
+ * @param[in] tree Root of the full tree to search.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+const rb_iterator_t rb_rcached_upper_bound(const rb_tree_rcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree, NULL);
+	if (rb_is_empty(tree)) return NULL;
+
+	/* nothing is past a key at or above the max */
+	if (cmp(key, (const rb_node_t *) rb_max(tree)) >= 0) return NULL;
+
+	return __rb_upper_bound(rb_root(tree), key, cmp);
+}
+
+/**
+ * @fn rb_lrcached_upper_bound
+ * @brief Combination of rb_lcached_upper_bound and rb_rcached_upper_bound.
+ * @param[in] tree Root of the full tree to search.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+const rb_iterator_t rb_lrcached_upper_bound(const rb_tree_lrcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree, NULL);
+	if (rb_is_empty(tree)) return NULL;
+
+	if (cmp(key, (const rb_node_t *) rb_min(tree)) < 0) return rb_min(tree);
+	if (cmp(key, (const rb_node_t *) rb_max(tree)) >= 0) return NULL;
+
+	return __rb_upper_bound(rb_root(tree), key, cmp);
+}
+
+/**
+ * @fn rb_equal_range
+ * @brief Fetches the half-open range [first, last) of nodes comparing equal to key. A NULL last means the end of the tree.
+ * @param[in] tree Root of the full tree to search.
+ * @param[in] key Pointer to the node to be matched.
+ * @param[in] cmp Comparator callback used for the search.
+ * @param[out] first First node equal to key, or the upper bound if there are none.
+ * @param[out] last First node past the equal ones.
+ */
+void rb_equal_range(const rb_tree_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_iterator_t *first, rb_iterator_t *last) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(first);
+	RB_NULL_CHECK(last);
+
+	*first = rb_lower_bound(tree, key, cmp);
+	*last = rb_upper_bound(tree, key, cmp);
+}
+
+/**
+ * @fn rb_lcached_equal_range
+ * @brief Same as rb_equal_range, using the cached min to shortcut the bounds.
+ */
+void rb_lcached_equal_range(const rb_tree_lcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_iterator_t *first, rb_iterator_t *last) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(first);
+	RB_NULL_CHECK(last);
+
+	*first = rb_lcached_lower_bound(tree, key, cmp);
+	*last = rb_lcached_upper_bound(tree, key, cmp);
+}
+
+/**
+ * @fn rb_rcached_equal_range
+ * @brief Same as rb_equal_range, using the cached max to shortcut the bounds.
+ */
+void rb_rcached_equal_range(const rb_tree_rcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_iterator_t *first, rb_iterator_t *last) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(first);
+	RB_NULL_CHECK(last);
+
+	*first = rb_rcached_lower_bound(tree, key, cmp);
+	*last = rb_rcached_upper_bound(tree, key, cmp);
+}
+
+/**
+ * @fn rb_lrcached_equal_range
+ * @brief Same as rb_equal_range, using the cached min and max to shortcut the bounds.
+ */
+void rb_lrcached_equal_range(const rb_tree_lrcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_iterator_t *first, rb_iterator_t *last) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(first);
+	RB_NULL_CHECK(last);
+
+	*first = rb_lrcached_lower_bound(tree, key, cmp);
+	*last = rb_lrcached_upper_bound(tree, key, cmp);
+}
+
+/* --- */
+
+/**
+ * @brief Finds the first node not less than key, climbing from a hint at or after it instead of starting at the root.
+ * @details Each step up to an ancestor holding the anchor on its right costs one comparison. Once that ancestor is
+ * below the key, or there is none, everything from the key on down to the anchor sits in the anchor's left subtree.
+ */
+static inline const rb_node_t *__rb_lower_bound_before(const rb_node_t *anchor, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	for (;;) {
+		const rb_node_t *cursor = anchor;
+		const rb_node_t *bound = rb_parent(cursor);
+
+		/* the first ancestor with the anchor on its right is the lower edge of the anchor's subtree */
+		while (bound && cursor == rb_left(bound)) {
+			cursor = bound;
+			bound = rb_parent(bound);
+		}
+
+		if (!bound || cmp(bound, key) < 0) break;
+		anchor = bound;
+	}
+
+	/* the anchor isn't below the key, so it's the answer unless something to its left is too */
+	const rb_node_t *left = __rb_lower_bound(rb_left(anchor), key, cmp);
+	return left ? left : anchor;
+}
+
+/**
+ * @brief Finds the first node not less than key, climbing from a hint below it instead of starting at the root.
+ * @details Mirrors __rb_lower_bound_before: climb until the anchor's subtree is capped by something not less than the key.
+ */
+static inline const rb_node_t *__rb_lower_bound_after(const rb_node_t *anchor, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	const rb_node_t *cursor, *bound;
+
+	for (;;) {
+		cursor = anchor;
+		bound = rb_parent(cursor);
+
+		/* the first ancestor with the anchor on its left is the upper edge of the anchor's subtree */
+		while (bound && cursor == rb_right(bound)) {
+			cursor = bound;
+			bound = rb_parent(bound);
+		}
+
+		if (!bound || cmp(bound, key) >= 0) break;
+		anchor = bound;
+	}
+
+	/* the anchor is below the key, so the answer is to its right, or failing that the upper edge itself */
+	const rb_node_t *right = __rb_lower_bound(rb_right(anchor), key, cmp);
+	return right ? right : bound;
+}
+
+/**
+ * @fn rb_lower_bound_near
+ * @brief Same as rb_lower_bound, but starts from a node close to the answer instead of the root.
+ * @details Climbs from the hint only as far as the smallest subtree that must hold the answer, then descends.
+ * With only parent links to climb by, the climb has to reach the lowest common ancestor of hint and answer. When
+ * that ancestor is low, which is usual for an answer d positions away, the search costs O(log d) comparisons. It is
+ * still O(log n) in the worst case: neighbors on either side of the root share no ancestor below it, so a hint and
+ * an answer only two positions apart can cost a full descent plus the climb.
+ * @param[in] hint Valid iterator into the tree to search.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+const rb_iterator_t rb_lower_bound_near(const rb_iterator_t hint, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(hint, NULL);
+	RB_NULL_CHECK(key, NULL);
+	RB_NULL_CHECK(cmp, NULL);
+
+	/* which way to climb depends on which side of the hint the key falls */
+	if (cmp(hint, key) < 0) return (rb_iterator_t) __rb_lower_bound_after(hint, key, cmp);
+	return (rb_iterator_t) __rb_lower_bound_before(hint, key, cmp);
+}
+
+/**
+ * @fn rb_find_near
+ * @brief Same as rb_find, but starts from a node close to the answer instead of the root. See rb_lower_bound_near.
+ * @param[in] hint Valid iterator into the tree to search.
+ * @param[in] key Pointer to the node to be found.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+const rb_iterator_t rb_find_near(const rb_iterator_t hint, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(hint, NULL);
+	RB_NULL_CHECK(key, NULL);
+	RB_NULL_CHECK(cmp, NULL);
+
+	/* the first node not below the key is the only candidate for a match */
+	rb_iterator_t bound = rb_lower_bound_near(hint, key, cmp);
+	return (bound && cmp(bound, key) == 0) ? bound : NULL;
+}
+
+/* --- */
+
+/**
+ * @brief Binary search for a node matching a bare key. Returns NULL if not found.
+ * @param[in] anchor Root of the subtree to search.
+ * @param[in] key Pointer to the key to be found.
+ * @param[in] cmp_key Callback comparing the key against a node.
+ */
+static inline rb_iterator_t __rb_find_key(const rb_node_t *anchor, const void *key, int (*cmp_key)(const void *key, const rb_node_t *node)) {
+	RB_NULL_CHECK(cmp_key, NULL);
+
+	rb_iterator_t cursor = (rb_iterator_t) anchor;
+
+	/* same traversal as __rb_find(), just against the key itself */
+	while (cursor != NULL) {
+		int comparison = cmp_key(key, (const rb_node_t *) cursor);
+		if (comparison < 0) {			/* left */
+			cursor = rb_left(cursor);
+		} else if (comparison == 0) {	/* equal */
+			break;
+		} else {						/* right */
+			cursor = rb_right(cursor);
+		}
+	}
+
+	return cursor;
+}
+
+/**
+ * @brief Finds the first node that does not compare less than key. Returns NULL if there is none.
+ * @param[in] anchor Root of the subtree to search.
+ * @param[in] key Pointer to the key to be bounded.
+ * @param[in] cmp_key Callback comparing the key against a node.
+ */
+static inline rb_iterator_t __rb_lower_bound_key(const rb_node_t *anchor, const void *key, int (*cmp_key)(const void *key, const rb_node_t *node)) {
+	RB_NULL_CHECK(cmp_key, NULL);
+
+	rb_iterator_t cursor = (rb_iterator_t) anchor;
+	rb_iterator_t bound = NULL;
+
+	/* every node at or past the key is a candidate, and the best one is the last we see on the way down */
+	while (cursor != NULL) {
+		if (cmp_key(key, (const rb_node_t *) cursor) <= 0) {
+			bound = cursor;
+			cursor = rb_left(cursor);
+		} else {
+			cursor = rb_right(cursor);
+		}
+	}
+
+	return bound;
+}
+
+/**
+ * @brief Finds the first node that compares greater than key. Returns NULL if there is none.
+ * @param[in] anchor Root of the subtree to search.
+ * @param[in] key Pointer to the key to be bounded.
+ * @param[in] cmp_key Callback comparing the key against a node.
+ */
+static inline rb_iterator_t __rb_upper_bound_key(const rb_node_t *anchor, const void *key, int (*cmp_key)(const void *key, const rb_node_t *node)) {
+	RB_NULL_CHECK(cmp_key, NULL);
+
+	rb_iterator_t cursor = (rb_iterator_t) anchor;
+	rb_iterator_t bound = NULL;
+
+	/* same as __rb_lower_bound_key(), except equal nodes are skipped over to the right */
+	while (cursor != NULL) {
+		if (cmp_key(key, (const rb_node_t *) cursor) < 0) {
+			bound = cursor;
+			cursor = rb_left(cursor);
+		} else {
+			cursor = rb_right(cursor);
+		}
+	}
+
+	return bound;
+}
+
+/* --- */
+
+/**
+ * @fn rb_find_key
+ * @brief Binary search to find a node matching a bare key. Returns NULL if not found.
+ * @param[in] tree Root of the full tree to search.
+ * @param[in] key Pointer to the key to be found.
+ * @param[in] cmp_key Callback comparing the key against a node.
+ */
+const rb_iterator_t rb_find_key(const rb_tree_t *tree, const void *key, int (*cmp_key)(const void *key, const rb_node_t *node)) {
+	RB_NULL_CHECK(tree, NULL);
+	return __rb_find_key(rb_root(tree), key, cmp_key);
+}
+
+/**
+ * @fn rb_lower_bound_key
+ * @brief Returns the first node that does not compare less than key, or NULL.
+ * @param[in] tree Root of the full tree to search.
+ * @param[in] key Pointer to the key to be bounded.
+ * @param[in] cmp_key Callback comparing the key against a node.
+ */
+const rb_iterator_t rb_lower_bound_key(const rb_tree_t *tree, const void *key, int (*cmp_key)(const void *key, const rb_node_t *node)) {
+	RB_NULL_CHECK(tree, NULL);
+	return __rb_lower_bound_key(rb_root(tree), key, cmp_key);
+}
+
+/**
+ * @fn rb_upper_bound_key
+ * @brief Returns the first node that compares greater than key, or NULL.
+ * @param[in] tree Root of the full tree to search.
+ * @param[in] key Pointer to the key to be bounded.
+ * @param[in] cmp_key Callback comparing the key against a node.
+ */
+const rb_iterator_t rb_upper_bound_key(const rb_tree_t *tree, const void *key, int (*cmp_key)(const void *key, const rb_node_t *node)) {
+	RB_NULL_CHECK(tree, NULL);
+	return __rb_upper_bound_key(rb_root(tree), key, cmp_key);
+}
+
 /** @} */
 
 /**
@@ -1181,6 +3078,89 @@ const rb_iterator_t rb_prev(const rb_iterator_t node) {
     return cursor_parent;
 }
 
+/* --- */
+
+/**
+ * @fn rb_range_init
+ * @brief Sets up a range to walk every node in [lo, hi) in order.
+ * @details Finding the edges costs two descents; each step after that is an amortized O(1) rb_next.
+ * @param[out] range Range to set up.
+ * @param[in] tree Root of the full tree to walk.
+ * @param[in] lo Inclusive lower edge, or NULL to start at the first node.
+ * @param[in] hi Exclusive upper edge, or NULL to run to the last node.
+ * @param[in] cmp Comparator callback used to find the edges.
+ */
+void rb_range_init(rb_range_t *range, const rb_tree_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(range);
+	RB_NULL_CHECK(tree);
+
+	range->cursor = lo ? rb_lower_bound(tree, lo, cmp) : rb_first(tree);
+	range->end = hi ? rb_lower_bound(tree, hi, cmp) : NULL;
+
+	/* an inverted or empty window has nothing in it */
+	if (lo && hi && cmp(lo, hi) >= 0) range->cursor = range->end;
+}
+
+/**
+ * @fn rb_lcached_range_init
+ * @brief Same as rb_range_init, using the cached min to find the lower edge.
+ */
+void rb_lcached_range_init(rb_range_t *range, const rb_tree_lcached_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(range);
+	RB_NULL_CHECK(tree);
+
+	range->cursor = lo ? rb_lcached_lower_bound(tree, lo, cmp) : rb_min(tree);
+	range->end = hi ? rb_lcached_lower_bound(tree, hi, cmp) : NULL;
+
+	/* an inverted or empty window has nothing in it */
+	if (lo && hi && cmp(lo, hi) >= 0) range->cursor = range->end;
+}
+
+/**
+ * @fn rb_rcached_range_init
+ * @brief Same as rb_range_init, using the cached max to find the upper edge.
+ */
+void rb_rcached_range_init(rb_range_t *range, const rb_tree_rcached_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(range);
+	RB_NULL_CHECK(tree);
+
+	range->cursor = lo ? rb_rcached_lower_bound(tree, lo, cmp) : rb_first((const rb_tree_t *) tree);
+	range->end = hi ? rb_rcached_lower_bound(tree, hi, cmp) : NULL;
+
+	/* an inverted or empty window has nothing in it */
+	if (lo && hi && cmp(lo, hi) >= 0) range->cursor = range->end;
+}
+
+/**
+ * @fn rb_lrcached_range_init
+ * @brief Same as rb_range_init, using the cached min and max to find the edges.
+ */
+void rb_lrcached_range_init(rb_range_t *range, const rb_tree_lrcached_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(range);
+	RB_NULL_CHECK(tree);
+
+	range->cursor = lo ? rb_lrcached_lower_bound(tree, lo, cmp) : rb_min(tree);
+	range->end = hi ? rb_lrcached_lower_bound(tree, hi, cmp) : NULL;
+
+	/* an inverted or empty window has nothing in it */
+	if (lo && hi && cmp(lo, hi) >= 0) range->cursor = range->end;
+}
+
+/**
+ * @fn rb_range_next
+ * @brief Returns the next node in the range and steps past it, or NULL once the range is used up.
+ * @param[in] range Range set up by one of the rb_*range_init functions.
+ */
+const rb_iterator_t rb_range_next(rb_range_t *range) {
+	RB_NULL_CHECK(range, NULL);
+
+	rb_iterator_t node = range->cursor;
+	if (node == range->end) return NULL;
+
+	range->cursor = rb_next(node);
+	return node;
+}
+
 /** @} */
 
 /**
@@ -1188,6 +3168,200 @@ const rb_iterator_t rb_prev(const rb_iterator_t node) {
  * @{
  */
 
+/** The node isn't below lo, so its left subtree can still hold nodes in range. */
+#define RB_WALK_PAST_LO										(1u << 0)
+
+/** The node is below hi, so its right subtree can still hold nodes in range. */
+#define RB_WALK_BEFORE_HI									(1u << 1)
+
+/** The node itself is in range. */
+#define RB_WALK_IN_RANGE									(RB_WALK_PAST_LO | RB_WALK_BEFORE_HI)
+
+/* --- */
+
+/**
+ * @brief Places a node against the range [lo, hi), where a NULL bound is open.
+ * @return Some combination of RB_WALK_PAST_LO and RB_WALK_BEFORE_HI.
+ */
+static inline unsigned __rb_walk_bounds(const rb_node_t *node, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	unsigned bounds = 0;
+
+	if (!lo || cmp(node, lo) >= 0) bounds |= RB_WALK_PAST_LO;
+	if (!hi || cmp(node, hi) < 0) bounds |= RB_WALK_BEFORE_HI;
+
+	return bounds;
+}
+
+/**
+ * @brief Iterative in-order walk over a subtree, stopping as soon as cb returns nonzero.
+ * @details Every node's links are read before cb sees it.
+ * @return Whatever cb returned to stop the walk, or 0 if it ran to the end.
+ */
+static inline int __rb_inorder_walk(rb_node_t *anchor, int (*cb)(rb_node_t *node, void *ctx), void *ctx) {
+	rb_node_t *stack[RB_WALK_STACK], *cursor = anchor, *node;
+	size_t top = 0;
+	int result;
+
+	for (;;) {
+		while (cursor) {
+			stack[top++] = cursor;
+			cursor = rb_left(cursor);
+		}
+
+		if (top == 0) return 0;
+		node = stack[--top];
+		cursor = rb_right(node);
+
+		if ((result = cb(node, ctx))) return result;
+	}
+}
+
+/**
+ * @brief Same as __rb_inorder_walk, only visiting the nodes in [lo, hi). A NULL bound is open.
+ */
+static int __rb_inorder_walk_range(rb_node_t *anchor, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), int (*cb)(rb_node_t *node, void *ctx), void *ctx) {
+	rb_node_t *stack[RB_WALK_STACK], *cursor = anchor, *node;
+	size_t top = 0;
+	int result;
+
+	for (;;) {
+
+		/* nodes below lo take their whole left subtree with them */
+		while (cursor) {
+			if (lo && cmp(cursor, lo) < 0) {
+				cursor = rb_right(cursor);
+				continue;
+			}
+
+			stack[top++] = cursor;
+			cursor = rb_left(cursor);
+		}
+
+		if (top == 0) return 0;
+		node = stack[--top];
+
+		/* in order, the first node at or past hi ends the walk */
+		if (hi && cmp(node, hi) >= 0) return 0;
+
+		/* everything from here on sorts after a node already in range, so lo is settled */
+		lo = NULL;
+		cursor = rb_right(node);
+
+		if ((result = cb(node, ctx))) return result;
+	}
+}
+
+/**
+ * @brief Iterative pre-order walk over a subtree, stopping as soon as cb returns nonzero.
+ * @details Every node's links are read before cb sees it.
+ * @return Whatever cb returned to stop the walk, or 0 if it ran to the end.
+ */
+static inline int __rb_preorder_walk(rb_node_t *anchor, int (*cb)(rb_node_t *node, void *ctx), void *ctx) {
+	rb_node_t *stack[RB_WALK_STACK], *cursor = anchor, *left;
+	size_t top = 0;
+	int result;
+
+	for (;;) {
+
+		/* visit on the way down the left spine, leaving each right child for later */
+		while (cursor) {
+			left = rb_left(cursor);
+			if (rb_right(cursor)) stack[top++] = rb_right(cursor);
+
+			if ((result = cb(cursor, ctx))) return result;
+			cursor = left;
+		}
+
+		if (top == 0) return 0;
+		cursor = stack[--top];
+	}
+}
+
+/**
+ * @brief Same as __rb_preorder_walk, only visiting the nodes in [lo, hi). A NULL bound is open.
+ * @details Subtrees that can't reach the range are skipped, but the nodes in it still come in pre-order.
+ */
+static int __rb_preorder_walk_range(rb_node_t *anchor, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), int (*cb)(rb_node_t *node, void *ctx), void *ctx) {
+	rb_node_t *stack[RB_WALK_STACK + 1], *node;
+	size_t top = 0;
+	unsigned bounds;
+	int result;
+
+	if (anchor) stack[top++] = anchor;
+
+	while (top) {
+		node = stack[--top];
+		bounds = __rb_walk_bounds(node, lo, hi, cmp);
+
+		if ((bounds & RB_WALK_BEFORE_HI) && rb_right(node)) stack[top++] = rb_right(node);
+		if ((bounds & RB_WALK_PAST_LO) && rb_left(node)) stack[top++] = rb_left(node);
+
+		if (bounds == RB_WALK_IN_RANGE && (result = cb(node, ctx))) return result;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Iterative post-order walk over a subtree, stopping as soon as cb returns nonzero.
+ * @details A node is never touched again once cb has seen it, so cb may free it.
+ * @return Whatever cb returned to stop the walk, or 0 if it ran to the end.
+ */
+static inline int __rb_postorder_walk(rb_node_t *anchor, int (*cb)(rb_node_t *node, void *ctx), void *ctx) {
+	rb_node_t *stack[RB_WALK_STACK], *cursor = anchor, *node;
+	size_t top = 0;
+	int result;
+
+	for (;;) {
+
+		/* head for the first node in post-order under cursor: left whenever possible, right otherwise */
+		while (cursor) {
+			stack[top++] = cursor;
+			cursor = rb_left(cursor) ? rb_left(cursor) : rb_right(cursor);
+		}
+
+		if (top == 0) return 0;
+		node = stack[--top];
+
+		/* a left child's parent still has its right subtree to go; a right child's parent is next itself */
+		if (top && node == rb_left(stack[top - 1])) cursor = rb_right(stack[top - 1]);
+
+		if ((result = cb(node, ctx))) return result;
+	}
+}
+
+/**
+ * @brief Same as __rb_postorder_walk, only visiting the nodes in [lo, hi). A NULL bound is open.
+ * @details Each node's place against the range is kept on the stack next to it, so it's only compared once.
+ */
+static int __rb_postorder_walk_range(rb_node_t *anchor, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), int (*cb)(rb_node_t *node, void *ctx), void *ctx) {
+	rb_node_t *stack[RB_WALK_STACK], *cursor = anchor, *node;
+	unsigned char bounds[RB_WALK_STACK];
+	size_t top = 0;
+	unsigned visit;
+	int result;
+
+	for (;;) {
+		while (cursor) {
+			unsigned b = __rb_walk_bounds(cursor, lo, hi, cmp);
+
+			stack[top] = cursor;
+			bounds[top++] = (unsigned char) b;
+
+			if ((b & RB_WALK_PAST_LO) && rb_left(cursor)) cursor = rb_left(cursor);
+			else cursor = (b & RB_WALK_BEFORE_HI) ? rb_right(cursor) : NULL;
+		}
+
+		if (top == 0) return 0;
+		node = stack[--top];
+		visit = bounds[top];
+
+		if (top && node == rb_left(stack[top - 1]) && (bounds[top - 1] & RB_WALK_BEFORE_HI)) cursor = rb_right(stack[top - 1]);
+
+		if (visit == RB_WALK_IN_RANGE && (result = cb(node, ctx))) return result;
+	}
+}
+
 /**
  * @brief Performs an in-order traversal of the tree and applies cb to its subtrees recursively.
  * @param[in] anchor Subtree to traverse.
@@ -1271,4 +3445,315 @@ void rb_postorder_foreach(rb_tree_t *tree, void (*cb)(rb_node_t *key)) {
     __rb_postorder_foreach(rb_root(tree), cb);
 }
 
+/**
+ * @fn rb_inorder_walk
+ * @brief Calls cb on every node in order, with a context pointer, until it returns nonzero.
+ * @details Runs without recursion on a fixed-size stack, so it's reentrant and can't overflow on a deep tree.
+ * cb may free the node it's given, but not change the tree in any other way.
+ * @param[in] tree Full tree to traverse.
+ * @param[in] cb Function to apply to each node. Returning nonzero stops the walk.
+ * @param[in] ctx Passed through to cb.
+ * @return Whatever cb returned to stop the walk, or 0 if every node was visited.
+ */
+int rb_inorder_walk(rb_tree_t *tree, int (*cb)(rb_node_t *node, void *ctx), void *ctx) {
+	RB_NULL_CHECK(tree, 0);
+	RB_NULL_CHECK(cb, 0);
+
+	return __rb_inorder_walk(rb_root(tree), cb, ctx);
+}
+
+/**
+ * @fn rb_preorder_walk
+ * @brief Same as rb_inorder_walk, in pre-order.
+ */
+int rb_preorder_walk(rb_tree_t *tree, int (*cb)(rb_node_t *node, void *ctx), void *ctx) {
+	RB_NULL_CHECK(tree, 0);
+	RB_NULL_CHECK(cb, 0);
+
+	return __rb_preorder_walk(rb_root(tree), cb, ctx);
+}
+
+/**
+ * @fn rb_postorder_walk
+ * @brief Same as rb_inorder_walk, in post-order. A node is never touched after cb sees it.
+ */
+int rb_postorder_walk(rb_tree_t *tree, int (*cb)(rb_node_t *node, void *ctx), void *ctx) {
+	RB_NULL_CHECK(tree, 0);
+	RB_NULL_CHECK(cb, 0);
+
+	return __rb_postorder_walk(rb_root(tree), cb, ctx);
+}
+
+/**
+ * @fn rb_inorder_walk_range
+ * @brief Same as rb_inorder_walk, only visiting the nodes in [lo, hi), in O(log n + k) for k nodes visited.
+ * @param[in] tree Full tree to traverse.
+ * @param[in] lo Pointer to the node the range starts at, inclusive, or NULL to start at the first node.
+ * @param[in] hi Pointer to the node the range ends at, exclusive, or NULL to run to the last node.
+ * @param[in] cmp Comparator callback the tree is ordered by.
+ * @param[in] cb Function to apply to each node. Returning nonzero stops the walk.
+ * @param[in] ctx Passed through to cb.
+ * @return Whatever cb returned to stop the walk, or 0 if every node in range was visited.
+ */
+int rb_inorder_walk_range(rb_tree_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), int (*cb)(rb_node_t *node, void *ctx), void *ctx) {
+	RB_NULL_CHECK(tree, 0);
+	RB_NULL_CHECK(cmp, 0);
+	RB_NULL_CHECK(cb, 0);
+
+	return __rb_inorder_walk_range(rb_root(tree), lo, hi, cmp, cb, ctx);
+}
+
+/**
+ * @fn rb_preorder_walk_range
+ * @brief Same as rb_inorder_walk_range, in pre-order. Subtrees entirely outside the range are skipped.
+ */
+int rb_preorder_walk_range(rb_tree_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), int (*cb)(rb_node_t *node, void *ctx), void *ctx) {
+	RB_NULL_CHECK(tree, 0);
+	RB_NULL_CHECK(cmp, 0);
+	RB_NULL_CHECK(cb, 0);
+
+	return __rb_preorder_walk_range(rb_root(tree), lo, hi, cmp, cb, ctx);
+}
+
+/**
+ * @fn rb_postorder_walk_range
+ * @brief Same as rb_inorder_walk_range, in post-order. Subtrees entirely outside the range are skipped.
+ */
+int rb_postorder_walk_range(rb_tree_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), int (*cb)(rb_node_t *node, void *ctx), void *ctx) {
+	RB_NULL_CHECK(tree, 0);
+	RB_NULL_CHECK(cmp, 0);
+	RB_NULL_CHECK(cb, 0);
+
+	return __rb_postorder_walk_range(rb_root(tree), lo, hi, cmp, cb, ctx);
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_augmented Augmented red-black tree functions (callbacks supplied by the caller, see rbtree_augmented.h).
+ * @{
+ */
+
+/**
+ * @fn rb_insert_augmented
+ * @brief Augmented counterpart of rb_insert_color: fixes up the path above a node linked in with rb_link_node, then rebalances.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Freshly linked node.
+ * @param[in] aug Augmentation callbacks for the tree.
+ */
+void rb_insert_augmented(rb_tree_t *tree, rb_node_t *node, const rb_augment_t *aug) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(node);
+	RB_NULL_CHECK(aug);
+
+	/* every subtree on the way down gained the node, then the rotations shuffle values locally */
+	aug->propagate(node, NULL);
+	__rb_insert_rebalance(tree, node, aug);
+}
+
+/**
+ * @fn rb_tree_augmented_insert
+ * @brief Inserts a node into an augmented rb_tree, guided by a comparator.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Pointer to an rb_node instance embedded in something else.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ * @param[in] aug Augmentation callbacks for the tree.
+ */
+void rb_tree_augmented_insert(rb_tree_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), const rb_augment_t *aug) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(node);
+	RB_NULL_CHECK(cmp);
+	RB_NULL_CHECK(aug);
+
+	/* the node needs to be fresh and must not come in corrupted */
+	__rb_node_init(node);
+
+	if (rb_is_empty(tree)) {
+		rb_root(tree) = node;
+		__rb_set_parent_and_color(node, NULL, RB_BLACK);
+		aug->propagate(node, NULL);
+		return;
+	}
+
+	__rb_insert_basic(rb_root(tree), node, cmp);
+	rb_insert_augmented(tree, node, aug);
+}
+
+/**
+ * @fn rb_tree_augmented_delete_at
+ * @brief Deletes a node from an augmented rb_tree at an iterator.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Iterator into the tree.
+ * @param[in] aug Augmentation callbacks for the tree.
+ */
+void rb_tree_augmented_delete_at(rb_tree_t *tree, rb_iterator_t node, const rb_augment_t *aug) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(node);
+	RB_NULL_CHECK(aug);
+
+	__rb_erase(tree, node, aug);
+}
+
+/**
+ * @fn rb_replace_node_augmented
+ * @brief Same as rb_replace_node, then recomputes the replacement's augmented value and whatever depends on it above.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] victim Node in the tree.
+ * @param[in] replacement Node not in any tree.
+ * @param[in] aug Augmentation callbacks for the tree.
+ */
+void rb_replace_node_augmented(rb_tree_t *tree, rb_node_t *victim, rb_node_t *replacement, const rb_augment_t *aug) {
+	RB_NULL_CHECK(aug);
+
+	/* the key is the same, but the rest of the payload feeding the augmented value may not be */
+	rb_replace_node(tree, victim, replacement);
+	aug->propagate(replacement, NULL);
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_order_statistic Order-statistic tree functions (subtree sizes kept in rb_os_node_t).
+ * @{
+ */
+
+/**
+ * @brief A node's subtree size, from its children's.
+ */
+#define __rb_os_compute(os)		(rb_os_size(rb_left(&(os)->node)) + rb_os_size(rb_right(&(os)->node)) + 1)
+
+RB_DECLARE_AUGMENT(static, __rb_os_augment, rb_os_node_t, node, size, __rb_os_compute)
+
+/* --- */
+
+/**
+ * @fn rb_tree_os_insert
+ * @brief Inserts an order-statistic node into an rb_tree, guided by a comparator, and keeps subtree sizes current.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_os_node_t nodes.
+ * @param[in] node Pointer to an rb_os_node instance embedded in something else.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+void rb_tree_os_insert(rb_tree_t *tree, rb_os_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(node);
+
+	rb_tree_augmented_insert(tree, &node->node, cmp, &__rb_os_augment);
+}
+
+/**
+ * @fn rb_tree_os_delete_at
+ * @brief Deletes an order-statistic node from an rb_tree at an iterator, and keeps subtree sizes current.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_os_node_t nodes.
+ * @param[in] node Iterator into the tree.
+ */
+void rb_tree_os_delete_at(rb_tree_t *tree, rb_iterator_t node) {
+	rb_tree_augmented_delete_at(tree, node, &__rb_os_augment);
+}
+
+/**
+ * @fn rb_tree_os_delete
+ * @brief Deletes an order-statistic node from an rb_tree after finding it manually.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_os_node_t nodes.
+ * @param[in] node Pointer to a node with the key to be deleted.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+void rb_tree_os_delete(rb_tree_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	RB_NULL_CHECK(tree);
+	RB_NULL_CHECK(node);
+	RB_NULL_CHECK(cmp);
+
+	rb_node_t *target;
+
+	/* make sure the node exists */	
+	target = (rb_node_t *) rb_find(tree, node, cmp);
+	RB_NULL_CHECK(target);
+
+	rb_tree_os_delete_at(tree, target);
+}
+
+/**
+ * @fn rb_tree_os_replace_node
+ * @brief Same as rb_replace_node for an order-statistic tree, carrying the victim's subtree size over.
+ * @details rb_replace_node copies only the links, which would leave the replacement's size stale and throw off
+ * rb_rank, rb_select and rb_count_range for everything above it.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_os_node_t nodes.
+ * @param[in] victim Node in the tree.
+ * @param[in] replacement Node not in any tree.
+ */
+void rb_tree_os_replace_node(rb_tree_t *tree, rb_os_node_t *victim, rb_os_node_t *replacement) {
+	RB_NULL_CHECK(victim);
+	RB_NULL_CHECK(replacement);
+
+	/* the shape doesn't change, so neither does any subtree's size - only which node holds it */
+	replacement->size = victim->size;
+	rb_replace_node(tree, &victim->node, &replacement->node);
+}
+
+/**
+ * @fn rb_rank
+ * @brief Returns the 0-based in-order position of a node in its order-statistic tree.
+ * @param[in] node Valid iterator into the tree.
+ */
+size_t rb_rank(const rb_iterator_t node) {
+	RB_NULL_CHECK(node, 0);
+
+	rb_iterator_t cursor, cursor_parent;
+	size_t rank = rb_os_size(rb_left(node));
+
+	/* every time we climb up from a right child, the parent and its left subtree come before us too */
+	cursor = node;
+	cursor_parent = rb_parent(cursor);
+	while (cursor_parent != NULL) {
+		if (cursor == rb_right(cursor_parent)) rank += rb_os_size(rb_left(cursor_parent)) + 1;
+
+		cursor = cursor_parent;
+		cursor_parent = rb_parent(cursor);
+	}
+
+	return rank;
+}
+
+/**
+ * @fn rb_select
+ * @brief Returns the node at 0-based in-order position k of an order-statistic tree, or NULL if k is out of range.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_os_node_t nodes.
+ * @param[in] k Position to fetch.
+ */
+const rb_iterator_t rb_select(const rb_tree_t *tree, size_t k) {
+	RB_NULL_CHECK(tree, NULL);
+
+	rb_iterator_t cursor = rb_root(tree);
+
+	/* the left subtree's size says which side of the cursor position k falls on */
+	while (cursor != NULL) {
+		size_t left_size = rb_os_size(rb_left(cursor));
+
+		if (k < left_size) {
+			cursor = rb_left(cursor);
+		} else if (k == left_size) {
+			break;
+		} else {
+			k -= left_size + 1;
+			cursor = rb_right(cursor);
+		}
+	}
+
+	return cursor;
+}
+
+/**
+ * @fn rb_count_range
+ * @brief Counts the nodes in [lo, hi) of an order-statistic tree.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_os_node_t nodes.
+ * @param[in] lo First node of the range, or NULL to count from the first node.
+ * @param[in] hi First node past the range, or NULL to count through the last node.
+ */
+size_t rb_count_range(const rb_tree_t *tree, const rb_iterator_t lo, const rb_iterator_t hi) {
+	RB_NULL_CHECK(tree, 0);
+
+	size_t lo_rank = lo ? rb_rank(lo) : 0;
+	size_t hi_rank = hi ? rb_rank(hi) : rb_os_size(rb_root(tree));
+
+	return (hi_rank > lo_rank) ? hi_rank - lo_rank : 0;
+}
+
 /** @} */
@@ -99,6 +99,51 @@ typedef struct rb_tree_lrcached {
     rb_iterator_t max;
 } rb_tree_lrcached_t;
 
+/**
+ * @struct rb_os_node
+ * @brief Order-statistic red-black tree node, for trees that need rank and select.
+ * @details Comparators, iterators and the rest of the API all see the embedded rb_node; only the rb_tree_os_* 
+ * mutators keep the sizes up to date, so a tree must stick to those once it is made of these nodes.
+ * @var rb_os_node::node
+ * The tree links themselves.
+ * @var rb_os_node::size
+ * Number of nodes in the subtree rooted here, including this one.
+ */
+typedef struct rb_os_node {
+	rb_node_t node;
+	size_t size;
+} rb_os_node_t;
+
+/**
+ * @struct rb_range
+ * @brief Cursor over the half-open range of nodes [cursor, end), set up by rb_range_init and walked with rb_range_next.
+ * @var rb_range::cursor
+ * Next node to be returned.
+ * @var rb_range::end
+ * First node past the range, or NULL if the range runs to the end of the tree.
+ */
+typedef struct rb_range {
+	rb_iterator_t cursor;
+	rb_iterator_t end;
+} rb_range_t;
+
+/**
+ * @struct rb_fork
+ * @brief Hook that lets the set operations run their two independent halves at the same time, on the caller's threads.
+ * @var rb_fork::run
+ * Calls fn(left) and fn(right), in any order or concurrently, and returns once both have returned. The simplest
+ * version hands one call to another thread, makes the other itself, then waits. Nested calls can happen.
+ * @var rb_fork::ctx
+ * Passed through to run, e.g. the caller's thread pool.
+ * @var rb_fork::depth
+ * Recursion levels to fork at before running inline, so at most 2^depth tasks are ever in flight.
+ */
+typedef struct rb_fork {
+	void (*run)(void (*fn)(void *arg), void *left, void *right, void *ctx);
+	void *ctx;
+	size_t depth;
+} rb_fork_t;
+
 /**
  * @cond PRIVATE
  * @brief Private macros used for the general purpose ones defined in @ref rb_macros "rb_macros".
@@ -149,6 +194,12 @@ typedef struct rb_tree_lrcached {
  * @brief Tree interface macros to fetch the min, max, or the tree instance itself, if they exist.
  */
 
+/**
+ * Deepest a walk's explicit stack can get. A red-black tree of n nodes is at most 2 * log2(n + 1) tall, and n can't
+ * come anywhere near 2^64 nodes, so this covers any tree that fits in memory.
+ */
+#define RB_WALK_STACK										(2 * 8 * sizeof(uintptr_t))
+
 /** Fetches the root node of the tree. */
 #define rb_root(tree)        								((tree)->root)
 
@@ -203,6 +254,27 @@ typedef struct rb_tree_lrcached {
 /** Returns true if rb loops back on itself and is isolated from all other nodes. */
 #define rb_is_disconnected(rb)								(rb_parent((rb)) == (rb) && !rb_left(rb) && !rb_right(rb))
 
+/** 
+ * Hangs rb as a red leaf under parent at *link, which must be the empty child slot of parent 
+ * found by a descent (or the root slot if parent is NULL). Follow up with rb_insert_color.
+ */
+#define rb_link_node(rb, parent, link)						({														\
+																(rb)->__rb_parent_color = (uintptr_t) (parent);		\
+																rb_left(rb) = NULL;									\
+																rb_right(rb) = NULL;								\
+																*(link) = (rb);										\
+															})
+
+/**
+ * @brief Order-statistic node macros to reach the subtree size behind an rb_node.
+ */
+
+/** Returns the rb_os_node containing rb. */
+#define rb_os_entry(rb)										container_of(rb, rb_os_node_t, node)
+
+/** Returns the number of nodes in the subtree rooted at rb, which is 0 for a NULL leaf. */
+#define rb_os_size(rb)										((size_t) ((rb) ? rb_os_entry(rb)->size : 0))
+
 /**
  * @brief Intrustive node macros to access the containing object of an rb_node.
  */
@@ -301,6 +373,14 @@ void rb_tree_rcached_insert_at(rb_tree_rcached_t *tree, rb_node_t *node, rb_iter
  */
 void rb_tree_lrcached_insert_at(rb_tree_lrcached_t *tree, rb_node_t *node, rb_iterator_t hint, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
 
+/**
+ * @fn rb_insert_color
+ * @brief Rebalances the tree after a node has been linked in with rb_link_node.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Freshly linked node.
+ */
+void rb_insert_color(rb_tree_t *tree, rb_node_t *node);
+
 /**
  * @fn rb_tree_insert
  * @brief Inserts a node into an rb_tree, guided by a comparator.
@@ -337,49 +417,184 @@ void rb_tree_rcached_insert(rb_tree_rcached_t *tree, rb_node_t *node, int (*cmp)
  */
 void rb_tree_lrcached_insert(rb_tree_lrcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
 
+/**
+ * @fn rb_tree_insert_unique
+ * @brief Inserts a node into an rb_tree unless a node with an equal key is already there, in a single descent.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Pointer to an rb_node instance embedded in something else.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ * @param[out] existing If not NULL, set to the node that blocked the insert, or NULL if node went in.
+ * @return True if node was inserted, false if an equal key was found instead.
+ */
+bool rb_tree_insert_unique(rb_tree_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_node_t **existing);
+
+/**
+ * @fn rb_tree_lcached_insert_unique
+ * @brief Same as rb_tree_insert_unique, keeping the cached min current.
+ */
+bool rb_tree_lcached_insert_unique(rb_tree_lcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_node_t **existing);
+
+/**
+ * @fn rb_tree_rcached_insert_unique
+ * @brief Same as rb_tree_insert_unique, keeping the cached max current.
+ */
+bool rb_tree_rcached_insert_unique(rb_tree_rcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_node_t **existing);
+
+/**
+ * @fn rb_tree_lrcached_insert_unique
+ * @brief Same as rb_tree_insert_unique, keeping the cached min and max current.
+ */
+bool rb_tree_lrcached_insert_unique(rb_tree_lrcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_node_t **existing);
+
+/**
+ * @fn rb_tree_find_or_insert
+ * @brief Returns the node in an rb_tree whose key equals node's, inserting node first if there is none, in a single descent.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Pointer to an rb_node instance embedded in something else.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ * @return The node already in the tree, or node itself if it was just inserted.
+ */
+rb_node_t *rb_tree_find_or_insert(rb_tree_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_tree_lcached_find_or_insert
+ * @brief Same as rb_tree_find_or_insert, keeping the cached min current.
+ */
+rb_node_t *rb_tree_lcached_find_or_insert(rb_tree_lcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_tree_rcached_find_or_insert
+ * @brief Same as rb_tree_find_or_insert, keeping the cached max current.
+ */
+rb_node_t *rb_tree_rcached_find_or_insert(rb_tree_rcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_tree_lrcached_find_or_insert
+ * @brief Same as rb_tree_find_or_insert, keeping the cached min and max current.
+ */
+rb_node_t *rb_tree_lrcached_find_or_insert(rb_tree_lrcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_tree_insert_batch
+ * @brief Inserts n nodes into an rb_tree, sorting them first so that each descent starts from the previous insertion.
+ * @details Nodes close together in key order only pay for the distance between them instead of a full descent from the root.
+ * Equal keys end up in the same order as if the nodes had been inserted one at a time, front to back.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] nodes Array of n nodes in any order. The array itself is left as is.
+ * @param[in] n Number of nodes.
+ * @param[in] cmp Comparator callback used to sort the batch and traverse the tree.
+ */
+void rb_tree_insert_batch(rb_tree_t *tree, rb_node_t **nodes, size_t n, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_tree_lcached_insert_batch
+ * @brief Same as rb_tree_insert_batch, keeping the cached min current.
+ */
+void rb_tree_lcached_insert_batch(rb_tree_lcached_t *tree, rb_node_t **nodes, size_t n, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_tree_rcached_insert_batch
+ * @brief Same as rb_tree_insert_batch, keeping the cached max current.
+ */
+void rb_tree_rcached_insert_batch(rb_tree_rcached_t *tree, rb_node_t **nodes, size_t n, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_tree_lrcached_insert_batch
+ * @brief Same as rb_tree_insert_batch, keeping the cached min and max current.
+ */
+void rb_tree_lrcached_insert_batch(rb_tree_lrcached_t *tree, rb_node_t **nodes, size_t n, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_tree_build_sorted
+ * @brief Links an array of nodes, already in sorted order, into a balanced rb_tree in O(n) without comparing anything.
+ * @details Whatever the tree held before is dropped. Equal neighbors are fine and keep their order, same as rb_tree_insert.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] nodes Array of n nodes, in the order the tree's comparator would put them.
+ * @param[in] n Number of nodes.
+ */
+void rb_tree_build_sorted(rb_tree_t *tree, rb_node_t **nodes, size_t n);
+
+/**
+ * @fn rb_tree_lcached_build_sorted
+ * @brief Same as rb_tree_build_sorted, also setting the cached min.
+ */
+void rb_tree_lcached_build_sorted(rb_tree_lcached_t *tree, rb_node_t **nodes, size_t n);
+
+/**
+ * @fn rb_tree_rcached_build_sorted
+ * @brief Same as rb_tree_build_sorted, also setting the cached max.
+ */
+void rb_tree_rcached_build_sorted(rb_tree_rcached_t *tree, rb_node_t **nodes, size_t n);
+
+/**
+ * @fn rb_tree_lrcached_build_sorted
+ * @brief Same as rb_tree_build_sorted, also setting the cached min and max.
+ */
+void rb_tree_lrcached_build_sorted(rb_tree_lrcached_t *tree, rb_node_t **nodes, size_t n);
+
+/**
+ * @fn rb_tree_build_sorted_list
+ * @brief Links a list of nodes, already in sorted order, into a balanced rb_tree in O(n) without comparing anything.
+ * @details The list is threaded through the nodes' own right pointers and ends at NULL, so it needs no storage of its own.
+ * Whatever the tree held before is dropped.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] head First node of the list, or NULL for an empty tree.
+ */
+void rb_tree_build_sorted_list(rb_tree_t *tree, rb_node_t *head);
+
+/**
+ * @fn rb_tree_lcached_build_sorted_list
+ * @brief Same as rb_tree_build_sorted_list, also setting the cached min.
+ */
+void rb_tree_lcached_build_sorted_list(rb_tree_lcached_t *tree, rb_node_t *head);
+
+/**
+ * @fn rb_tree_rcached_build_sorted_list
+ * @brief Same as rb_tree_build_sorted_list, also setting the cached max.
+ */
+void rb_tree_rcached_build_sorted_list(rb_tree_rcached_t *tree, rb_node_t *head);
+
+/**
+ * @fn rb_tree_lrcached_build_sorted_list
+ * @brief Same as rb_tree_build_sorted_list, also setting the cached min and max.
+ */
+void rb_tree_lrcached_build_sorted_list(rb_tree_lrcached_t *tree, rb_node_t *head);
+
 /**
  * @fn rb_tree_delete_at
  * @brief Deletes a node from a rbtree at an iterator.
+ * @details The node is spliced out by relinking pointers, so every other node keeps its address and payload.
  * @param[in] tree Pointer to an rb_tree instance.
  * @param[in] node Iterator into the tree.
- * @param[in] hint Pointer to a valid rb.
- * @param[in] cmp Comparator callback used to traverse the tree.
- * @param[in] copy Copy callback used for successor node deletion.
  */
-void rb_tree_delete_at(rb_tree_t *tree, rb_iterator_t node, void (*copy)(const rb_node_t *src, rb_node_t *dst));
+void rb_tree_delete_at(rb_tree_t *tree, rb_iterator_t node);
 
 /**
  * @fn rb_tree_lcached_delete_at
  * @brief Deletes a node from a rbtree at an iterator. Updates the min.
  * @param[in] tree Pointer to an rb_tree instance.
  * @param[in] node Iterator into the tree.
- * @param[in] hint Pointer to a valid rb.
- * @param[in] cmp Comparator callback used to traverse the tree.
- * @param[in] copy Copy callback used for successor node deletion.
+ * @param[in] cmp Unused; the min is tracked by identity. Kept for API compatibility.
  */
-void rb_tree_lcached_delete_at(rb_tree_lcached_t *tree, rb_iterator_t node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*copy)(const rb_node_t *src, rb_node_t *dst));
+void rb_tree_lcached_delete_at(rb_tree_lcached_t *tree, rb_iterator_t node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
 
 /**
  * @fn rb_tree_rcached_delete_at
  * @brief Deletes a node from a rbtree at an iterator. Updates the max.
  * @param[in] tree Pointer to an rb_tree instance.
  * @param[in] node Iterator into the tree.
- * @param[in] hint Pointer to a valid rb.
- * @param[in] cmp Comparator callback used to traverse the tree.
- * @param[in] copy Copy callback used for successor node deletion.
+ * @param[in] cmp Unused; the max is tracked by identity. Kept for API compatibility.
  */
-void rb_tree_rcached_delete_at(rb_tree_rcached_t *tree, rb_iterator_t node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*copy)(const rb_node_t *src, rb_node_t *dst));
+void rb_tree_rcached_delete_at(rb_tree_rcached_t *tree, rb_iterator_t node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
 
 /**
  * @fn rb_tree_lrcached_delete_at
  * @brief Deletes a node from a rbtree at an iterator. Updates the min and the max.
  * @param[in] tree Pointer to an rb_tree instance.
  * @param[in] node Iterator into the tree.
- * @param[in] hint Pointer to a valid rb.
- * @param[in] cmp Comparator callback used to traverse the tree.
- * @param[in] copy Copy callback used for successor node deletion.
+ * @param[in] cmp Unused; the min and max are tracked by identity. Kept for API compatibility.
  */
-void rb_tree_lrcached_delete_at(rb_tree_lrcached_t *tree, rb_iterator_t node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*copy)(const rb_node_t *src, rb_node_t *dst));
+void rb_tree_lrcached_delete_at(rb_tree_lrcached_t *tree, rb_iterator_t node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
 
 /**
  * @fn rb_tree_delete
@@ -388,9 +603,8 @@ void rb_tree_lrcached_delete_at(rb_tree_lrcached_t *tree, rb_iterator_t node, in
  * @param[in] node Iterator into the tree.
  * @param[in] hint Pointer to a valid rb.
  * @param[in] cmp Comparator callback used to traverse the tree.
- * @param[in] copy Copy callback used for successor node deletion.
  */
-void rb_tree_delete(rb_tree_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*copy)(const rb_node_t *src, rb_node_t *dst));
+void rb_tree_delete(rb_tree_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
 
 /**
  * @fn rb_tree_lcached_delete
@@ -399,9 +613,8 @@ void rb_tree_delete(rb_tree_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t
  * @param[in] node Iterator into the tree.
  * @param[in] hint Pointer to a valid rb.
  * @param[in] cmp Comparator callback used to traverse the tree.
- * @param[in] copy Copy callback used for successor node deletion.
  */
-void rb_tree_lcached_delete(rb_tree_lcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*copy)(const rb_node_t *src, rb_node_t *dst));
+void rb_tree_lcached_delete(rb_tree_lcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
 
 /**
  * @fn rb_tree_rcached_delete
@@ -410,9 +623,8 @@ void rb_tree_lcached_delete(rb_tree_lcached_t *tree, rb_node_t *node, int (*cmp)
  * @param[in] node Iterator into the tree.
  * @param[in] hint Pointer to a valid rb.
  * @param[in] cmp Comparator callback used to traverse the tree.
- * @param[in] copy Copy callback used for successor node deletion.
  */
-void rb_tree_rcached_delete(rb_tree_rcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*copy)(const rb_node_t *src, rb_node_t *dst));
+void rb_tree_rcached_delete(rb_tree_rcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
 
 /**
  * @fn rb_tree_lrcached_delete
@@ -421,9 +633,254 @@ void rb_tree_rcached_delete(rb_tree_rcached_t *tree, rb_node_t *node, int (*cmp)
  * @param[in] node Iterator into the tree.
  * @param[in] hint Pointer to a valid rb.
  * @param[in] cmp Comparator callback used to traverse the tree.
- * @param[in] copy Copy callback used for successor node deletion.
  */
-void rb_tree_lrcached_delete(rb_tree_lrcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*copy)(const rb_node_t *src, rb_node_t *dst));
+void rb_tree_lrcached_delete(rb_tree_lrcached_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_delete_key
+ * @brief Deletes a node matching a bare key from an rbtree.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] key Pointer to the key to be deleted.
+ * @param[in] cmp_key Callback comparing the key against a node, ordered the same way as the tree.
+ * @return The unlinked node, or NULL if nothing matched.
+ */
+rb_node_t *rb_delete_key(rb_tree_t *tree, const void *key, int (*cmp_key)(const void *key, const rb_node_t *node));
+
+/**
+ * @fn rb_lcached_pop_min
+ * @brief Unlinks and returns the min of a min-cached tree, or NULL if it's empty.
+ * @details The min's successor becomes the new min, so there is no comparison and no walk down from the root.
+ * @param[in] tree Pointer to an rb_tree instance.
+ */
+rb_node_t *rb_lcached_pop_min(rb_tree_lcached_t *tree);
+
+/**
+ * @fn rb_lcached_pop_until
+ * @brief Unlinks every node that doesn't compare greater than key, in order, handing each one to a callback.
+ * @details Nodes are unlinked before the callback sees them, so it may free or reinsert them. Anything reinserted
+ * at or below key is popped again.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] key Pointer to the node to drain up to, inclusive.
+ * @param[in] cmp Comparator callback the tree is ordered by.
+ * @param[in] cb Callback receiving each unlinked node, or NULL.
+ * @return Number of nodes unlinked.
+ */
+size_t rb_lcached_pop_until(rb_tree_lcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node));
+
+/**
+ * @fn rb_replace_node
+ * @brief Puts replacement into victim's exact position in O(1), without comparing or rebalancing anything.
+ * @details The replacement must sort the same as the victim, so this suits updating a record whose key hasn't changed.
+ * The victim comes out disconnected. Not for order-statistic trees, whose sizes it leaves stale; use
+ * rb_tree_os_replace_node there.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] victim Node in the tree.
+ * @param[in] replacement Node not in any tree.
+ */
+void rb_replace_node(rb_tree_t *tree, rb_node_t *victim, rb_node_t *replacement);
+
+/**
+ * @fn rb_lcached_replace_node
+ * @brief Same as rb_replace_node, keeping the cached min current.
+ */
+void rb_lcached_replace_node(rb_tree_lcached_t *tree, rb_node_t *victim, rb_node_t *replacement);
+
+/**
+ * @fn rb_rcached_replace_node
+ * @brief Same as rb_replace_node, keeping the cached max current.
+ */
+void rb_rcached_replace_node(rb_tree_rcached_t *tree, rb_node_t *victim, rb_node_t *replacement);
+
+/**
+ * @fn rb_lrcached_replace_node
+ * @brief Same as rb_replace_node, keeping the cached min and max current.
+ */
+void rb_lrcached_replace_node(rb_tree_lrcached_t *tree, rb_node_t *victim, rb_node_t *replacement);
+
+/**
+ * @fn rb_tree_split
+ * @brief Moves the nodes of a tree comparing less than key into left and the rest into right, in O(log n).
+ * @details Nodes are relinked, never copied, and key is compared once per level. tree comes out empty, unless it's also passed
+ * as left or right, and whatever left and right held before is dropped.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] key Pointer to the node to split at. It doesn't have to be in the tree.
+ * @param[in] cmp Comparator callback the tree is ordered by.
+ * @param[out] left Pointer to an rb_tree instance receiving the nodes less than key.
+ * @param[out] right Pointer to an rb_tree instance receiving the rest.
+ */
+void rb_tree_split(rb_tree_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_tree_t *left, rb_tree_t *right);
+
+/**
+ * @fn rb_tree_lcached_split
+ * @brief Same as rb_tree_split, keeping both halves' cached min current.
+ */
+void rb_tree_lcached_split(rb_tree_lcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_tree_lcached_t *left, rb_tree_lcached_t *right);
+
+/**
+ * @fn rb_tree_rcached_split
+ * @brief Same as rb_tree_split, keeping both halves' cached max current.
+ */
+void rb_tree_rcached_split(rb_tree_rcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_tree_rcached_t *left, rb_tree_rcached_t *right);
+
+/**
+ * @fn rb_tree_lrcached_split
+ * @brief Same as rb_tree_split, keeping both halves' cached min and max current.
+ */
+void rb_tree_lrcached_split(rb_tree_lrcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_tree_lrcached_t *left, rb_tree_lrcached_t *right);
+
+/**
+ * @fn rb_tree_join
+ * @brief Joins left, pivot and right into left in O(log n). right comes out empty.
+ * @details Every node in left must sort no later than pivot, and pivot no later than every node in right; nothing
+ * is compared to check. The cost depends on how different the two trees' heights are, not on their sizes.
+ * @param[in] left Pointer to an rb_tree instance, which receives the result.
+ * @param[in] pivot Node not in any tree, or NULL to borrow right's first node as the pivot.
+ * @param[in] right Pointer to an rb_tree instance.
+ */
+void rb_tree_join(rb_tree_t *left, rb_node_t *pivot, rb_tree_t *right);
+
+/**
+ * @fn rb_tree_lcached_join
+ * @brief Same as rb_tree_join, keeping the cached min current.
+ */
+void rb_tree_lcached_join(rb_tree_lcached_t *left, rb_node_t *pivot, rb_tree_lcached_t *right);
+
+/**
+ * @fn rb_tree_rcached_join
+ * @brief Same as rb_tree_join, keeping the cached max current.
+ */
+void rb_tree_rcached_join(rb_tree_rcached_t *left, rb_node_t *pivot, rb_tree_rcached_t *right);
+
+/**
+ * @fn rb_tree_lrcached_join
+ * @brief Same as rb_tree_join, keeping the cached min and max current.
+ */
+void rb_tree_lrcached_join(rb_tree_lrcached_t *left, rb_node_t *pivot, rb_tree_lrcached_t *right);
+
+/**
+ * @fn rb_tree_union
+ * @brief Moves every node of b whose key isn't already in a into a, in O(m log(n/m + 1)) for trees of m <= n nodes.
+ * @details Both trees must hold unique keys. Nodes are relinked, never copied or allocated, and b comes out empty.
+ * Where both trees hold a key, a's node stays and b's is disconnected and handed to cb.
+ * @param[in] a Pointer to an rb_tree instance, which receives the result.
+ * @param[in] b Pointer to an rb_tree instance ordered by the same comparator.
+ * @param[in] cmp Comparator callback both trees are ordered by.
+ * @param[in] cb Callback receiving each node left out, or NULL. It can run on several threads at once if fork is set.
+ * @param[in] fork Hook for running independent halves concurrently, or NULL to run everything on the calling thread.
+ */
+void rb_tree_union(rb_tree_t *a, rb_tree_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork);
+
+/**
+ * @fn rb_tree_lcached_union
+ * @brief Same as rb_tree_union, keeping the cached min current.
+ */
+void rb_tree_lcached_union(rb_tree_lcached_t *a, rb_tree_lcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork);
+
+/**
+ * @fn rb_tree_rcached_union
+ * @brief Same as rb_tree_union, keeping the cached max current.
+ */
+void rb_tree_rcached_union(rb_tree_rcached_t *a, rb_tree_rcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork);
+
+/**
+ * @fn rb_tree_lrcached_union
+ * @brief Same as rb_tree_union, keeping the cached min and max current.
+ */
+void rb_tree_lrcached_union(rb_tree_lrcached_t *a, rb_tree_lrcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork);
+
+/**
+ * @fn rb_tree_intersect
+ * @brief Drops every node of a whose key isn't in b, in O(m log(n/m + 1)) plus the nodes dropped.
+ * @details Both trees must hold unique keys. b is only read, so it stays as it is.
+ * @param[in] a Pointer to an rb_tree instance, which receives the result.
+ * @param[in] b Pointer to an rb_tree instance ordered by the same comparator.
+ * @param[in] cmp Comparator callback both trees are ordered by.
+ * @param[in] cb Callback receiving each node dropped from a, disconnected, or NULL. It can run on several threads
+ * at once if fork is set.
+ * @param[in] fork Hook for running independent halves concurrently, or NULL to run everything on the calling thread.
+ */
+void rb_tree_intersect(rb_tree_t *a, const rb_tree_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork);
+
+/**
+ * @fn rb_tree_lcached_intersect
+ * @brief Same as rb_tree_intersect, keeping the cached min current.
+ */
+void rb_tree_lcached_intersect(rb_tree_lcached_t *a, const rb_tree_lcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork);
+
+/**
+ * @fn rb_tree_rcached_intersect
+ * @brief Same as rb_tree_intersect, keeping the cached max current.
+ */
+void rb_tree_rcached_intersect(rb_tree_rcached_t *a, const rb_tree_rcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork);
+
+/**
+ * @fn rb_tree_lrcached_intersect
+ * @brief Same as rb_tree_intersect, keeping the cached min and max current.
+ */
+void rb_tree_lrcached_intersect(rb_tree_lrcached_t *a, const rb_tree_lrcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork);
+
+/**
+ * @fn rb_tree_difference
+ * @brief Drops every node of a whose key is also in b, in O(m log(n/m + 1)).
+ * @details Both trees must hold unique keys. b is only read, so it stays as it is.
+ * @param[in] a Pointer to an rb_tree instance, which receives the result.
+ * @param[in] b Pointer to an rb_tree instance ordered by the same comparator.
+ * @param[in] cmp Comparator callback both trees are ordered by.
+ * @param[in] cb Callback receiving each node dropped from a, disconnected, or NULL. It can run on several threads
+ * at once if fork is set.
+ * @param[in] fork Hook for running independent halves concurrently, or NULL to run everything on the calling thread.
+ */
+void rb_tree_difference(rb_tree_t *a, const rb_tree_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork);
+
+/**
+ * @fn rb_tree_lcached_difference
+ * @brief Same as rb_tree_difference, keeping the cached min current.
+ */
+void rb_tree_lcached_difference(rb_tree_lcached_t *a, const rb_tree_lcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork);
+
+/**
+ * @fn rb_tree_rcached_difference
+ * @brief Same as rb_tree_difference, keeping the cached max current.
+ */
+void rb_tree_rcached_difference(rb_tree_rcached_t *a, const rb_tree_rcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork);
+
+/**
+ * @fn rb_tree_lrcached_difference
+ * @brief Same as rb_tree_difference, keeping the cached min and max current.
+ */
+void rb_tree_lrcached_difference(rb_tree_lrcached_t *a, const rb_tree_lrcached_t *b, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node), const rb_fork_t *fork);
+
+/**
+ * @fn rb_tree_delete_range
+ * @brief Deletes every node in [lo, hi) in O(log n + k) for k nodes deleted, handing each one to a callback.
+ * @details The range is detached with two splits and one join, rather than k separate deletes, and only then walked
+ * to release its nodes. They come out disconnected, and the callback may free them. Not for augmented trees.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] lo Pointer to the node the range starts at, inclusive. It doesn't have to be in the tree.
+ * @param[in] hi Pointer to the node the range ends at, exclusive. It doesn't have to be in the tree.
+ * @param[in] cmp Comparator callback the tree is ordered by.
+ * @param[in] cb Callback receiving each deleted node, or NULL.
+ * @return Number of nodes deleted.
+ */
+size_t rb_tree_delete_range(rb_tree_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node));
+
+/**
+ * @fn rb_tree_lcached_delete_range
+ * @brief Same as rb_tree_delete_range, keeping the cached min current.
+ */
+size_t rb_tree_lcached_delete_range(rb_tree_lcached_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node));
+
+/**
+ * @fn rb_tree_rcached_delete_range
+ * @brief Same as rb_tree_delete_range, keeping the cached max current.
+ */
+size_t rb_tree_rcached_delete_range(rb_tree_rcached_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node));
+
+/**
+ * @fn rb_tree_lrcached_delete_range
+ * @brief Same as rb_tree_delete_range, keeping the cached min and max current.
+ */
+size_t rb_tree_lrcached_delete_range(rb_tree_lrcached_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), void (*cb)(rb_node_t *node));
 
 /**
  * @fn rb_find
@@ -434,6 +891,140 @@ void rb_tree_lrcached_delete(rb_tree_lrcached_t *tree, rb_node_t *node, int (*cm
  */
 const rb_iterator_t rb_find(const rb_tree_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
 
+/**
+ * @fn rb_lower_bound
+ * @brief Returns an iterator to the first node that does not compare less than key, or NULL.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+const rb_iterator_t rb_lower_bound(const rb_tree_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_lcached_lower_bound
+ * @brief Same as rb_lower_bound. Keys at or below the min are answered without a descent.
+ */
+const rb_iterator_t rb_lcached_lower_bound(const rb_tree_lcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_rcached_lower_bound
+ * @brief Same as rb_lower_bound. Keys past the max are answered without a descent.
+ */
+const rb_iterator_t rb_rcached_lower_bound(const rb_tree_rcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_lrcached_lower_bound
+ * @brief Combination of rb_lcached_lower_bound and rb_rcached_lower_bound.
+ */
+const rb_iterator_t rb_lrcached_lower_bound(const rb_tree_lrcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_upper_bound
+ * @brief Returns an iterator to the first node that compares greater than key, or NULL.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+const rb_iterator_t rb_upper_bound(const rb_tree_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_lcached_upper_bound
+ * @brief Same as rb_upper_bound. Keys below the min are answered without a descent.
+ */
+const rb_iterator_t rb_lcached_upper_bound(const rb_tree_lcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_rcached_upper_bound
+ * @brief Same as rb_upper_bound. Keys at or past the max are answered without a descent.
+ */
+const rb_iterator_t rb_rcached_upper_bound(const rb_tree_rcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_lrcached_upper_bound
+ * @brief Combination of rb_lcached_upper_bound and rb_rcached_upper_bound.
+ */
+const rb_iterator_t rb_lrcached_upper_bound(const rb_tree_lrcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_equal_range
+ * @brief Fetches the half-open range [first, last) of nodes comparing equal to key. A NULL last means the end of the tree.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] key Pointer to the node to be matched.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ * @param[out] first First node equal to key, or the upper bound if there are none.
+ * @param[out] last First node past the equal ones.
+ */
+void rb_equal_range(const rb_tree_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_iterator_t *first, rb_iterator_t *last);
+
+/**
+ * @fn rb_lcached_equal_range
+ * @brief Same as rb_equal_range, using the cached min to shortcut the bounds.
+ */
+void rb_lcached_equal_range(const rb_tree_lcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_iterator_t *first, rb_iterator_t *last);
+
+/**
+ * @fn rb_rcached_equal_range
+ * @brief Same as rb_equal_range, using the cached max to shortcut the bounds.
+ */
+void rb_rcached_equal_range(const rb_tree_rcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_iterator_t *first, rb_iterator_t *last);
+
+/**
+ * @fn rb_lrcached_equal_range
+ * @brief Same as rb_equal_range, using the cached min and max to shortcut the bounds.
+ */
+void rb_lrcached_equal_range(const rb_tree_lrcached_t *tree, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_iterator_t *first, rb_iterator_t *last);
+
+/**
+ * @fn rb_lower_bound_near
+ * @brief Same as rb_lower_bound, but starts from a node close to the answer instead of the root.
+ * @details Climbs from the hint only as far as the smallest subtree that must hold the answer, then descends.
+ * With only parent links to climb by, the climb has to reach the lowest common ancestor of hint and answer. When
+ * that ancestor is low, which is usual for an answer d positions away, the search costs O(log d) comparisons. It is
+ * still O(log n) in the worst case: neighbors on either side of the root share no ancestor below it, so a hint and
+ * an answer only two positions apart can cost a full descent plus the climb.
+ * @param[in] hint Valid iterator into the tree to search.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+const rb_iterator_t rb_lower_bound_near(const rb_iterator_t hint, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_find_near
+ * @brief Same as rb_find, but starts from a node close to the answer instead of the root. See rb_lower_bound_near.
+ * @param[in] hint Valid iterator into the tree to search.
+ * @param[in] key Pointer to the node to be found.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+const rb_iterator_t rb_find_near(const rb_iterator_t hint, const rb_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_find_key
+ * @brief Searches the tree for a node matching a bare key and returns an iterator to it.
+ * @details Unlike rb_find, the caller only needs the key itself, not a whole node built around it.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] key Pointer to the key to be searched.
+ * @param[in] cmp_key Callback comparing the key against a node, ordered the same way as the tree.
+ */
+const rb_iterator_t rb_find_key(const rb_tree_t *tree, const void *key, int (*cmp_key)(const void *key, const rb_node_t *node));
+
+/**
+ * @fn rb_lower_bound_key
+ * @brief Returns an iterator to the first node that does not compare less than key, or NULL.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] key Pointer to the key to be bounded.
+ * @param[in] cmp_key Callback comparing the key against a node, ordered the same way as the tree.
+ */
+const rb_iterator_t rb_lower_bound_key(const rb_tree_t *tree, const void *key, int (*cmp_key)(const void *key, const rb_node_t *node));
+
+/**
+ * @fn rb_upper_bound_key
+ * @brief Returns an iterator to the first node that compares greater than key, or NULL.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] key Pointer to the key to be bounded.
+ * @param[in] cmp_key Callback comparing the key against a node, ordered the same way as the tree.
+ */
+const rb_iterator_t rb_upper_bound_key(const rb_tree_t *tree, const void *key, int (*cmp_key)(const void *key, const rb_node_t *node));
+
 /**
  * @fn rb_first
  * @brief Manually returns a pointer to the logical min of the tree.
@@ -462,6 +1053,42 @@ const rb_iterator_t rb_next(const rb_iterator_t node);
  */
 const rb_iterator_t rb_prev(const rb_iterator_t node);
 
+/**
+ * @fn rb_range_init
+ * @brief Sets up a range to walk every node in [lo, hi) in order, in O(log n + k) overall.
+ * @param[out] range Range to set up.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] lo Inclusive lower edge, or NULL to start at the first node.
+ * @param[in] hi Exclusive upper edge, or NULL to run to the last node.
+ * @param[in] cmp Comparator callback used to find the edges.
+ */
+void rb_range_init(rb_range_t *range, const rb_tree_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_lcached_range_init
+ * @brief Same as rb_range_init, using the cached min to find the lower edge.
+ */
+void rb_lcached_range_init(rb_range_t *range, const rb_tree_lcached_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_rcached_range_init
+ * @brief Same as rb_range_init, using the cached max to find the upper edge.
+ */
+void rb_rcached_range_init(rb_range_t *range, const rb_tree_rcached_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_lrcached_range_init
+ * @brief Same as rb_range_init, using the cached min and max to find the edges.
+ */
+void rb_lrcached_range_init(rb_range_t *range, const rb_tree_lrcached_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_range_next
+ * @brief Returns the next node in the range and steps past it, or NULL once the range is used up.
+ * @param[in] range Range set up by one of the rb_*range_init functions.
+ */
+const rb_iterator_t rb_range_next(rb_range_t *range);
+
 /**
  * @brief Performs an in-order traversal of the tree and applies cb to every node.
  * @param[in] tree Full tree to traverse.
@@ -483,6 +1110,117 @@ void rb_postorder_foreach(rb_tree_t *tree, void (*cb)(rb_node_t *key));
  */
 void rb_preorder_foreach(rb_tree_t *tree, void (*cb)(rb_node_t *key));
 
+/**
+ * @fn rb_inorder_walk
+ * @brief Calls cb on every node in order, with a context pointer, until it returns nonzero.
+ * @details Runs without recursion on a fixed-size stack, so it's reentrant and can't overflow on a deep tree.
+ * cb may free the node it's given, but not change the tree in any other way.
+ * @param[in] tree Full tree to traverse.
+ * @param[in] cb Function to apply to each node. Returning nonzero stops the walk.
+ * @param[in] ctx Passed through to cb.
+ * @return Whatever cb returned to stop the walk, or 0 if every node was visited.
+ */
+int rb_inorder_walk(rb_tree_t *tree, int (*cb)(rb_node_t *node, void *ctx), void *ctx);
+
+/**
+ * @fn rb_preorder_walk
+ * @brief Same as rb_inorder_walk, in pre-order.
+ */
+int rb_preorder_walk(rb_tree_t *tree, int (*cb)(rb_node_t *node, void *ctx), void *ctx);
+
+/**
+ * @fn rb_postorder_walk
+ * @brief Same as rb_inorder_walk, in post-order. A node is never touched after cb sees it.
+ */
+int rb_postorder_walk(rb_tree_t *tree, int (*cb)(rb_node_t *node, void *ctx), void *ctx);
+
+/**
+ * @fn rb_inorder_walk_range
+ * @brief Same as rb_inorder_walk, only visiting the nodes in [lo, hi), in O(log n + k) for k nodes visited.
+ * @param[in] tree Full tree to traverse.
+ * @param[in] lo Pointer to the node the range starts at, inclusive, or NULL to start at the first node.
+ * @param[in] hi Pointer to the node the range ends at, exclusive, or NULL to run to the last node.
+ * @param[in] cmp Comparator callback the tree is ordered by.
+ * @param[in] cb Function to apply to each node. Returning nonzero stops the walk.
+ * @param[in] ctx Passed through to cb.
+ * @return Whatever cb returned to stop the walk, or 0 if every node in range was visited.
+ */
+int rb_inorder_walk_range(rb_tree_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), int (*cb)(rb_node_t *node, void *ctx), void *ctx);
+
+/**
+ * @fn rb_preorder_walk_range
+ * @brief Same as rb_inorder_walk_range, in pre-order. Subtrees entirely outside the range are skipped.
+ */
+int rb_preorder_walk_range(rb_tree_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), int (*cb)(rb_node_t *node, void *ctx), void *ctx);
+
+/**
+ * @fn rb_postorder_walk_range
+ * @brief Same as rb_inorder_walk_range, in post-order. Subtrees entirely outside the range are skipped.
+ */
+int rb_postorder_walk_range(rb_tree_t *tree, const rb_node_t *lo, const rb_node_t *hi, int (*cmp)(const rb_node_t *left, const rb_node_t *right), int (*cb)(rb_node_t *node, void *ctx), void *ctx);
+
+/**
+ * @fn rb_tree_os_insert
+ * @brief Inserts an order-statistic node into an rb_tree, guided by a comparator, and keeps subtree sizes current.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_os_node_t nodes.
+ * @param[in] node Pointer to an rb_os_node instance embedded in something else.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+void rb_tree_os_insert(rb_tree_t *tree, rb_os_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_tree_os_delete_at
+ * @brief Deletes an order-statistic node from an rb_tree at an iterator, and keeps subtree sizes current.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_os_node_t nodes.
+ * @param[in] node Iterator into the tree.
+ */
+void rb_tree_os_delete_at(rb_tree_t *tree, rb_iterator_t node);
+
+/**
+ * @fn rb_tree_os_delete
+ * @brief Deletes an order-statistic node from an rb_tree after finding it manually.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_os_node_t nodes.
+ * @param[in] node Pointer to a node with the key to be deleted.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+void rb_tree_os_delete(rb_tree_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_tree_os_replace_node
+ * @brief Same as rb_replace_node for an order-statistic tree, carrying the victim's subtree size over.
+ * @details rb_replace_node copies only the links, which would leave the replacement's size stale and throw off
+ * rb_rank, rb_select and rb_count_range for everything above it.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_os_node_t nodes.
+ * @param[in] victim Node in the tree.
+ * @param[in] replacement Node not in any tree.
+ */
+void rb_tree_os_replace_node(rb_tree_t *tree, rb_os_node_t *victim, rb_os_node_t *replacement);
+
+/**
+ * @fn rb_rank
+ * @brief Returns the 0-based in-order position of a node in its order-statistic tree, in O(log n).
+ * @param[in] node Valid iterator into the tree.
+ */
+size_t rb_rank(const rb_iterator_t node);
+
+/**
+ * @fn rb_select
+ * @brief Returns the node at 0-based in-order position k of an order-statistic tree, or NULL if k is out of range, in O(log n).
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_os_node_t nodes.
+ * @param[in] k Position to fetch.
+ */
+const rb_iterator_t rb_select(const rb_tree_t *tree, size_t k);
+
+/**
+ * @fn rb_count_range
+ * @brief Counts the nodes in [lo, hi) of an order-statistic tree, in O(log n).
+ * @details Pair this with rb_lower_bound to count the nodes between two keys.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_os_node_t nodes.
+ * @param[in] lo First node of the range, or NULL to count from the first node.
+ * @param[in] hi First node past the range, or NULL to count through the last node.
+ */
+size_t rb_count_range(const rb_tree_t *tree, const rb_iterator_t lo, const rb_iterator_t hi);
+
 /** @} */
 
 #ifdef __cplusplus
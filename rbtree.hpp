@@ -0,0 +1,362 @@
+/**
+ * @file rbtree.hpp
+ * @author krad2
+ * @brief Header-only C++17 wrapper around the intrusive red-black tree in rbtree.h.
+ * @details rb::intrusive_tree takes its comparator as a template parameter, so every descent is
+ * inlined at the call site. Iteration, linking, rebalancing and deletion all defer to the C core,
+ * and the wrapper itself holds nothing but the rb_tree_t and the (usually empty) comparator.
+ */
+
+#ifndef RBTREE_HPP_
+#define RBTREE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "rbtree.h"
+
+namespace rb {
+
+/**
+ * @cond PRIVATE
+ */
+namespace detail {
+
+/** Detects Compare::is_transparent, which opts a comparator into heterogeneous lookup. */
+template <class Compare, class = void>
+struct is_transparent : std::false_type {};
+
+template <class Compare>
+struct is_transparent<Compare, std::void_t<typename Compare::is_transparent>> : std::true_type {};
+
+} // namespace detail
+/** @endcond */
+
+/**
+ * @class intrusive_tree
+ * @brief Sorted, intrusive container of T objects linked through their rb_node_t member.
+ * @tparam T Object type with an embedded rb_node_t.
+ * @tparam Member Pointer to the rb_node_t member within T.
+ * @tparam Compare Strict weak ordering over T. If it defines is_transparent, lookups accept any key type it can compare against T.
+ *
+ * The tree never owns its objects. Equal elements are kept in insertion order, like rb_tree_insert.
+ * T must be standard-layout, so that Member is a fixed byte offset into it.
+ */
+template <class T, rb_node_t T::*Member, class Compare = std::less<T>>
+class intrusive_tree {
+	static_assert(std::is_standard_layout_v<T>, "rb::intrusive_tree needs a standard-layout T to find objects from their nodes");
+
+	template <bool Const>
+	class basic_iterator;
+
+public:
+	using value_type = T;
+	using key_compare = Compare;
+	using reference = T &;
+	using const_reference = const T &;
+	using pointer = T *;
+	using const_pointer = const T *;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using iterator = basic_iterator<false>;
+	using const_iterator = basic_iterator<true>;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	intrusive_tree() noexcept(std::is_nothrow_default_constructible_v<Compare>) : comp_() { rb_tree_init(&tree_); }
+	explicit intrusive_tree(const Compare &comp) : comp_(comp) { rb_tree_init(&tree_); }
+
+	/*
+	 * a copy would be a second container linking the very same nodes, so copying is out. moving hands the nodes
+	 * over, but iterators hold &tree_, so any iterator into the moved-from tree, end() included, walks the now empty
+	 * tree afterwards
+	 */
+	intrusive_tree(const intrusive_tree &) = delete;
+	intrusive_tree &operator=(const intrusive_tree &) = delete;
+
+	intrusive_tree(intrusive_tree &&other) noexcept : tree_(other.tree_), comp_(std::move(other.comp_)) {
+		rb_tree_init(&other.tree_);
+	}
+
+	intrusive_tree &operator=(intrusive_tree &&other) noexcept {
+		tree_ = other.tree_;
+		comp_ = std::move(other.comp_);
+		rb_tree_init(&other.tree_);
+		return *this;
+	}
+
+	/** Underlying C tree, for use with the rest of the rbtree.h API. */
+	rb_tree_t *native() noexcept { return &tree_; }
+	const rb_tree_t *native() const noexcept { return &tree_; }
+
+	key_compare key_comp() const { return comp_; }
+
+	/* --- */
+
+	/* rb_first doesn't take an empty tree, so an empty one begins at the end */
+	iterator begin() noexcept { return iterator(rb_root(&tree_) ? rb_first(&tree_) : nullptr, &tree_); }
+	const_iterator begin() const noexcept { return const_iterator(rb_root(&tree_) ? rb_first(&tree_) : nullptr, &tree_); }
+	const_iterator cbegin() const noexcept { return begin(); }
+
+	iterator end() noexcept { return iterator(nullptr, &tree_); }
+	const_iterator end() const noexcept { return const_iterator(nullptr, &tree_); }
+	const_iterator cend() const noexcept { return end(); }
+
+	reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+	const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+	reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+	const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+	bool empty() const noexcept { return rb_is_empty(&tree_); }
+
+	/** Walks the whole tree, so this is O(n). */
+	size_type size() const noexcept { return static_cast<size_type>(std::distance(begin(), end())); }
+
+	/** Forgets every element without touching them. */
+	void clear() noexcept { rb_tree_init(&tree_); }
+
+	/* --- */
+
+	/**
+	 * @brief Links obj into the tree after any elements equal to it.
+	 * @return Iterator to obj.
+	 */
+	iterator insert(T &obj) {
+		rb_node_t *node = &(obj.*Member);
+		rb_node_t **link = &rb_root(&tree_);
+		rb_node_t *parent = nullptr;
+
+		while (*link) {
+			parent = *link;
+			link = comp_(obj, *to_value(parent)) ? &rb_left(parent) : &rb_right(parent);
+		}
+
+		rb_link_node(node, parent, link);
+		rb_insert_color(&tree_, node);
+		return iterator(node, &tree_);
+	}
+
+	/**
+	 * @brief Unlinks the element at pos.
+	 * @return Iterator to the element after it.
+	 */
+	iterator erase(const_iterator pos) {
+		rb_node_t *node = pos.node_;
+		rb_node_t *next = rb_next(node);
+
+		rb_tree_delete_at(&tree_, node);
+		return iterator(next, &tree_);
+	}
+
+	/** Unlinks every element in [first, last). */
+	iterator erase(const_iterator first, const_iterator last) {
+		while (first != last) first = erase(first);
+		return iterator(last.node_, &tree_);
+	}
+
+	/** Unlinks obj, which must be in this tree. */
+	void erase(T &obj) { rb_tree_delete_at(&tree_, &(obj.*Member)); }
+
+	/* --- */
+
+	iterator find(const T &key) { return find_impl<iterator>(key); }
+	const_iterator find(const T &key) const { return find_impl<const_iterator>(key); }
+
+	iterator lower_bound(const T &key) { return iterator(lower_bound_node(key), &tree_); }
+	const_iterator lower_bound(const T &key) const { return const_iterator(lower_bound_node(key), &tree_); }
+
+	iterator upper_bound(const T &key) { return iterator(upper_bound_node(key), &tree_); }
+	const_iterator upper_bound(const T &key) const { return const_iterator(upper_bound_node(key), &tree_); }
+
+	std::pair<iterator, iterator> equal_range(const T &key) { return { lower_bound(key), upper_bound(key) }; }
+	std::pair<const_iterator, const_iterator> equal_range(const T &key) const { return { lower_bound(key), upper_bound(key) }; }
+
+	size_type count(const T &key) const { auto range = equal_range(key); return std::distance(range.first, range.second); }
+	bool contains(const T &key) const { return find(key) != end(); }
+
+	/*
+	 * Heterogeneous overloads, available when the comparator is transparent. These compare a bare key
+	 * against the stored objects, so there's no need to build a dummy T just to search.
+	 */
+
+	template <class K, class C = Compare, class = std::enable_if_t<detail::is_transparent<C>::value>>
+	iterator find(const K &key) { return find_impl<iterator>(key); }
+	template <class K, class C = Compare, class = std::enable_if_t<detail::is_transparent<C>::value>>
+	const_iterator find(const K &key) const { return find_impl<const_iterator>(key); }
+
+	template <class K, class C = Compare, class = std::enable_if_t<detail::is_transparent<C>::value>>
+	iterator lower_bound(const K &key) { return iterator(lower_bound_node(key), &tree_); }
+	template <class K, class C = Compare, class = std::enable_if_t<detail::is_transparent<C>::value>>
+	const_iterator lower_bound(const K &key) const { return const_iterator(lower_bound_node(key), &tree_); }
+
+	template <class K, class C = Compare, class = std::enable_if_t<detail::is_transparent<C>::value>>
+	iterator upper_bound(const K &key) { return iterator(upper_bound_node(key), &tree_); }
+	template <class K, class C = Compare, class = std::enable_if_t<detail::is_transparent<C>::value>>
+	const_iterator upper_bound(const K &key) const { return const_iterator(upper_bound_node(key), &tree_); }
+
+	template <class K, class C = Compare, class = std::enable_if_t<detail::is_transparent<C>::value>>
+	std::pair<iterator, iterator> equal_range(const K &key) { return { lower_bound(key), upper_bound(key) }; }
+	template <class K, class C = Compare, class = std::enable_if_t<detail::is_transparent<C>::value>>
+	std::pair<const_iterator, const_iterator> equal_range(const K &key) const { return { lower_bound(key), upper_bound(key) }; }
+
+	template <class K, class C = Compare, class = std::enable_if_t<detail::is_transparent<C>::value>>
+	size_type count(const K &key) const { auto range = equal_range(key); return std::distance(range.first, range.second); }
+	template <class K, class C = Compare, class = std::enable_if_t<detail::is_transparent<C>::value>>
+	bool contains(const K &key) const { return find(key) != end(); }
+
+	/* --- */
+
+	/** Returns an iterator to obj, which must already be in this tree. */
+	iterator iterator_to(T &obj) noexcept { return iterator(&(obj.*Member), &tree_); }
+	const_iterator iterator_to(const T &obj) const noexcept {
+		return const_iterator(const_cast<rb_node_t *>(&(obj.*Member)), &tree_);
+	}
+
+	/** Recovers the object containing node. */
+	static T *to_value(rb_node_t *node) noexcept {
+		return reinterpret_cast<T *>(reinterpret_cast<char *>(node) - member_offset());
+	}
+
+	static const T *to_value(const rb_node_t *node) noexcept {
+		return reinterpret_cast<const T *>(reinterpret_cast<const char *>(node) - member_offset());
+	}
+
+private:
+	/*
+	 * forming obj->*Member needs an actual T at obj, and there's none to hand here. instead the offset is copied out of
+	 * the member pointer itself: for a data member of a standard-layout class, both the Itanium and the MSVC ABI
+	 * represent it as the member's byte offset, in a ptrdiff_t and an int respectively
+	 */
+	static std::size_t member_offset() noexcept {
+		using representation = std::conditional_t<sizeof(rb_node_t T::*) == sizeof(std::ptrdiff_t), std::ptrdiff_t, std::int32_t>;
+		static_assert(sizeof(rb_node_t T::*) == sizeof(representation), "unknown member pointer representation");
+
+		static constexpr rb_node_t T::*member = Member;
+		representation offset;
+
+		std::memcpy(&offset, &member, sizeof(offset));
+		return static_cast<std::size_t>(offset);
+	}
+
+	/* first node not less than key */
+	template <class K>
+	rb_node_t *lower_bound_node(const K &key) const {
+		rb_node_t *cursor = rb_root(&tree_);
+		rb_node_t *bound = nullptr;
+
+		while (cursor) {
+			if (comp_(*to_value(cursor), key)) {
+				cursor = rb_right(cursor);
+			} else {
+				bound = cursor;
+				cursor = rb_left(cursor);
+			}
+		}
+
+		return bound;
+	}
+
+	/* first node greater than key */
+	template <class K>
+	rb_node_t *upper_bound_node(const K &key) const {
+		rb_node_t *cursor = rb_root(&tree_);
+		rb_node_t *bound = nullptr;
+
+		while (cursor) {
+			if (comp_(key, *to_value(cursor))) {
+				bound = cursor;
+				cursor = rb_left(cursor);
+			} else {
+				cursor = rb_right(cursor);
+			}
+		}
+
+		return bound;
+	}
+
+	/* the lower bound is a match unless key sorts strictly before it */
+	template <class It, class K>
+	It find_impl(const K &key) const {
+		rb_node_t *bound = lower_bound_node(key);
+
+		if (bound && comp_(key, *to_value(bound))) bound = nullptr;
+		return It(bound, const_cast<rb_tree_t *>(&tree_));
+	}
+
+	rb_tree_t tree_;
+	Compare comp_;
+};
+
+/**
+ * @class intrusive_tree::basic_iterator
+ * @brief Bidirectional iterator over rb_next / rb_prev. The past-the-end iterator is a NULL node.
+ */
+template <class T, rb_node_t T::*Member, class Compare>
+template <bool Const>
+class intrusive_tree<T, Member, Compare>::basic_iterator {
+	friend class intrusive_tree;
+	friend class basic_iterator<!Const>;
+
+	using tree_pointer = std::conditional_t<Const, const rb_tree_t *, rb_tree_t *>;
+
+public:
+	using iterator_category = std::bidirectional_iterator_tag;
+	using value_type = T;
+	using difference_type = std::ptrdiff_t;
+	using pointer = std::conditional_t<Const, const T *, T *>;
+	using reference = std::conditional_t<Const, const T &, T &>;
+
+	basic_iterator() noexcept : node_(nullptr), tree_(nullptr) {}
+
+	/* iterators convert to const_iterators, but not the other way around */
+	template <bool C = Const, class = std::enable_if_t<C>>
+	basic_iterator(const basic_iterator<false> &other) noexcept : node_(other.node_), tree_(other.tree_) {}
+
+	reference operator*() const noexcept { return *to_value(node_); }
+	pointer operator->() const noexcept { return to_value(node_); }
+
+	/** Node in the C tree this iterator points at, or NULL at the end. */
+	rb_node_t *native() const noexcept { return node_; }
+
+	basic_iterator &operator++() noexcept {
+		node_ = rb_next(node_);
+		return *this;
+	}
+
+	basic_iterator operator++(int) noexcept {
+		basic_iterator prev = *this;
+		++*this;
+		return prev;
+	}
+
+	/* stepping back from the end lands on the last element, or stays at the end of an empty tree */
+	basic_iterator &operator--() noexcept {
+		if (node_) node_ = rb_prev(node_);
+		else node_ = rb_root(tree_) ? rb_last(tree_) : nullptr;
+		return *this;
+	}
+
+	basic_iterator operator--(int) noexcept {
+		basic_iterator prev = *this;
+		--*this;
+		return prev;
+	}
+
+	friend bool operator==(const basic_iterator &l, const basic_iterator &r) noexcept { return l.node_ == r.node_; }
+	friend bool operator!=(const basic_iterator &l, const basic_iterator &r) noexcept { return l.node_ != r.node_; }
+
+private:
+	basic_iterator(rb_node_t *node, tree_pointer tree) noexcept : node_(node), tree_(tree) {}
+
+	rb_node_t *node_;
+	tree_pointer tree_;
+};
+
+} // namespace rb
+
+#endif /* RBTREE_HPP_ */
@@ -0,0 +1,140 @@
+/**
+ * @file rbtree_augmented.h
+ * @author krad2
+ * @brief Augmented red-black trees: nodes that carry data computed over their whole subtree.
+ * @details Subtree sizes, maximum endpoints, sums or minimums can all be kept current by handing the insert and
+ * delete paths a set of callbacks, the same way the kernel's rb_augment_callbacks work. The callbacks run at
+ * exactly the points where the shape of a subtree changes: when a node is linked or unlinked, when a node
+ * takes over another's position during a delete, and on every rotation.
+ */
+
+#ifndef RBTREE_AUGMENTED_H_
+#define RBTREE_AUGMENTED_H_
+
+#include "rbtree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct rb_augment
+ * @brief Callbacks that keep augmented per-subtree data in sync with the tree's shape.
+ * @var rb_augment::propagate
+ * Recomputes node, then its ancestors, stopping before 'stop' (NULL goes all the way to the root).
+ * @var rb_augment::copy
+ * dst has taken over src's position and whole subtree, so it takes src's value as is.
+ * @var rb_augment::rotate
+ * nw was rotated above old: nw takes old's value as is, and old is recomputed from its new children.
+ */
+typedef struct rb_augment {
+	void (*propagate)(rb_node_t *node, rb_node_t *stop);
+	void (*copy)(rb_node_t *src, rb_node_t *dst);
+	void (*rotate)(rb_node_t *old, rb_node_t *nw);
+} rb_augment_t;
+
+/**
+ * @defgroup rb_augment_macros Augmented red-black tree macros.
+ * @{
+ */
+
+/**
+ * @brief Generates an rb_augment_t named 'name' for a scalar field recomputed by 'compute'.
+ * @param rbstatic Storage class for the generated callback set, e.g. static or nothing.
+ * @param name Name of the generated rb_augment_t; the callbacks are prefixed with it.
+ * @param type Object type with an embedded rb_node_t.
+ * @param member Name of the rb_node_t member within type.
+ * @param field Augmented field within type. It must be comparable with ==.
+ * @param compute Function or function-like macro taking a type * and returning the field's value
+ * for that node, from its own data and its children's fields.
+ *
+ * The generated propagate stops climbing as soon as a node's value comes out unchanged, since nothing
+ * above it can change either. The first node is always written, so a fresh leaf needs no initialization.
+ */
+#define RB_DECLARE_AUGMENT(rbstatic, name, type, member, field, compute)								\
+																										\
+static inline void name##_propagate(rb_node_t *rb, rb_node_t *stop) {									\
+	bool first = true;																					\
+																										\
+	while (rb != stop) {																				\
+		type *node = rb_entry(rb, type, member);														\
+		__typeof__(node->field) augmented = compute(node);												\
+																										\
+		if (!first && node->field == augmented) break;													\
+		node->field = augmented;																		\
+																										\
+		first = false;																					\
+		rb = rb_parent(rb);																				\
+	}																									\
+}																										\
+																										\
+static inline void name##_copy(rb_node_t *src, rb_node_t *dst) {										\
+	rb_entry(dst, type, member)->field = rb_entry(src, type, member)->field;							\
+}																										\
+																										\
+static inline void name##_rotate(rb_node_t *old, rb_node_t *nw) {										\
+	type *old_node = rb_entry(old, type, member);														\
+	type *new_node = rb_entry(nw, type, member);														\
+																										\
+	new_node->field = old_node->field;																	\
+	old_node->field = compute(old_node);																\
+}																										\
+																										\
+rbstatic const rb_augment_t name = {																	\
+	.propagate = name##_propagate,																		\
+	.copy = name##_copy,																				\
+	.rotate = name##_rotate																				\
+};
+
+/** @} */
+
+/**
+ * @defgroup rb_augment_api Augmented red-black tree API.
+ * @{
+ */
+
+/**
+ * @fn rb_insert_augmented
+ * @brief Augmented counterpart of rb_insert_color: fixes up the path above a node linked in with rb_link_node, then rebalances.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Freshly linked node.
+ * @param[in] aug Augmentation callbacks for the tree.
+ */
+void rb_insert_augmented(rb_tree_t *tree, rb_node_t *node, const rb_augment_t *aug);
+
+/**
+ * @fn rb_tree_augmented_insert
+ * @brief Inserts a node into an augmented rb_tree, guided by a comparator.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Pointer to an rb_node instance embedded in something else.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ * @param[in] aug Augmentation callbacks for the tree.
+ */
+void rb_tree_augmented_insert(rb_tree_t *tree, rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), const rb_augment_t *aug);
+
+/**
+ * @fn rb_tree_augmented_delete_at
+ * @brief Deletes a node from an augmented rb_tree at an iterator.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] node Iterator into the tree.
+ * @param[in] aug Augmentation callbacks for the tree.
+ */
+void rb_tree_augmented_delete_at(rb_tree_t *tree, rb_iterator_t node, const rb_augment_t *aug);
+
+/**
+ * @fn rb_replace_node_augmented
+ * @brief Same as rb_replace_node, then recomputes the replacement's augmented value and whatever depends on it above.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] victim Node in the tree.
+ * @param[in] replacement Node not in any tree.
+ * @param[in] aug Augmentation callbacks for the tree.
+ */
+void rb_replace_node_augmented(rb_tree_t *tree, rb_node_t *victim, rb_node_t *replacement, const rb_augment_t *aug);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RBTREE_AUGMENTED_H_ */
@@ -0,0 +1,125 @@
+/**
+ * @file rbtree_define.h
+ * @author krad2
+ * @brief Header-only, type-specialized red-black tree instantiations with the comparison inlined.
+ * @details The function-pointer API in rbtree.h pays an indirect call at every level of a descent.
+ * RB_DEFINE_TREE stamps out static inline wrappers for one object type instead, so the compiler sees
+ * the key extraction and the comparison directly. Only the descents are generated; linking,
+ * rebalancing and deletion still go through the shared code in rbtree.c.
+ */
+
+#ifndef RBTREE_DEFINE_H_
+#define RBTREE_DEFINE_H_
+
+#include "rbtree.h"
+
+/**
+ * @defgroup rb_define Type-specialized red-black tree instantiation.
+ * @{
+ */
+
+/**
+ * @brief Defines a type-specialized tree API over rb_tree_t.
+ * @param name Prefix of the generated functions, e.g. name##_insert.
+ * @param type Object type with an embedded rb_node_t.
+ * @param member Name of the rb_node_t member within type.
+ * @param key_expr Function or function-like macro taking a const type * and yielding its key.
+ * @param cmp_expr Function or function-like macro taking two keys and returning <0, 0 or >0.
+ *
+ * For instance:
+ *
+ *	#define a_key(obj)		((obj)->x)
+ *	#define a_cmp(l, r)		(((l) > (r)) - ((l) < (r)))
+ *	RB_DEFINE_TREE(a_tree, struct a, node, a_key, a_cmp)
+ *
+ * generates:
+ *
+ *	void      a_tree_insert(rb_tree_t *tree, struct a *obj);
+ *	struct a *a_tree_find(const rb_tree_t *tree, a_tree_key_t key);
+ *	struct a *a_tree_lower_bound(const rb_tree_t *tree, a_tree_key_t key);
+ *	struct a *a_tree_upper_bound(const rb_tree_t *tree, a_tree_key_t key);
+ *	struct a *a_tree_delete(rb_tree_t *tree, a_tree_key_t key);
+ *
+ * Equal keys are inserted to the right of each other, same as rb_tree_insert.
+ */
+#define RB_DEFINE_TREE(name, type, member, key_expr, cmp_expr)												\
+																											\
+typedef __typeof__(key_expr((const type *) NULL)) name##_key_t;												\
+																											\
+/* links obj at the leaf the descent ends on, then rebalances from there */								\
+static inline void name##_insert(rb_tree_t *tree, type *obj) {												\
+	name##_key_t key = key_expr((const type *) obj);														\
+	rb_node_t *cursor = rb_root(tree);																		\
+	rb_node_t *parent = NULL;																				\
+	bool left = false;																						\
+																											\
+	while (cursor) {																						\
+		parent = cursor;																					\
+		left = cmp_expr(key, key_expr((const type *) rb_entry(cursor, type, member))) < 0;					\
+		cursor = left ? rb_left(cursor) : rb_right(cursor);													\
+	}																										\
+																											\
+	if (!parent) rb_link_node(&obj->member, parent, &rb_root(tree));										\
+	else rb_link_node(&obj->member, parent, left ? &rb_left(parent) : &rb_right(parent));					\
+	rb_insert_color(tree, &obj->member);																	\
+}																											\
+																											\
+/* returns an object whose key compares equal to key, or NULL */										\
+static inline type *name##_find(const rb_tree_t *tree, name##_key_t key) {									\
+	rb_node_t *cursor = rb_root(tree);																		\
+																											\
+	while (cursor) {																						\
+		int comparison = cmp_expr(key, key_expr((const type *) rb_entry(cursor, type, member)));			\
+		if (comparison < 0) cursor = rb_left(cursor);														\
+		else if (comparison > 0) cursor = rb_right(cursor);													\
+		else return rb_entry(cursor, type, member);															\
+	}																										\
+																											\
+	return NULL;																							\
+}																											\
+																											\
+/* returns the first object whose key is not less than key, or NULL */									\
+static inline type *name##_lower_bound(const rb_tree_t *tree, name##_key_t key) {							\
+	rb_node_t *cursor = rb_root(tree);																		\
+	rb_node_t *bound = NULL;																				\
+																											\
+	while (cursor) {																						\
+		if (cmp_expr(key_expr((const type *) rb_entry(cursor, type, member)), key) < 0) {					\
+			cursor = rb_right(cursor);																		\
+		} else {																							\
+			bound = cursor;																					\
+			cursor = rb_left(cursor);																		\
+		}																									\
+	}																										\
+																											\
+	return bound ? rb_entry(bound, type, member) : NULL;													\
+}																											\
+																											\
+/* returns the first object whose key is greater than key, or NULL */										\
+static inline type *name##_upper_bound(const rb_tree_t *tree, name##_key_t key) {							\
+	rb_node_t *cursor = rb_root(tree);																		\
+	rb_node_t *bound = NULL;																				\
+																											\
+	while (cursor) {																						\
+		if (cmp_expr(key, key_expr((const type *) rb_entry(cursor, type, member))) < 0) {					\
+			bound = cursor;																					\
+			cursor = rb_left(cursor);																		\
+		} else {																							\
+			cursor = rb_right(cursor);																		\
+		}																									\
+	}																										\
+																											\
+	return bound ? rb_entry(bound, type, member) : NULL;													\
+}																											\
+																											\
+/* unlinks and returns an object whose key compares equal to key, or NULL if there is none */			\
+static inline type *name##_delete(rb_tree_t *tree, name##_key_t key) {										\
+	type *obj = name##_find(tree, key);																		\
+																											\
+	if (obj) rb_tree_delete_at(tree, &obj->member);															\
+	return obj;																								\
+}
+
+/** @} */
+
+#endif /* RBTREE_DEFINE_H_ */
@@ -0,0 +1,202 @@
+/**
+ * @file rbtree_fork.c
+ * @author krad2
+ * @brief A pthread pool that plugs into rb_fork_t, for running the set operations across threads.
+ */
+
+#include "rbtree_fork.h"
+
+#include <stdlib.h>
+
+/**
+ * @enum rb_fork_state
+ * @brief Where a job is in its life.
+ */
+enum rb_fork_state {
+	rb_fork_queued = 0,
+	rb_fork_running = 1,
+	rb_fork_finished = 2
+};
+
+/**
+ * @struct rb_fork_job
+ * @brief Half of a fork, queued for a worker. Lives on the forking thread's stack.
+ * @var rb_fork_job::fn
+ * Function to run.
+ * @var rb_fork_job::arg
+ * Argument to run it on.
+ * @var rb_fork_job::newer
+ * Next newer job in the queue.
+ * @var rb_fork_job::older
+ * Next older job in the queue.
+ * @var rb_fork_job::state
+ * Whether the job is still queued, running on a worker, or finished.
+ */
+struct rb_fork_job {
+	void (*fn)(void *arg);
+	void *arg;
+	struct rb_fork_job *newer;
+	struct rb_fork_job *older;
+	enum rb_fork_state state;
+};
+
+/**
+ * @defgroup rb_fork_helpers Fork pool helpers.
+ * @{
+ */
+
+/**
+ * @brief Takes a job out of the queue, wherever it is. Called with the lock held.
+ */
+static inline void __rb_fork_unlink(rb_fork_pool_t *pool, struct rb_fork_job *job) {
+	if (job->newer) job->newer->older = job->older;
+	else pool->head = job->older;
+
+	if (job->older) job->older->newer = job->newer;
+	else pool->tail = job->newer;
+}
+
+/**
+ * @brief Worker loop: runs the oldest queued job, which is also the biggest, until the pool stops.
+ */
+static void *__rb_fork_worker(void *arg) {
+	rb_fork_pool_t *pool = arg;
+	struct rb_fork_job *job;
+
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		while (!pool->tail && !pool->stopping) pthread_cond_wait(&pool->wake, &pool->lock);
+		if (!pool->tail) break;
+
+		job = pool->tail;
+		__rb_fork_unlink(pool, job);
+		job->state = rb_fork_running;
+		pthread_mutex_unlock(&pool->lock);
+
+		job->fn(job->arg);
+
+		/* the job's owner may return as soon as it sees this, taking the job's memory with it */
+		pthread_mutex_lock(&pool->lock);
+		job->state = rb_fork_finished;
+		pthread_cond_broadcast(&pool->done);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+/**
+ * @brief rb_fork_t::run for a pool: queues fn(left), runs fn(right), then takes fn(left) back or waits for it.
+ * @details A thread only ever waits on a job some other thread is actively running, so nested forks can't deadlock
+ * no matter how few workers there are.
+ */
+static void __rb_fork_run(void (*fn)(void *arg), void *left, void *right, void *ctx) {
+	rb_fork_pool_t *pool = ctx;
+	struct rb_fork_job job = { .fn = fn, .arg = left, .newer = NULL, .older = NULL, .state = rb_fork_queued };
+
+	pthread_mutex_lock(&pool->lock);
+	job.older = pool->head;
+	if (pool->head) pool->head->newer = &job;
+	else pool->tail = &job;
+	pool->head = &job;
+	pthread_cond_signal(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+
+	fn(right);
+
+	pthread_mutex_lock(&pool->lock);
+	if (job.state == rb_fork_queued) {
+		__rb_fork_unlink(pool, &job);
+		pthread_mutex_unlock(&pool->lock);
+
+		/* nobody got to it, so it's cheaper to just do it here */
+		fn(left);
+		return;
+	}
+
+	while (job.state != rb_fork_finished) pthread_cond_wait(&pool->done, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief Stops and joins the first 'started' workers. Called without the lock held.
+ */
+static void __rb_fork_stop(rb_fork_pool_t *pool, size_t started) {
+	pthread_mutex_lock(&pool->lock);
+	pool->stopping = true;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (size_t i = 0; i < started; i++) pthread_join(pool->threads[i], NULL);
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_fork_api Fork pool API.
+ * @{
+ */
+
+/**
+ * @fn rb_fork_pool_init
+ * @brief Starts a pool of worker threads.
+ * @details The fork depth is set to keep a few tasks per thread in flight, which evens out uneven halves. With no
+ * workers, the hook never forks and everything runs on the calling thread.
+ * @param[in] pool Pointer to an rb_fork_pool instance.
+ * @param[in] workers Number of threads to start. A caller of the set operations works too, so one less than the
+ * number of cores to use.
+ * @return False if the threads couldn't be started, in which case there's nothing to destroy.
+ */
+bool rb_fork_pool_init(rb_fork_pool_t *pool, size_t workers) {
+	size_t depth = 0, started;
+
+	/* enough levels for every thread, caller included, plus two more to give about four tasks each */
+	while (((size_t) 1 << depth) < workers + 1) depth++;
+
+	pool->fork.run = __rb_fork_run;
+	pool->fork.ctx = pool;
+	pool->fork.depth = workers ? depth + 2 : 0;
+	pool->workers = workers;
+	pool->head = pool->tail = NULL;
+	pool->stopping = false;
+
+	pool->threads = workers ? malloc(workers * sizeof(*pool->threads)) : NULL;
+	if (workers && !pool->threads) return false;
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	pthread_cond_init(&pool->done, NULL);
+
+	for (started = 0; started < workers; started++) {
+		if (pthread_create(&pool->threads[started], NULL, __rb_fork_worker, pool) != 0) break;
+	}
+
+	if (started < workers) {
+		__rb_fork_stop(pool, started);
+		pool->workers = started;
+		rb_fork_pool_destroy(pool);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @fn rb_fork_pool_destroy
+ * @brief Stops and joins every worker. No set operation may be using the pool.
+ * @param[in] pool Pointer to an rb_fork_pool instance.
+ */
+void rb_fork_pool_destroy(rb_fork_pool_t *pool) {
+	if (!pool->stopping) __rb_fork_stop(pool, pool->workers);
+
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->wake);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->threads);
+
+	pool->threads = NULL;
+	pool->workers = 0;
+	pool->fork.depth = 0;
+}
+
+/** @} */
@@ -0,0 +1,88 @@
+/**
+ * @file rbtree_fork.h
+ * @author krad2
+ * @brief A pthread pool that plugs into rb_fork_t, for running the set operations across threads.
+ * @details The set operations only know how to hand their two independent halves to an rb_fork_t, so that callers
+ * with a pool of their own can use it. For everyone else, rb_fork_pool_t is a fixed number of worker threads behind
+ * one shared queue. Forking queues one half and runs the other on the calling thread; if no worker has picked the
+ * queued half up by the time that's done, the caller takes it back and runs it too, so a busy pool never deadlocks
+ * and an idle one never costs more than a lock. This is the only part of the library that needs threads: build it
+ * with -pthread, or leave it out.
+ */
+
+#ifndef RBTREE_FORK_H_
+#define RBTREE_FORK_H_
+
+#include "rbtree.h"
+
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct rb_fork_pool
+ * @brief A pool of worker threads, and the rb_fork_t that feeds them.
+ * @var rb_fork_pool::fork
+ * Hook to pass to the set operations. Its depth can be changed between operations.
+ * @var rb_fork_pool::threads
+ * Worker threads.
+ * @var rb_fork_pool::workers
+ * Number of worker threads, not counting the threads that call in.
+ * @var rb_fork_pool::lock
+ * Guards the queue and every job's state.
+ * @var rb_fork_pool::wake
+ * Signalled when a job is queued or the pool is shutting down.
+ * @var rb_fork_pool::done
+ * Broadcast whenever a worker finishes a job.
+ * @var rb_fork_pool::head
+ * Newest queued job.
+ * @var rb_fork_pool::tail
+ * Oldest queued job, which is the next one a worker takes.
+ * @var rb_fork_pool::stopping
+ * Set by rb_fork_pool_destroy to send the workers home.
+ */
+typedef struct rb_fork_pool {
+	rb_fork_t fork;
+	pthread_t *threads;
+	size_t workers;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t done;
+	struct rb_fork_job *head;
+	struct rb_fork_job *tail;
+	bool stopping;
+} rb_fork_pool_t;
+
+/**
+ * @defgroup rb_fork_api Fork pool API.
+ * @{
+ */
+
+/**
+ * @fn rb_fork_pool_init
+ * @brief Starts a pool of worker threads.
+ * @details The fork depth is set to keep a few tasks per thread in flight, which evens out uneven halves. With no
+ * workers, the hook never forks and everything runs on the calling thread.
+ * @param[in] pool Pointer to an rb_fork_pool instance.
+ * @param[in] workers Number of threads to start. A caller of the set operations works too, so one less than the
+ * number of cores to use.
+ * @return False if the threads couldn't be started, in which case there's nothing to destroy.
+ */
+bool rb_fork_pool_init(rb_fork_pool_t *pool, size_t workers);
+
+/**
+ * @fn rb_fork_pool_destroy
+ * @brief Stops and joins every worker. No set operation may be using the pool.
+ * @param[in] pool Pointer to an rb_fork_pool instance.
+ */
+void rb_fork_pool_destroy(rb_fork_pool_t *pool);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RBTREE_FORK_H_ */
@@ -0,0 +1,259 @@
+/**
+ * @file rbtree_frozen.c
+ * @author krad2
+ * @brief Read-only snapshots of a tree with integer keys, laid out in Eytzinger order for fast lookups.
+ */
+
+#include "rbtree_frozen.h"
+
+#include <stdlib.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @defgroup rb_frozen_helpers Frozen snapshot helpers.
+ * @{
+ */
+
+/** Alignment of the key array, so that every group of RB_FROZEN_PER_LINE siblings shares one cache line. */
+#define RB_FROZEN_LINE										64
+
+/** Keys per cache line. A node's descendants three levels down are the RB_FROZEN_PER_LINE keys from 8k on. */
+#define RB_FROZEN_PER_LINE									(RB_FROZEN_LINE / sizeof(uint64_t))
+
+/** Searches rb_frozen_lower_bound_batch keeps in flight at once. */
+#define RB_FROZEN_LANES										8
+
+/**
+ * @brief Fills the implicit subtree at k from an in-order cursor, and returns the cursor past everything it took.
+ * @details Children of k sit at 2k and 2k + 1, so an in-order walk of the indices visits them in sorted order.
+ */
+static const rb_node_t *__rb_frozen_fill(rb_frozen_t *frozen, uint64_t (*key)(const rb_node_t *node), const rb_node_t *cursor, size_t k) {
+	while (k <= frozen->n) {
+		cursor = __rb_frozen_fill(frozen, key, cursor, 2 * k);
+
+		frozen->keys[k] = key(cursor);
+		frozen->nodes[k] = cursor;
+		cursor = rb_next((rb_iterator_t) cursor);
+
+		/* the right subtree is a tail call */
+		k = 2 * k + 1;
+	}
+
+	return cursor;
+}
+
+/**
+ * @brief Maps where a descent fell off the array back to the last node it went left at, or 0 if it never did.
+ * @details The bits of k below its leading one spell out the turns taken, 1 for right. Dropping the trailing right
+ * turns, then the left turn before them, leaves the index of the node that turned left.
+ */
+static inline size_t __rb_frozen_resolve(size_t k) {
+	return k >> __builtin_ffsll((long long) ~k);
+}
+
+/**
+ * @brief Walks one key down the array. Keys equal to key go left unless strict.
+ * @return Index of the first key not less than (or, if strict, greater than) key, or 0 if there is none.
+ */
+static inline size_t __rb_frozen_descend(const rb_frozen_t *frozen, uint64_t key, bool strict) {
+	const uint64_t *keys = frozen->keys;
+	size_t n = frozen->n, k = 1;
+
+	while (k <= n) {
+
+		/* three levels ahead fits in one line; running off the end is harmless for a prefetch */
+		__builtin_prefetch(keys + RB_FROZEN_PER_LINE * k);
+		k = 2 * k + (strict ? (keys[k] <= key) : (keys[k] < key));
+	}
+
+	return __rb_frozen_resolve(k);
+}
+
+/**
+ * @brief Number of levels in the implicit tree, which every batched descent runs for.
+ */
+static inline size_t __rb_frozen_levels(size_t n) {
+	return n ? (size_t) (64 - __builtin_clzll((unsigned long long) n)) : 0;
+}
+
+#if defined(__AVX2__)
+
+/**
+ * @brief Takes one step down the array for four lanes at once with an AVX2 gather.
+ * @details AVX2 only compares signed 64-bit lanes, so both sides get their sign bit flipped first, which orders
+ * them the same way as unsigned. Lanes that have fallen off the last level take a right turn instead, which
+ * __rb_frozen_resolve strips off again.
+ */
+static inline __m256i __rb_frozen_step_x4(const uint64_t *array, __m256i limit, __m256i key, __m256i cursor) {
+	const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+	__m256i off = _mm256_cmpgt_epi64(cursor, limit);
+
+	/* lanes past the end read the unused keys[0] instead of running off the array */
+	__m256i index = _mm256_andnot_si256(off, cursor);
+	__m256i pivot = _mm256_xor_si256(_mm256_i64gather_epi64((const long long *) array, index, 8), sign);
+	__m256i right = _mm256_or_si256(off, _mm256_cmpgt_epi64(key, pivot));
+
+	/* right is all ones where the lane goes right, so subtracting it adds 1 */
+	return _mm256_sub_epi64(_mm256_add_epi64(cursor, cursor), right);
+}
+
+#endif
+
+/**
+ * @brief Walks RB_FROZEN_LANES keys down the array in lockstep, leaving the indices they fell off at in k.
+ */
+static inline void __rb_frozen_descend_lanes(const rb_frozen_t *frozen, const uint64_t *keys, size_t levels, uint64_t *k) {
+#if defined(__AVX2__)
+	const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+	const __m256i limit = _mm256_set1_epi64x((long long) frozen->n);
+	__m256i key[RB_FROZEN_LANES / 4], cursor[RB_FROZEN_LANES / 4];
+
+	for (size_t v = 0; v < RB_FROZEN_LANES / 4; v++) {
+		key[v] = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (keys + 4 * v)), sign);
+		cursor[v] = _mm256_set1_epi64x(1);
+		_mm256_storeu_si256((__m256i *) (k + 4 * v), cursor[v]);
+	}
+
+	/* every vector takes a step before any takes the next, and each lane prefetches ahead like the scalar walk */
+	for (size_t level = 0; level < levels; level++) {
+		for (size_t v = 0; v < RB_FROZEN_LANES / 4; v++) {
+			cursor[v] = __rb_frozen_step_x4(frozen->keys, limit, key[v], cursor[v]);
+			_mm256_storeu_si256((__m256i *) (k + 4 * v), cursor[v]);
+		}
+
+		for (size_t lane = 0; lane < RB_FROZEN_LANES; lane++) __builtin_prefetch(frozen->keys + RB_FROZEN_PER_LINE * k[lane]);
+	}
+#else
+	const uint64_t *array = frozen->keys;
+	size_t n = frozen->n;
+
+	for (size_t lane = 0; lane < RB_FROZEN_LANES; lane++) k[lane] = 1;
+
+	/* same descent as __rb_frozen_descend, one level of every lane at a time so their misses overlap */
+	for (size_t level = 0; level < levels; level++) {
+		for (size_t lane = 0; lane < RB_FROZEN_LANES; lane++) {
+			bool off = k[lane] > n;
+
+			__builtin_prefetch(array + RB_FROZEN_PER_LINE * k[lane]);
+			k[lane] = 2 * k[lane] + (off || array[off ? 0 : k[lane]] < keys[lane]);
+		}
+	}
+#endif
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_frozen_api Frozen snapshot API.
+ * @{
+ */
+
+/**
+ * @fn rb_tree_freeze
+ * @brief Takes a read-only snapshot of a tree whose order matches an unsigned 64-bit key, in O(n).
+ * @details Signed or narrower keys work too, as long as the extractor maps them to uint64_t without changing their
+ * order, e.g. by flipping the sign bit of an int64_t.
+ * @param[in] tree Pointer to an rb_tree instance, or any of the cached trees cast to one.
+ * @param[in] key Returns a node's key. Must agree with the comparator the tree was built with.
+ * @param[out] frozen Pointer to an rb_frozen instance to fill in.
+ * @return False if there wasn't memory for the snapshot, in which case there's nothing to destroy.
+ */
+bool rb_tree_freeze(const rb_tree_t *tree, uint64_t (*key)(const rb_node_t *node), rb_frozen_t *frozen) {
+	size_t n = 0, bytes;
+
+	for (const rb_node_t *node = rb_is_empty(tree) ? NULL : rb_first(tree); node; node = rb_next((rb_iterator_t) node)) n++;
+
+	/* aligned_alloc wants a whole number of alignments */
+	bytes = (n + 1) * sizeof(uint64_t);
+	bytes = (bytes + RB_FROZEN_LINE - 1) & ~((size_t) RB_FROZEN_LINE - 1);
+
+	frozen->keys = aligned_alloc(RB_FROZEN_LINE, bytes);
+	frozen->nodes = malloc((n + 1) * sizeof(*frozen->nodes));
+	if (!frozen->keys || !frozen->nodes) {
+		free(frozen->keys);
+		free(frozen->nodes);
+		return false;
+	}
+
+	/* index 0 is where every miss lands */
+	frozen->n = n;
+	frozen->keys[0] = 0;
+	frozen->nodes[0] = NULL;
+
+	if (n) __rb_frozen_fill(frozen, key, rb_first(tree), 1);
+	return true;
+}
+
+/**
+ * @fn rb_frozen_destroy
+ * @brief Frees a snapshot. The tree and its nodes are untouched.
+ * @param[in] frozen Pointer to an rb_frozen instance.
+ */
+void rb_frozen_destroy(rb_frozen_t *frozen) {
+	free(frozen->keys);
+	free(frozen->nodes);
+
+	frozen->keys = NULL;
+	frozen->nodes = NULL;
+	frozen->n = 0;
+}
+
+/**
+ * @fn rb_frozen_lower_bound
+ * @brief Returns the first node whose key is not less than key, or NULL, in the same place rb_lower_bound would.
+ * @param[in] frozen Pointer to an rb_frozen instance.
+ * @param[in] key Key to bound.
+ */
+const rb_node_t *rb_frozen_lower_bound(const rb_frozen_t *frozen, uint64_t key) {
+	return frozen->nodes[__rb_frozen_descend(frozen, key, false)];
+}
+
+/**
+ * @fn rb_frozen_upper_bound
+ * @brief Returns the first node whose key is greater than key, or NULL.
+ * @param[in] frozen Pointer to an rb_frozen instance.
+ * @param[in] key Key to bound.
+ */
+const rb_node_t *rb_frozen_upper_bound(const rb_frozen_t *frozen, uint64_t key) {
+	return frozen->nodes[__rb_frozen_descend(frozen, key, true)];
+}
+
+/**
+ * @fn rb_frozen_find
+ * @brief Returns the first node with exactly this key, or NULL.
+ * @param[in] frozen Pointer to an rb_frozen instance.
+ * @param[in] key Key to find.
+ */
+const rb_node_t *rb_frozen_find(const rb_frozen_t *frozen, uint64_t key) {
+	size_t k = __rb_frozen_descend(frozen, key, false);
+
+	return (k && frozen->keys[k] == key) ? frozen->nodes[k] : NULL;
+}
+
+/**
+ * @fn rb_frozen_lower_bound_batch
+ * @brief Same as rb_frozen_lower_bound for many keys, walking several of them down the array at once.
+ * @details Lookups that miss cache spend most of their time waiting on memory; interleaving independent ones keeps
+ * several of those waits in flight together. Uses AVX2 gathers when built with it enabled.
+ * @param[in] frozen Pointer to an rb_frozen instance.
+ * @param[in] keys Keys to bound.
+ * @param[in] n Number of keys.
+ * @param[out] out The result for keys[i] goes to out[i].
+ */
+void rb_frozen_lower_bound_batch(const rb_frozen_t *frozen, const uint64_t *keys, size_t n, const rb_node_t **out) {
+	size_t levels = __rb_frozen_levels(frozen->n), i = 0;
+	uint64_t k[RB_FROZEN_LANES];
+
+	for (; i + RB_FROZEN_LANES <= n; i += RB_FROZEN_LANES) {
+		__rb_frozen_descend_lanes(frozen, keys + i, levels, k);
+		for (size_t lane = 0; lane < RB_FROZEN_LANES; lane++) out[i + lane] = frozen->nodes[__rb_frozen_resolve(k[lane])];
+	}
+
+	/* whatever doesn't fill a whole batch goes one at a time */
+	for (; i < n; i++) out[i] = rb_frozen_lower_bound(frozen, keys[i]);
+}
+
+/** @} */
@@ -0,0 +1,105 @@
+/**
+ * @file rbtree_frozen.h
+ * @author krad2
+ * @brief Read-only snapshots of a tree with integer keys, laid out in Eytzinger order for fast lookups.
+ * @details A tree that is rebuilt now and then and only read in between pays for its flexibility on every lookup:
+ * each step of __rb_find loads a node from wherever it was allocated and calls the comparator on it. Freezing the
+ * tree copies its keys, in order, into one cache-line-aligned array laid out like an implicit heap (Eytzinger
+ * order), so the top levels of every search share a handful of cache lines and the next few levels can be prefetched.
+ * Each search compiles to a short branch-free loop, and a batched search walks several keys at once, with AVX2 when
+ * it's enabled at compile time. Every hit maps back to the rb_node_t it came from. The snapshot doesn't track the
+ * tree; changes to either one after freezing don't show up in the other.
+ */
+
+#ifndef RBTREE_FROZEN_H_
+#define RBTREE_FROZEN_H_
+
+#include "rbtree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct rb_frozen
+ * @brief A frozen snapshot of a tree's keys and nodes.
+ * @var rb_frozen::keys
+ * Keys in Eytzinger order, from index 1. keys[0] is unused.
+ * @var rb_frozen::nodes
+ * The node each key came from, at the same index.
+ * @var rb_frozen::n
+ * Number of keys.
+ */
+typedef struct rb_frozen {
+	uint64_t *keys;
+	const rb_node_t **nodes;
+	size_t n;
+} rb_frozen_t;
+
+/**
+ * @defgroup rb_frozen_api Frozen snapshot API.
+ * @{
+ */
+
+/**
+ * @fn rb_tree_freeze
+ * @brief Takes a read-only snapshot of a tree whose order matches an unsigned 64-bit key, in O(n).
+ * @details Signed or narrower keys work too, as long as the extractor maps them to uint64_t without changing their
+ * order, e.g. by flipping the sign bit of an int64_t.
+ * @param[in] tree Pointer to an rb_tree instance, or any of the cached trees cast to one.
+ * @param[in] key Returns a node's key. Must agree with the comparator the tree was built with.
+ * @param[out] frozen Pointer to an rb_frozen instance to fill in.
+ * @return False if there wasn't memory for the snapshot, in which case there's nothing to destroy.
+ */
+bool rb_tree_freeze(const rb_tree_t *tree, uint64_t (*key)(const rb_node_t *node), rb_frozen_t *frozen);
+
+/**
+ * @fn rb_frozen_destroy
+ * @brief Frees a snapshot. The tree and its nodes are untouched.
+ * @param[in] frozen Pointer to an rb_frozen instance.
+ */
+void rb_frozen_destroy(rb_frozen_t *frozen);
+
+/**
+ * @fn rb_frozen_lower_bound
+ * @brief Returns the first node whose key is not less than key, or NULL, in the same place rb_lower_bound would.
+ * @param[in] frozen Pointer to an rb_frozen instance.
+ * @param[in] key Key to bound.
+ */
+const rb_node_t *rb_frozen_lower_bound(const rb_frozen_t *frozen, uint64_t key);
+
+/**
+ * @fn rb_frozen_upper_bound
+ * @brief Returns the first node whose key is greater than key, or NULL.
+ * @param[in] frozen Pointer to an rb_frozen instance.
+ * @param[in] key Key to bound.
+ */
+const rb_node_t *rb_frozen_upper_bound(const rb_frozen_t *frozen, uint64_t key);
+
+/**
+ * @fn rb_frozen_find
+ * @brief Returns the first node with exactly this key, or NULL.
+ * @param[in] frozen Pointer to an rb_frozen instance.
+ * @param[in] key Key to find.
+ */
+const rb_node_t *rb_frozen_find(const rb_frozen_t *frozen, uint64_t key);
+
+/**
+ * @fn rb_frozen_lower_bound_batch
+ * @brief Same as rb_frozen_lower_bound for many keys, walking several of them down the array at once.
+ * @details Lookups that miss cache spend most of their time waiting on memory; interleaving independent ones keeps
+ * several of those waits in flight together. Uses AVX2 gathers when built with it enabled.
+ * @param[in] frozen Pointer to an rb_frozen instance.
+ * @param[in] keys Keys to bound.
+ * @param[in] n Number of keys.
+ * @param[out] out The result for keys[i] goes to out[i].
+ */
+void rb_frozen_lower_bound_batch(const rb_frozen_t *frozen, const uint64_t *keys, size_t n, const rb_node_t **out);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RBTREE_FROZEN_H_ */
@@ -0,0 +1,604 @@
+/**
+ * @file rbtree_index.c
+ * @author krad2
+ * @brief A red-black tree linked by 32-bit array indices instead of pointers, with a 12-byte node.
+ */
+
+#include "rbtree_index.h"
+
+/**
+ * @defgroup rb_index_links Helper functions for the links of rb_index_node_t.
+ * @{
+ */
+
+#define RB_INDEX_BLACK										((uint32_t) rb_black)
+
+/* --- */
+
+/** RB_INDEX_NIL counts as black, same as NULL does for pointer nodes. */
+static inline bool __rb_index_is_black(const rb_index_tree_t *tree, rb_index_t i) {
+	return i == RB_INDEX_NIL || (rb_index_node(tree, i)->__rb_parent_color & RB_INDEX_BLACK);
+}
+
+static inline bool __rb_index_is_red(const rb_index_tree_t *tree, rb_index_t i) {
+	return !__rb_index_is_black(tree, i);
+}
+
+static inline void __rb_index_set_black(const rb_index_tree_t *tree, rb_index_t i) {
+	rb_index_node(tree, i)->__rb_parent_color |= RB_INDEX_BLACK;
+}
+
+static inline void __rb_index_set_red(const rb_index_tree_t *tree, rb_index_t i) {
+	rb_index_node(tree, i)->__rb_parent_color &= ~RB_INDEX_BLACK;
+}
+
+static inline void __rb_index_set_color(const rb_index_tree_t *tree, rb_index_t i, uint32_t color) {
+	rb_index_node_t *node = rb_index_node(tree, i);
+	node->__rb_parent_color = (node->__rb_parent_color & ~RB_INDEX_BLACK) | color;
+}
+
+static inline void __rb_index_set_parent(const rb_index_tree_t *tree, rb_index_t i, rb_index_t parent) {
+
+	/* same packing as __rb_set_parent, with the index shifted up to make room for the color */
+	if (i != RB_INDEX_NIL) {
+		rb_index_node_t *node = rb_index_node(tree, i);
+		node->__rb_parent_color = (parent << 1) | (node->__rb_parent_color & RB_INDEX_BLACK);
+	}
+}
+
+static inline void __rb_index_set_parent_and_color(const rb_index_tree_t *tree, rb_index_t i, rb_index_t parent, uint32_t color) {
+	rb_index_node(tree, i)->__rb_parent_color = (parent << 1) | color;
+}
+
+static inline void __rb_index_replace_child(rb_index_tree_t *tree, rb_index_t root, rb_index_t old, rb_index_t nw) {
+	if (root != RB_INDEX_NIL) {
+		rb_index_node_t *node = rb_index_node(tree, root);
+
+		/* links 'new' in place of 'old' on the side of 'root' that 'old' was on */
+		if (node->left == old) node->left = nw;
+		else node->right = nw;
+
+	/* 'old' had no parent, so 'new' is the tree's root now */
+	} else tree->root = nw;
+
+	__rb_index_set_parent(tree, nw, root);
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_index_rotations Index tree rotation operations
+ * @{
+ */
+
+/**
+ * @brief Rotates the subtree at root to the left, moving the tree's root along with it if needed.
+ */
+static inline void __rb_index_left_rotate(rb_index_tree_t *tree, rb_index_t root) {
+	rb_index_node_t *node = rb_index_node(tree, root);
+	rb_index_t upper_root = rb_index_parent(node);
+	rb_index_t pivot = node->right;
+	rb_index_node_t *pivot_node = rb_index_node(tree, pivot);
+
+	node->right = pivot_node->left;							/** the pivot's left subtree moves under the old root */
+	__rb_index_set_parent(tree, node->right, root);
+
+	pivot_node->left = root;								/** the old root hangs off of the pivot */
+	__rb_index_set_parent(tree, root, pivot);
+
+	__rb_index_replace_child(tree, upper_root, root, pivot);	/** and the pivot takes its place above */
+}
+
+/**
+ * @brief Rotates the subtree at root to the right, moving the tree's root along with it if needed.
+ */
+static inline void __rb_index_right_rotate(rb_index_tree_t *tree, rb_index_t root) {
+	rb_index_node_t *node = rb_index_node(tree, root);
+	rb_index_t upper_root = rb_index_parent(node);
+	rb_index_t pivot = node->left;
+	rb_index_node_t *pivot_node = rb_index_node(tree, pivot);
+
+	node->left = pivot_node->right;							/** the pivot's right subtree moves under the old root */
+	__rb_index_set_parent(tree, node->left, root);
+
+	pivot_node->right = root;								/** the old root hangs off of the pivot */
+	__rb_index_set_parent(tree, root, pivot);
+
+	__rb_index_replace_child(tree, upper_root, root, pivot);	/** and the pivot takes its place above */
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_index_updates Index tree insertion and deletion helpers.
+ * @{
+ */
+
+/**
+ * @brief Restores the red-black invariants above a freshly linked red node, like __rb_insert_rebalance.
+ */
+static inline void __rb_index_insert_rebalance(rb_index_tree_t *tree, rb_index_t node) {
+	for (;;) {
+		rb_index_t parent = rb_index_parent(rb_index_node(tree, node));
+		rb_index_t grandparent, uncle;
+		rb_index_node_t *grandparent_node;
+
+		/* hitting the root means we're done - make sure it's black afterwards */
+		if (parent == RB_INDEX_NIL) {
+			__rb_index_set_black(tree, node);
+			return;
+		}
+
+		/* a black parent can take a red child */
+		if (__rb_index_is_black(tree, parent)) return;
+
+		/* a red parent is never the root, so the grandparent exists */
+		grandparent = rb_index_parent(rb_index_node(tree, parent));
+		grandparent_node = rb_index_node(tree, grandparent);
+		uncle = (grandparent_node->left == parent) ? grandparent_node->right : grandparent_node->left;
+
+		/* try a recolor first */
+		if (__rb_index_is_red(tree, uncle)) {
+			__rb_index_set_black(tree, parent);
+			__rb_index_set_black(tree, uncle);
+			__rb_index_set_red(tree, grandparent);
+			node = grandparent;
+			continue;
+		}
+
+		if (parent == grandparent_node->left) {
+
+			/* left-right: convert it to the left-left case, which swaps the roles of node and parent */
+			if (node == rb_index_node(tree, parent)->right) {
+				__rb_index_left_rotate(tree, parent);
+				parent = node;
+			}
+
+			/* left-left */
+			__rb_index_set_black(tree, parent);
+			__rb_index_set_red(tree, grandparent);
+			__rb_index_right_rotate(tree, grandparent);
+		} else {
+
+			/* right-left: convert it to the right-right case */
+			if (node == rb_index_node(tree, parent)->left) {
+				__rb_index_right_rotate(tree, parent);
+				parent = node;
+			}
+
+			/* right-right */
+			__rb_index_set_black(tree, parent);
+			__rb_index_set_red(tree, grandparent);
+			__rb_index_left_rotate(tree, grandparent);
+		}
+
+		/* the subtree's new root is black, so nothing above it can be in violation */
+		return;
+	}
+}
+
+/**
+ * @brief Performs the delete fixup on the subtree centered on node, like __rb_delete_rebalance.
+ */
+static inline void __rb_index_delete_rebalance(rb_index_tree_t *tree, rb_index_t node) {
+	for (;;) {
+		rb_index_t parent = rb_index_parent(rb_index_node(tree, node));
+		rb_index_t sibling, sibling_lchild, sibling_rchild;
+		rb_index_node_t *parent_node, *sibling_node;
+
+		/* if we hit the root, we're done, and the root must always be black */
+		if (parent == RB_INDEX_NIL || __rb_index_is_red(tree, node)) {
+			__rb_index_set_black(tree, node);
+			return;
+		}
+
+		/* otherwise black height property is in violation and we'll need the sibling, which a black node always has */
+		parent_node = rb_index_node(tree, parent);
+		sibling = (parent_node->left == node) ? parent_node->right : parent_node->left;
+
+		/* move a red sibling above the parent so the new sibling is black */
+		if (__rb_index_is_red(tree, sibling)) {
+			__rb_index_set_black(tree, sibling);
+			__rb_index_set_red(tree, parent);
+
+			if (sibling == parent_node->right) __rb_index_left_rotate(tree, parent);
+			else __rb_index_right_rotate(tree, parent);
+
+			sibling = (parent_node->left == node) ? parent_node->right : parent_node->left;
+		}
+
+		sibling_node = rb_index_node(tree, sibling);
+		sibling_lchild = sibling_node->left;
+		sibling_rchild = sibling_node->right;
+
+		/* if the nephew / niece can't take the black recolor, try to propagate it up and dissolve it further up */
+		if (__rb_index_is_black(tree, sibling_lchild) && __rb_index_is_black(tree, sibling_rchild)) {
+			__rb_index_set_red(tree, sibling);
+			node = parent;
+			continue;
+		}
+
+		if (sibling == parent_node->right) {
+
+			/* right-left: pull the inner red up so the far one is red */
+			if (__rb_index_is_black(tree, sibling_rchild)) {
+				__rb_index_set_black(tree, sibling_lchild);
+				__rb_index_set_red(tree, sibling);
+				__rb_index_right_rotate(tree, sibling);
+
+				sibling_rchild = sibling;
+				sibling = parent_node->right;
+			}
+
+			/* right-right */
+			__rb_index_set_color(tree, sibling, rb_index_color(parent_node));
+			__rb_index_set_black(tree, parent);
+			__rb_index_set_black(tree, sibling_rchild);
+			__rb_index_left_rotate(tree, parent);
+		} else {
+
+			/* left-right */
+			if (__rb_index_is_black(tree, sibling_lchild)) {
+				__rb_index_set_black(tree, sibling_rchild);
+				__rb_index_set_red(tree, sibling);
+				__rb_index_left_rotate(tree, sibling);
+
+				sibling_lchild = sibling;
+				sibling = parent_node->left;
+			}
+
+			/* left-left */
+			__rb_index_set_color(tree, sibling, rb_index_color(parent_node));
+			__rb_index_set_black(tree, parent);
+			__rb_index_set_black(tree, sibling_lchild);
+			__rb_index_right_rotate(tree, parent);
+		}
+
+		return;
+	}
+}
+
+/**
+ * @brief Trades tree positions between target and its in-order successor, like __rb_swap_successor.
+ * @details Afterwards, target sits where the successor was and has at most a right child.
+ */
+static inline void __rb_index_swap_successor(rb_index_tree_t *tree, rb_index_t target, rb_index_t successor) {
+	rb_index_node_t *target_node = rb_index_node(tree, target);
+	rb_index_node_t *successor_node = rb_index_node(tree, successor);
+	rb_index_t parent = rb_index_parent(target_node);
+	rb_index_t left = target_node->left;
+	rb_index_t right = target_node->right;
+	rb_index_t successor_parent = rb_index_parent(successor_node);
+	rb_index_t successor_right = successor_node->right;
+	uint32_t target_color = rb_index_color(target_node);
+	uint32_t successor_color = rb_index_color(successor_node);
+
+	/* the successor takes over the target's link from above, along with its color */
+	__rb_index_replace_child(tree, parent, target, successor);
+	__rb_index_set_parent_and_color(tree, successor, parent, target_color);
+
+	successor_node->left = left;
+	__rb_index_set_parent(tree, left, successor);
+
+	/* if the successor was the target's right child, the target simply hangs off of it on that side */
+	if (successor == right) {
+		successor_node->right = target;
+		__rb_index_set_parent(tree, target, successor);
+	} else {
+		successor_node->right = right;
+		__rb_index_set_parent(tree, right, successor);
+
+		rb_index_node(tree, successor_parent)->left = target;
+		__rb_index_set_parent(tree, target, successor_parent);
+	}
+
+	/* the target adopts whatever the successor left behind */
+	target_node->left = RB_INDEX_NIL;
+	target_node->right = successor_right;
+	__rb_index_set_parent(tree, successor_right, target);
+	__rb_index_set_color(tree, target, successor_color);
+}
+
+/**
+ * @brief Unlinks target from its tree by relinking its neighbors, like __rb_erase, and leaves it detached.
+ */
+static inline void __rb_index_erase(rb_index_tree_t *tree, rb_index_t target) {
+	rb_index_node_t *target_node = rb_index_node(tree, target);
+	rb_index_t child;
+
+	/* with two children, swap into the successor's spot first so at most one child is left to splice */
+	if (target_node->left != RB_INDEX_NIL && target_node->right != RB_INDEX_NIL) {
+		rb_index_t successor = target_node->right;
+
+		while (rb_index_node(tree, successor)->left != RB_INDEX_NIL) successor = rb_index_node(tree, successor)->left;
+		__rb_index_swap_successor(tree, target, successor);
+	}
+
+	child = (target_node->left != RB_INDEX_NIL) ? target_node->left : target_node->right;
+
+	/* a black leaf shortens its path, so fix that up while the target still holds its place */
+	if (child == RB_INDEX_NIL && __rb_index_is_black(tree, target)) __rb_index_delete_rebalance(tree, target);
+
+	__rb_index_replace_child(tree, rb_index_parent(target_node), target, child);
+	if (child != RB_INDEX_NIL) __rb_index_set_black(tree, child);
+
+	/* loop the target back on itself, same as rb_disconnect */
+	__rb_index_set_parent_and_color(tree, target, target, RB_INDEX_BLACK);
+	target_node->left = target_node->right = RB_INDEX_NIL;
+}
+
+/**
+ * @brief Finds where the element at i would go, after any equal elements. Stops early on an equal one if unique.
+ * @return The equal element found, or RB_INDEX_NIL once *parent and *left describe the empty slot.
+ */
+static inline rb_index_t __rb_index_descend(const rb_index_tree_t *tree, const rb_index_node_t *node, int (*cmp)(const rb_index_node_t *left, const rb_index_node_t *right), bool unique, rb_index_t *parent, bool *left) {
+	rb_index_t cursor = tree->root;
+
+	*parent = RB_INDEX_NIL;
+	*left = false;
+
+	while (cursor != RB_INDEX_NIL) {
+		const rb_index_node_t *cursor_node = rb_index_node(tree, cursor);
+		int comparison = cmp(node, cursor_node);
+
+		if (unique && comparison == 0) return cursor;
+
+		*parent = cursor;
+		*left = comparison < 0;
+		cursor = *left ? cursor_node->left : cursor_node->right;
+	}
+
+	return RB_INDEX_NIL;
+}
+
+/**
+ * @brief Hangs the element at i off of parent as a red leaf and rebalances.
+ */
+static inline void __rb_index_link(rb_index_tree_t *tree, rb_index_t i, rb_index_t parent, bool left) {
+	rb_index_node_t *node = rb_index_node(tree, i);
+
+	__rb_index_set_parent_and_color(tree, i, parent, (uint32_t) rb_red);
+	node->left = node->right = RB_INDEX_NIL;
+
+	if (parent == RB_INDEX_NIL) tree->root = i;
+	else if (left) rb_index_node(tree, parent)->left = i;
+	else rb_index_node(tree, parent)->right = i;
+
+	__rb_index_insert_rebalance(tree, i);
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_index_api Index tree API.
+ * @{
+ */
+
+/**
+ * @fn rb_index_tree_init
+ * @brief Initializes an empty tree over an array.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] base The array. Elements become part of the tree only once inserted.
+ * @param[in] stride Size of one array element.
+ * @param[in] offset Offset of the rb_index_node_t within each element.
+ */
+void rb_index_tree_init(rb_index_tree_t *tree, void *base, size_t stride, size_t offset) {
+	tree->base = base;
+	tree->stride = stride;
+	tree->offset = offset;
+	tree->root = RB_INDEX_NIL;
+}
+
+/**
+ * @fn rb_index_tree_insert
+ * @brief Inserts the element at an index. Equal keys go after the ones already there, same as rb_tree_insert.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] i Index of an element that isn't in the tree, below RB_INDEX_NIL.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+void rb_index_tree_insert(rb_index_tree_t *tree, rb_index_t i, int (*cmp)(const rb_index_node_t *left, const rb_index_node_t *right)) {
+	rb_index_t parent;
+	bool left;
+
+	__rb_index_descend(tree, rb_index_node(tree, i), cmp, false, &parent, &left);
+	__rb_index_link(tree, i, parent, left);
+}
+
+/**
+ * @fn rb_index_tree_insert_unique
+ * @brief Inserts the element at an index unless an equal one is already in the tree.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] i Index of an element that isn't in the tree, below RB_INDEX_NIL.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ * @return RB_INDEX_NIL if the element was inserted, else the index of the equal element that blocked it.
+ */
+rb_index_t rb_index_tree_insert_unique(rb_index_tree_t *tree, rb_index_t i, int (*cmp)(const rb_index_node_t *left, const rb_index_node_t *right)) {
+	rb_index_t parent, existing;
+	bool left;
+
+	existing = __rb_index_descend(tree, rb_index_node(tree, i), cmp, true, &parent, &left);
+	if (existing == RB_INDEX_NIL) __rb_index_link(tree, i, parent, left);
+
+	return existing;
+}
+
+/**
+ * @fn rb_index_tree_delete_at
+ * @brief Unlinks the element at an index without searching for it. The element comes out detached.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] i Index of an element in the tree.
+ */
+void rb_index_tree_delete_at(rb_index_tree_t *tree, rb_index_t i) {
+	__rb_index_erase(tree, i);
+}
+
+/**
+ * @fn rb_index_tree_delete
+ * @brief Finds an element equal to key and unlinks it.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] key Node to compare against. Doesn't need to be in the array.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ * @return Index of the element deleted, or RB_INDEX_NIL if there was none.
+ */
+rb_index_t rb_index_tree_delete(rb_index_tree_t *tree, const rb_index_node_t *key, int (*cmp)(const rb_index_node_t *left, const rb_index_node_t *right)) {
+	rb_index_t i = rb_index_find(tree, key, cmp);
+
+	if (i != RB_INDEX_NIL) __rb_index_erase(tree, i);
+	return i;
+}
+
+/**
+ * @fn rb_index_find
+ * @brief Binary search to find 'key'. Returns RB_INDEX_NIL if not found.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] key Node to compare against. Doesn't need to be in the array.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+rb_index_t rb_index_find(const rb_index_tree_t *tree, const rb_index_node_t *key, int (*cmp)(const rb_index_node_t *left, const rb_index_node_t *right)) {
+	rb_index_t cursor = tree->root;
+
+	while (cursor != RB_INDEX_NIL) {
+		const rb_index_node_t *node = rb_index_node(tree, cursor);
+		int comparison = cmp(key, node);
+
+		if (comparison == 0) break;
+		cursor = (comparison < 0) ? node->left : node->right;
+	}
+
+	return cursor;
+}
+
+/**
+ * @fn rb_index_lower_bound
+ * @brief Returns the first element that does not compare less than key, or RB_INDEX_NIL.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] key Node to compare against. Doesn't need to be in the array.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+rb_index_t rb_index_lower_bound(const rb_index_tree_t *tree, const rb_index_node_t *key, int (*cmp)(const rb_index_node_t *left, const rb_index_node_t *right)) {
+	rb_index_t cursor = tree->root, bound = RB_INDEX_NIL;
+
+	/* an equal element doesn't stop the descent - there may be more of them to the left */
+	while (cursor != RB_INDEX_NIL) {
+		const rb_index_node_t *node = rb_index_node(tree, cursor);
+
+		if (cmp(key, node) <= 0) {
+			bound = cursor;
+			cursor = node->left;
+		} else {
+			cursor = node->right;
+		}
+	}
+
+	return bound;
+}
+
+/**
+ * @fn rb_index_upper_bound
+ * @brief Returns the first element that compares greater than key, or RB_INDEX_NIL.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] key Node to compare against. Doesn't need to be in the array.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+rb_index_t rb_index_upper_bound(const rb_index_tree_t *tree, const rb_index_node_t *key, int (*cmp)(const rb_index_node_t *left, const rb_index_node_t *right)) {
+	rb_index_t cursor = tree->root, bound = RB_INDEX_NIL;
+
+	/* same as rb_index_lower_bound, except equal elements are skipped over to the right */
+	while (cursor != RB_INDEX_NIL) {
+		const rb_index_node_t *node = rb_index_node(tree, cursor);
+
+		if (cmp(key, node) < 0) {
+			bound = cursor;
+			cursor = node->left;
+		} else {
+			cursor = node->right;
+		}
+	}
+
+	return bound;
+}
+
+/**
+ * @fn rb_index_first
+ * @brief Returns the smallest element, or RB_INDEX_NIL if the tree is empty.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ */
+rb_index_t rb_index_first(const rb_index_tree_t *tree) {
+	rb_index_t i = tree->root;
+
+	if (i != RB_INDEX_NIL) {
+		while (rb_index_node(tree, i)->left != RB_INDEX_NIL) i = rb_index_node(tree, i)->left;
+	}
+
+	return i;
+}
+
+/**
+ * @fn rb_index_last
+ * @brief Returns the largest element, or RB_INDEX_NIL if the tree is empty.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ */
+rb_index_t rb_index_last(const rb_index_tree_t *tree) {
+	rb_index_t i = tree->root;
+
+	if (i != RB_INDEX_NIL) {
+		while (rb_index_node(tree, i)->right != RB_INDEX_NIL) i = rb_index_node(tree, i)->right;
+	}
+
+	return i;
+}
+
+/**
+ * @fn rb_index_next
+ * @brief Returns the in-order successor of an element, or RB_INDEX_NIL if it's the last.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] i Index of an element in the tree.
+ */
+rb_index_t rb_index_next(const rb_index_tree_t *tree, rb_index_t i) {
+	const rb_index_node_t *node = rb_index_node(tree, i);
+	rb_index_t parent;
+
+	/* the leftmost element of the right subtree, if there is one */
+	if (node->right != RB_INDEX_NIL) {
+		i = node->right;
+		while (rb_index_node(tree, i)->left != RB_INDEX_NIL) i = rb_index_node(tree, i)->left;
+		return i;
+	}
+
+	/* otherwise the first ancestor reached from its left side */
+	while ((parent = rb_index_parent(node)) != RB_INDEX_NIL) {
+		node = rb_index_node(tree, parent);
+		if (node->left == i) break;
+		i = parent;
+	}
+
+	return parent;
+}
+
+/**
+ * @fn rb_index_prev
+ * @brief Returns the in-order predecessor of an element, or RB_INDEX_NIL if it's the first.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] i Index of an element in the tree.
+ */
+rb_index_t rb_index_prev(const rb_index_tree_t *tree, rb_index_t i) {
+	const rb_index_node_t *node = rb_index_node(tree, i);
+	rb_index_t parent;
+
+	/* mirror image of rb_index_next */
+	if (node->left != RB_INDEX_NIL) {
+		i = node->left;
+		while (rb_index_node(tree, i)->right != RB_INDEX_NIL) i = rb_index_node(tree, i)->right;
+		return i;
+	}
+
+	while ((parent = rb_index_parent(node)) != RB_INDEX_NIL) {
+		node = rb_index_node(tree, parent);
+		if (node->right == i) break;
+		i = parent;
+	}
+
+	return parent;
+}
+
+/** @} */
@@ -0,0 +1,226 @@
+/**
+ * @file rbtree_index.h
+ * @author krad2
+ * @brief A red-black tree linked by 32-bit array indices instead of pointers, with a 12-byte node.
+ * @details rb_node_t spends 24 bytes on links on a 64-bit machine, which adds up in large indexes and leaves less
+ * room for keys in each cache line a lookup touches. When every object lives in one array, a 32-bit index is
+ * enough to name it, so rb_index_node_t stores its parent, left and right links as indices into that array, with
+ * the color in the low bit of the parent link. That halves the node and leaves it with 4-byte alignment, so a
+ * 4-byte key packs in next to it. The price is that nodes can only link to objects in the same array, and that
+ * every link is followed with a multiply-add instead of a load. Since links are indices, the array itself can be
+ * moved, e.g. by realloc, without touching the tree; just repoint 'base'.
+ */
+
+#ifndef RBTREE_INDEX_H_
+#define RBTREE_INDEX_H_
+
+#include "rbtree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @typedef rb_index_t
+ * @brief Position of an object in a tree's array.
+ */
+typedef uint32_t rb_index_t;
+
+/**
+ * @struct rb_index_node
+ * @brief An index-linked tree node to be embedded in something else.
+ * @var rb_index_node::__rb_parent_color
+ * Index of the parent shifted left by one, with the color in the low bit. Maintained by the tree, don't touch.
+ * @var rb_index_node::left
+ * Index of the left child, or RB_INDEX_NIL.
+ * @var rb_index_node::right
+ * Index of the right child, or RB_INDEX_NIL.
+ */
+typedef struct rb_index_node {
+	uint32_t __rb_parent_color;
+	rb_index_t left;
+	rb_index_t right;
+} rb_index_node_t;
+
+/**
+ * @struct rb_index_tree
+ * @brief An index-linked tree over an array of objects of one type.
+ * @var rb_index_tree::base
+ * The array. May be reassigned after the array moves.
+ * @var rb_index_tree::stride
+ * Size of one array element, e.g. sizeof(struct a).
+ * @var rb_index_tree::offset
+ * Offset of the rb_index_node_t within each element, e.g. offsetof(struct a, node).
+ * @var rb_index_tree::root
+ * Index of the root, or RB_INDEX_NIL if the tree is empty.
+ */
+typedef struct rb_index_tree {
+	void *base;
+	size_t stride;
+	size_t offset;
+	rb_index_t root;
+} rb_index_tree_t;
+
+/**
+ * @defgroup rb_index_macros Index tree macros.
+ * @{
+ */
+
+/**
+ * The missing link. Links have 31 bits, so this is also one past the largest index a tree can use.
+ */
+#define RB_INDEX_NIL										((rb_index_t) 0x7fffffff)
+
+/**
+ * Returns the array element at an index, as a void *.
+ */
+#define rb_index_object(tree, i)							((void *) ((char *) (tree)->base + (size_t) (i) * (tree)->stride))
+
+/**
+ * Returns the rb_index_node_t of the array element at an index.
+ */
+#define rb_index_node(tree, i)								((rb_index_node_t *) ((char *) rb_index_object(tree, i) + (tree)->offset))
+
+/**
+ * Returns the containing structure of the array element at an index.
+ */
+#define rb_index_entry(tree, i, type)						((type *) rb_index_object(tree, i))
+
+/**
+ * Returns the index of a node's parent, or RB_INDEX_NIL at the root.
+ */
+#define rb_index_parent(node)								((rb_index_t) ((node)->__rb_parent_color >> 1))
+
+/**
+ * Returns the color of a node.
+ */
+#define rb_index_color(node)								((rb_color_t) ((node)->__rb_parent_color & 1))
+
+/**
+ * Returns true if the tree has no nodes.
+ */
+#define rb_index_is_empty(tree)								((tree)->root == RB_INDEX_NIL)
+
+/**
+ * Returns true if the element at an index was deleted from its tree and not inserted since, like rb_is_disconnected.
+ */
+#define rb_index_is_detached(tree, i)						(rb_index_parent(rb_index_node(tree, i)) == (rb_index_t) (i))
+
+/** @} */
+
+/**
+ * @defgroup rb_index_api Index tree API.
+ * @{
+ */
+
+/**
+ * @fn rb_index_tree_init
+ * @brief Initializes an empty tree over an array.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] base The array. Elements become part of the tree only once inserted.
+ * @param[in] stride Size of one array element.
+ * @param[in] offset Offset of the rb_index_node_t within each element.
+ */
+void rb_index_tree_init(rb_index_tree_t *tree, void *base, size_t stride, size_t offset);
+
+/**
+ * @fn rb_index_tree_insert
+ * @brief Inserts the element at an index. Equal keys go after the ones already there, same as rb_tree_insert.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] i Index of an element that isn't in the tree, below RB_INDEX_NIL.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+void rb_index_tree_insert(rb_index_tree_t *tree, rb_index_t i, int (*cmp)(const rb_index_node_t *left, const rb_index_node_t *right));
+
+/**
+ * @fn rb_index_tree_insert_unique
+ * @brief Inserts the element at an index unless an equal one is already in the tree.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] i Index of an element that isn't in the tree, below RB_INDEX_NIL.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ * @return RB_INDEX_NIL if the element was inserted, else the index of the equal element that blocked it.
+ */
+rb_index_t rb_index_tree_insert_unique(rb_index_tree_t *tree, rb_index_t i, int (*cmp)(const rb_index_node_t *left, const rb_index_node_t *right));
+
+/**
+ * @fn rb_index_tree_delete_at
+ * @brief Unlinks the element at an index without searching for it. The element comes out detached.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] i Index of an element in the tree.
+ */
+void rb_index_tree_delete_at(rb_index_tree_t *tree, rb_index_t i);
+
+/**
+ * @fn rb_index_tree_delete
+ * @brief Finds an element equal to key and unlinks it.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] key Node to compare against. Doesn't need to be in the array.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ * @return Index of the element deleted, or RB_INDEX_NIL if there was none.
+ */
+rb_index_t rb_index_tree_delete(rb_index_tree_t *tree, const rb_index_node_t *key, int (*cmp)(const rb_index_node_t *left, const rb_index_node_t *right));
+
+/**
+ * @fn rb_index_find
+ * @brief Binary search to find 'key'. Returns RB_INDEX_NIL if not found.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] key Node to compare against. Doesn't need to be in the array.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+rb_index_t rb_index_find(const rb_index_tree_t *tree, const rb_index_node_t *key, int (*cmp)(const rb_index_node_t *left, const rb_index_node_t *right));
+
+/**
+ * @fn rb_index_lower_bound
+ * @brief Returns the first element that does not compare less than key, or RB_INDEX_NIL.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] key Node to compare against. Doesn't need to be in the array.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+rb_index_t rb_index_lower_bound(const rb_index_tree_t *tree, const rb_index_node_t *key, int (*cmp)(const rb_index_node_t *left, const rb_index_node_t *right));
+
+/**
+ * @fn rb_index_upper_bound
+ * @brief Returns the first element that compares greater than key, or RB_INDEX_NIL.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] key Node to compare against. Doesn't need to be in the array.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+rb_index_t rb_index_upper_bound(const rb_index_tree_t *tree, const rb_index_node_t *key, int (*cmp)(const rb_index_node_t *left, const rb_index_node_t *right));
+
+/**
+ * @fn rb_index_first
+ * @brief Returns the smallest element, or RB_INDEX_NIL if the tree is empty.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ */
+rb_index_t rb_index_first(const rb_index_tree_t *tree);
+
+/**
+ * @fn rb_index_last
+ * @brief Returns the largest element, or RB_INDEX_NIL if the tree is empty.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ */
+rb_index_t rb_index_last(const rb_index_tree_t *tree);
+
+/**
+ * @fn rb_index_next
+ * @brief Returns the in-order successor of an element, or RB_INDEX_NIL if it's the last.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] i Index of an element in the tree.
+ */
+rb_index_t rb_index_next(const rb_index_tree_t *tree, rb_index_t i);
+
+/**
+ * @fn rb_index_prev
+ * @brief Returns the in-order predecessor of an element, or RB_INDEX_NIL if it's the first.
+ * @param[in] tree Pointer to an rb_index_tree instance.
+ * @param[in] i Index of an element in the tree.
+ */
+rb_index_t rb_index_prev(const rb_index_tree_t *tree, rb_index_t i);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RBTREE_INDEX_H_ */
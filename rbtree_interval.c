@@ -0,0 +1,180 @@
+/**
+ * @file rbtree_interval.c
+ * @author krad2
+ * @brief An interval tree built on the augmented red-black tree, modeled after the Linux Kernel interval_tree_generic.h.
+ * @see https://en.wikipedia.org/wiki/Interval_tree#Augmented_tree
+ */
+
+#include "rbtree_interval.h"
+
+/**
+ * @defgroup rb_interval_augment Subtree maximum endpoint maintenance.
+ * @{
+ */
+
+/**
+ * @brief Largest 'last' under a node, from its own interval and its children's subtrees.
+ */
+static inline uint64_t __rb_interval_compute(const rb_interval_node_t *node) {
+	uint64_t max = node->last;
+
+	if (rb_left(&node->node) && rb_interval_entry(rb_left(&node->node))->__subtree_last > max) {
+		max = rb_interval_entry(rb_left(&node->node))->__subtree_last;
+	}
+
+	if (rb_right(&node->node) && rb_interval_entry(rb_right(&node->node))->__subtree_last > max) {
+		max = rb_interval_entry(rb_right(&node->node))->__subtree_last;
+	}
+
+	return max;
+}
+
+RB_DECLARE_AUGMENT(static, __rb_interval_augment, rb_interval_node_t, node, __subtree_last, __rb_interval_compute)
+
+/** @} */
+
+/**
+ * @defgroup rb_interval_search Overlap search helpers.
+ * @{
+ */
+
+/**
+ * @brief Finds the leftmost interval under node overlapping [start, last].
+ * @details Every interval in a subtree whose __subtree_last is below start ends too early, and every interval
+ * to the right of a node starting after last begins too late, so both get skipped without being visited.
+ */
+static rb_interval_node_t *__rb_interval_subtree_search(rb_interval_node_t *node, uint64_t start, uint64_t last) {
+	while (true) {
+
+		/* anything overlapping on the left comes first in start order, so look there before anywhere else */
+		if (rb_left(&node->node)) {
+			rb_interval_node_t *left = rb_interval_entry(rb_left(&node->node));
+
+			if (start <= left->__subtree_last) {
+				node = left;
+				continue;
+			}
+		}
+
+		/* nothing on the left, so it's this node or something to its right, provided this node doesn't start too late */
+		if (node->start <= last) {
+			if (start <= node->last) return node;
+
+			if (rb_right(&node->node)) {
+				node = rb_interval_entry(rb_right(&node->node));
+				if (start <= node->__subtree_last) continue;
+			}
+		}
+
+		return NULL;
+	}
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_interval_api Interval tree API.
+ * @{
+ */
+
+/**
+ * @fn rb_interval_insert
+ * @brief Inserts an interval node into an interval tree. Its start and last must be set beforehand.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_interval_node_t nodes.
+ * @param[in] node Pointer to an rb_interval_node instance embedded in something else.
+ */
+void rb_interval_insert(rb_tree_t *tree, rb_interval_node_t *node) {
+	rb_node_t **link = &rb_root(tree);
+	rb_node_t *parent = NULL;
+
+	/* every subtree on the way down is about to hold this interval, so raise their maximums as we pass */
+	while (*link) {
+		rb_interval_node_t *cursor = rb_interval_entry(*link);
+
+		parent = *link;
+		if (cursor->__subtree_last < node->last) cursor->__subtree_last = node->last;
+
+		/* equal starts go to the right, same as rb_tree_insert */
+		link = (node->start < cursor->start) ? &rb_left(parent) : &rb_right(parent);
+	}
+
+	rb_link_node(&node->node, parent, link);
+	rb_insert_augmented(tree, &node->node, &__rb_interval_augment);
+}
+
+/**
+ * @fn rb_interval_delete
+ * @brief Deletes an interval node from an interval tree.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_interval_node_t nodes.
+ * @param[in] node Node in the tree.
+ */
+void rb_interval_delete(rb_tree_t *tree, rb_interval_node_t *node) {
+	rb_tree_augmented_delete_at(tree, &node->node, &__rb_interval_augment);
+}
+
+/**
+ * @fn rb_interval_first
+ * @brief Returns the interval with the smallest start that overlaps [start, last], or NULL if none does.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_interval_node_t nodes.
+ * @param[in] start First point of the query, inclusive.
+ * @param[in] last Last point of the query, inclusive.
+ */
+rb_interval_node_t *rb_interval_first(const rb_tree_t *tree, uint64_t start, uint64_t last) {
+	rb_interval_node_t *root;
+
+	if (rb_is_empty(tree)) return NULL;
+
+	/* the root's maximum covers the whole tree */
+	root = rb_interval_entry(rb_root(tree));
+	if (root->__subtree_last < start) return NULL;
+
+	return __rb_interval_subtree_search(root, start, last);
+}
+
+/**
+ * @fn rb_interval_next
+ * @brief Returns the next interval, in start order, that overlaps [start, last], or NULL if there are no more.
+ * @param[in] node An overlapping interval returned by rb_interval_first or rb_interval_next for the same query.
+ * @param[in] start First point of the query, inclusive.
+ * @param[in] last Last point of the query, inclusive.
+ */
+rb_interval_node_t *rb_interval_next(const rb_interval_node_t *node, uint64_t start, uint64_t last) {
+	rb_node_t *rb = rb_right(&node->node);
+	const rb_node_t *prev;
+
+	while (true) {
+
+		/* node starts no later than last, so its right subtree is the next place anything can overlap */
+		if (rb) {
+			rb_interval_node_t *right = rb_interval_entry(rb);
+			if (start <= right->__subtree_last) return __rb_interval_subtree_search(right, start, last);
+		}
+
+		/* climb until we come up from a left child; that parent is the next interval in start order */
+		do {
+			rb = rb_parent(&node->node);
+			if (!rb) return NULL;
+
+			prev = &node->node;
+			node = rb_interval_entry(rb);
+			rb = rb_right(rb);
+		} while (prev == rb);
+
+		/* it and everything after it start too late */
+		if (last < node->start) return NULL;
+		if (start <= node->last) return (rb_interval_node_t *) node;
+	}
+}
+
+/**
+ * @fn rb_interval_stab
+ * @brief Returns the interval with the smallest start that contains point, or NULL if none does.
+ * @details Iterate over the rest with rb_interval_next(node, point, point).
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_interval_node_t nodes.
+ * @param[in] point Point to look up.
+ */
+rb_interval_node_t *rb_interval_stab(const rb_tree_t *tree, uint64_t point) {
+	return rb_interval_first(tree, point, point);
+}
+
+/** @} */
@@ -0,0 +1,104 @@
+/**
+ * @file rbtree_interval.h
+ * @author krad2
+ * @brief An interval tree built on the augmented red-black tree.
+ * @details Nodes hold closed intervals [start, last] ordered by start, and each node also keeps the largest
+ * 'last' found anywhere in its subtree. That lets stab and overlap queries skip every subtree that ends before
+ * the query begins, so they run in O(log n + k) for k hits instead of scanning the whole tree.
+ */
+
+#ifndef RBTREE_INTERVAL_H_
+#define RBTREE_INTERVAL_H_
+
+#include "rbtree_augmented.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct rb_interval_node
+ * @brief An rb_node_t holding the closed interval [start, last].
+ * @var rb_interval_node::node
+ * Tree linkage.
+ * @var rb_interval_node::start
+ * First point of the interval. The tree is ordered by it.
+ * @var rb_interval_node::last
+ * Last point of the interval, inclusive.
+ * @var rb_interval_node::__subtree_last
+ * Largest 'last' in the subtree rooted here. Maintained by the tree, don't touch.
+ */
+typedef struct rb_interval_node {
+	rb_node_t node;
+	uint64_t start;
+	uint64_t last;
+	uint64_t __subtree_last;
+} rb_interval_node_t;
+
+/**
+ * @defgroup rb_interval_macros Interval tree macros.
+ * @{
+ */
+
+/**
+ * Returns the containing rb_interval_node_t of a node in an interval tree.
+ */
+#define rb_interval_entry(rb)								container_of(rb, rb_interval_node_t, node)
+
+/** @} */
+
+/**
+ * @defgroup rb_interval_api Interval tree API.
+ * @{
+ */
+
+/**
+ * @fn rb_interval_insert
+ * @brief Inserts an interval node into an interval tree. Its start and last must be set beforehand.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_interval_node_t nodes.
+ * @param[in] node Pointer to an rb_interval_node instance embedded in something else.
+ */
+void rb_interval_insert(rb_tree_t *tree, rb_interval_node_t *node);
+
+/**
+ * @fn rb_interval_delete
+ * @brief Deletes an interval node from an interval tree.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_interval_node_t nodes.
+ * @param[in] node Node in the tree.
+ */
+void rb_interval_delete(rb_tree_t *tree, rb_interval_node_t *node);
+
+/**
+ * @fn rb_interval_first
+ * @brief Returns the interval with the smallest start that overlaps [start, last], or NULL if none does.
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_interval_node_t nodes.
+ * @param[in] start First point of the query, inclusive.
+ * @param[in] last Last point of the query, inclusive.
+ */
+rb_interval_node_t *rb_interval_first(const rb_tree_t *tree, uint64_t start, uint64_t last);
+
+/**
+ * @fn rb_interval_next
+ * @brief Returns the next interval, in start order, that overlaps [start, last], or NULL if there are no more.
+ * @param[in] node An overlapping interval returned by rb_interval_first or rb_interval_next for the same query.
+ * @param[in] start First point of the query, inclusive.
+ * @param[in] last Last point of the query, inclusive.
+ */
+rb_interval_node_t *rb_interval_next(const rb_interval_node_t *node, uint64_t start, uint64_t last);
+
+/**
+ * @fn rb_interval_stab
+ * @brief Returns the interval with the smallest start that contains point, or NULL if none does.
+ * @details Iterate over the rest with rb_interval_next(node, point, point).
+ * @param[in] tree Pointer to an rb_tree instance made up of rb_interval_node_t nodes.
+ * @param[in] point Point to look up.
+ */
+rb_interval_node_t *rb_interval_stab(const rb_tree_t *tree, uint64_t point);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RBTREE_INTERVAL_H_ */
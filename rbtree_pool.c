@@ -0,0 +1,413 @@
+/**
+ * @file rbtree_pool.c
+ * @author krad2
+ * @brief A slab allocator for objects with an embedded rb_node_t, with a pass that lays a tree out in address order.
+ */
+
+#include "rbtree_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
+/**
+ * @struct rb_pool_slab
+ * @brief Header at the start of every slab; objects follow it.
+ * @var rb_pool_slab::next
+ * Next older slab.
+ * @var rb_pool_slab::bytes
+ * Length of the whole slab, header included.
+ */
+struct rb_pool_slab {
+	struct rb_pool_slab *next;
+	size_t bytes;
+};
+
+/**
+ * @defgroup rb_pool_slabs Slab management.
+ * @{
+ */
+
+/** Alignment every object is kept at. */
+#define RB_POOL_ALIGN										(_Alignof(max_align_t))
+
+/** Rounds n up to a multiple of the power of two a. */
+#define __rb_pool_round(n, a)								(((n) + (a) - 1) & ~((size_t) (a) - 1))
+
+/** Offset of the first object in a slab. */
+#define __rb_pool_header									__rb_pool_round(sizeof(struct rb_pool_slab), RB_POOL_ALIGN)
+
+/**
+ * @brief Maps a slab of at least 'bytes' bytes, on huge pages if the OS has them to give.
+ * @details Explicit huge pages only exist if the administrator reserved some, so failing to get them is normal;
+ * the fallback asks for transparent huge pages instead, which the kernel hands out when it can.
+ */
+static struct rb_pool_slab *__rb_pool_map(size_t bytes) {
+	struct rb_pool_slab *slab;
+
+#if defined(__unix__) || defined(__APPLE__)
+	void *memory = MAP_FAILED;
+
+#if defined(MAP_HUGETLB)
+	if (bytes % RB_POOL_SLAB_BYTES == 0) {
+		memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	}
+#endif
+
+	if (memory == MAP_FAILED) {
+		memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (memory == MAP_FAILED) return NULL;
+
+#if defined(MADV_HUGEPAGE)
+		if (bytes >= RB_POOL_SLAB_BYTES) madvise(memory, bytes, MADV_HUGEPAGE);
+#endif
+	}
+
+	slab = memory;
+#else
+	slab = malloc(bytes);
+	if (!slab) return NULL;
+#endif
+
+	slab->next = NULL;
+	slab->bytes = bytes;
+	return slab;
+}
+
+/**
+ * @brief Gives a slab back to the OS.
+ */
+static void __rb_pool_unmap(struct rb_pool_slab *slab) {
+#if defined(__unix__) || defined(__APPLE__)
+	munmap(slab, slab->bytes);
+#else
+	free(slab);
+#endif
+}
+
+/**
+ * @brief Maps a slab holding at least n objects and makes it the pool's newest, to be carved up from its start.
+ */
+static bool __rb_pool_grow(rb_pool_t *pool, size_t n) {
+	size_t bytes = __rb_pool_header + n * pool->size;
+	struct rb_pool_slab *slab;
+
+	/* whole slabs only, so every mapping can be backed by the same huge pages */
+	bytes = ((bytes + pool->slab_bytes - 1) / pool->slab_bytes) * pool->slab_bytes;
+
+	slab = __rb_pool_map(bytes);
+	if (!slab) return false;
+
+	slab->next = pool->slabs;
+	pool->slabs = slab;
+	pool->cursor = (char *) slab + __rb_pool_header;
+	pool->end = (char *) slab + bytes;
+
+	return true;
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_pool_compaction Compaction helpers.
+ * @{
+ */
+
+/**
+ * @brief Where a node already copied during compaction went.
+ * @details The old node's parent link is the one thing compaction doesn't need from it anymore, since the copy kept
+ * its own, so that's where the new address is left.
+ */
+static inline rb_node_t *__rb_pool_forward(const rb_node_t *old) {
+	return old ? (rb_node_t *) old->__rb_parent_color : NULL;
+}
+
+/**
+ * @brief Copies an object into the next slot, notes where it went in its old node, and returns the new node.
+ */
+static inline rb_node_t *__rb_pool_move(rb_pool_t *pool, rb_node_t *old, char **slot, void (*moved)(void *from, void *to, void *ctx), void *ctx) {
+	void *from = rb_pool_object(pool, old), *to = *slot;
+	rb_node_t *nw = rb_pool_node(pool, to);
+
+	memcpy(to, from, pool->size);
+	if (moved) moved(from, to, ctx);
+
+	old->__rb_parent_color = (uintptr_t) nw;
+	*slot += pool->size;
+
+	return nw;
+}
+
+/**
+ * @brief Copies every node under root into consecutive slots from first on, in the given order.
+ * @details In-order runs on an explicit stack, reading the old links. Breadth-first needs no stack at all: the
+ * copies themselves are the queue, since each one still holds its old children's addresses until the fixup.
+ * @return One past the last slot used.
+ */
+static char *__rb_pool_copy(rb_pool_t *pool, rb_node_t *root, rb_pool_order_t order, char *first, void (*moved)(void *from, void *to, void *ctx), void *ctx) {
+	char *slot = first, *head;
+
+	if (order == rb_pool_breadth_first) {
+		if (root) __rb_pool_move(pool, root, &slot, moved, ctx);
+
+		for (head = first; head < slot; head += pool->size) {
+			rb_node_t *node = rb_pool_node(pool, head);
+
+			if (rb_left(node)) __rb_pool_move(pool, rb_left(node), &slot, moved, ctx);
+			if (rb_right(node)) __rb_pool_move(pool, rb_right(node), &slot, moved, ctx);
+		}
+	} else {
+		rb_node_t *stack[RB_WALK_STACK], *cursor = root, *node;
+		size_t top = 0;
+
+		for (;;) {
+			while (cursor) {
+				stack[top++] = cursor;
+				cursor = rb_left(cursor);
+			}
+
+			if (top == 0) break;
+			node = stack[--top];
+
+			/* the old node's right link is still intact; only its parent link gets overwritten */
+			cursor = rb_right(node);
+			__rb_pool_move(pool, node, &slot, moved, ctx);
+		}
+	}
+
+	return slot;
+}
+
+/**
+ * @brief Counts the nodes under root by walking its links, the same way __rb_pool_copy will.
+ * @details The pool's own count can't be trusted to size the new slab: the tree may hold objects from elsewhere.
+ */
+static size_t __rb_pool_count(const rb_node_t *root) {
+	const rb_node_t *stack[RB_WALK_STACK], *cursor = root;
+	size_t top = 0, n = 0;
+
+	for (;;) {
+		while (cursor) {
+			stack[top++] = cursor;
+			cursor = rb_left(cursor);
+		}
+
+		if (top == 0) break;
+		cursor = rb_right(stack[--top]);
+		n++;
+	}
+
+	return n;
+}
+
+/**
+ * @brief Points every copied node's links at the other copies.
+ */
+static void __rb_pool_relink(rb_pool_t *pool, char *first, char *last) {
+	for (char *slot = first; slot < last; slot += pool->size) {
+		rb_node_t *node = rb_pool_node(pool, slot);
+
+		rb_left(node) = __rb_pool_forward(rb_left(node));
+		rb_right(node) = __rb_pool_forward(rb_right(node));
+		node->__rb_parent_color = rb_color(node) | (uintptr_t) __rb_pool_forward(rb_parent(node));
+	}
+}
+
+/**
+ * @brief Moves a tree into a fresh slab and repoints its root. The old slabs stay mapped until __rb_pool_release.
+ * @return The old slabs, or NULL with nothing moved if the new slab couldn't be mapped.
+ */
+static struct rb_pool_slab *__rb_pool_relocate(rb_pool_t *pool, rb_tree_t *tree, rb_pool_order_t order, void (*moved)(void *from, void *to, void *ctx), void *ctx, bool *ok) {
+	struct rb_pool_slab *old = pool->slabs;
+	size_t n = __rb_pool_count(rb_root(tree));
+	char *first, *last;
+
+	/* size the slab by the tree itself; nothing is copied past what this walk saw */
+	pool->slabs = NULL;
+	if (!__rb_pool_grow(pool, n ? n : 1)) {
+		pool->slabs = old;
+		*ok = false;
+		return NULL;
+	}
+
+	first = pool->cursor;
+	last = __rb_pool_copy(pool, rb_root(tree), order, first, moved, ctx);
+	__rb_pool_relink(pool, first, last);
+
+	rb_root(tree) = __rb_pool_forward(rb_root(tree));
+
+	/* the leftovers of the new slab serve the next allocations, and the old free objects are gone with their slabs */
+	pool->cursor = last;
+	pool->free = NULL;
+	pool->live = n;
+
+	*ok = true;
+	return old;
+}
+
+/**
+ * @brief Unmaps a chain of slabs left behind by __rb_pool_relocate.
+ */
+static void __rb_pool_release(struct rb_pool_slab *slab) {
+	while (slab) {
+		struct rb_pool_slab *next = slab->next;
+
+		__rb_pool_unmap(slab);
+		slab = next;
+	}
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_pool_api Pool API.
+ * @{
+ */
+
+/**
+ * @fn rb_pool_init
+ * @brief Sets up an empty pool. No memory is taken until the first allocation.
+ * @param[in] pool Pointer to an rb_pool instance.
+ * @param[in] size Size of each object, e.g. sizeof(struct a).
+ * @param[in] offset Offset of the rb_node_t within each object, e.g. offsetof(struct a, node).
+ * @param[in] slab_bytes Bytes to request from the OS at a time, or 0 for RB_POOL_SLAB_BYTES. Multiples of
+ * RB_POOL_SLAB_BYTES can be backed by huge pages.
+ * @return False if an object can't hold its node at that offset.
+ */
+bool rb_pool_init(rb_pool_t *pool, size_t size, size_t offset, size_t slab_bytes) {
+	if (offset + sizeof(rb_node_t) > size) return false;
+
+	pool->size = __rb_pool_round(size, RB_POOL_ALIGN);
+	pool->offset = offset;
+	pool->slab_bytes = slab_bytes ? slab_bytes : RB_POOL_SLAB_BYTES;
+	pool->slabs = NULL;
+	pool->cursor = pool->end = NULL;
+	pool->free = NULL;
+	pool->live = 0;
+
+	return true;
+}
+
+/**
+ * @fn rb_pool_destroy
+ * @brief Returns every slab to the OS. Every object from the pool is gone afterwards, live or not.
+ * @param[in] pool Pointer to an rb_pool instance.
+ */
+void rb_pool_destroy(rb_pool_t *pool) {
+	__rb_pool_release(pool->slabs);
+
+	pool->slabs = NULL;
+	pool->cursor = pool->end = NULL;
+	pool->free = NULL;
+	pool->live = 0;
+}
+
+/**
+ * @fn rb_pool_alloc
+ * @brief Hands out an object in O(1), reusing the most recently freed one if there is one.
+ * @param[in] pool Pointer to an rb_pool instance.
+ * @return An uninitialized object, or NULL if the OS is out of memory.
+ */
+void *rb_pool_alloc(rb_pool_t *pool) {
+	void *obj;
+
+	/* the most recently freed object is the likeliest to still be in cache */
+	if (pool->free) {
+		obj = pool->free;
+		pool->free = *(void **) obj;
+	} else {
+		if (pool->end - pool->cursor < (ptrdiff_t) pool->size && !__rb_pool_grow(pool, 1)) return NULL;
+
+		obj = pool->cursor;
+		pool->cursor += pool->size;
+	}
+
+	pool->live++;
+	return obj;
+}
+
+/**
+ * @fn rb_pool_free
+ * @brief Takes an object back in O(1). It must not be in any tree.
+ * @param[in] pool Pointer to the rb_pool instance the object came from.
+ * @param[in] obj Object to free, or NULL.
+ */
+void rb_pool_free(rb_pool_t *pool, void *obj) {
+	if (!obj) return;
+
+	*(void **) obj = pool->free;
+	pool->free = obj;
+	pool->live--;
+}
+
+/**
+ * @fn rb_pool_compact
+ * @brief Moves every node of a tree into one fresh slab, in the given address order, and frees the old slabs.
+ * @details Every live object in the pool must be in the tree, since the old slabs are unmapped once their contents
+ * have moved. Objects are copied byte for byte, so anything outside the tree pointing into them, including other
+ * trees they're linked into, has to be repointed through the moved callback. The new slab is sized by walking the
+ * tree, and afterwards the pool counts exactly the tree's objects as live. O(n), with no comparisons.
+ * @param[in] pool Pointer to the rb_pool instance the tree's objects came from.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] order rb_pool_inorder to speed up scans, rb_pool_breadth_first to speed up lookups.
+ * @param[in] moved Callback told about each object's old and new address while both are still valid, or NULL.
+ * @param[in] ctx Passed through to moved.
+ * @return False if there wasn't memory for the new slab, in which case nothing was moved.
+ */
+bool rb_pool_compact(rb_pool_t *pool, rb_tree_t *tree, rb_pool_order_t order, void (*moved)(void *from, void *to, void *ctx), void *ctx) {
+	bool ok;
+
+	__rb_pool_release(__rb_pool_relocate(pool, tree, order, moved, ctx, &ok));
+	return ok;
+}
+
+/**
+ * @fn rb_pool_lcached_compact
+ * @brief Same as rb_pool_compact, keeping the cached min pointing at the moved node.
+ */
+bool rb_pool_lcached_compact(rb_pool_t *pool, rb_tree_lcached_t *tree, rb_pool_order_t order, void (*moved)(void *from, void *to, void *ctx), void *ctx) {
+	bool ok;
+	struct rb_pool_slab *old = __rb_pool_relocate(pool, (rb_tree_t *) tree, order, moved, ctx, &ok);
+
+	/* the old min still knows where it went until its slab is unmapped */
+	if (ok) rb_min(tree) = __rb_pool_forward(rb_min(tree));
+
+	__rb_pool_release(old);
+	return ok;
+}
+
+/**
+ * @fn rb_pool_rcached_compact
+ * @brief Same as rb_pool_compact, keeping the cached max pointing at the moved node.
+ */
+bool rb_pool_rcached_compact(rb_pool_t *pool, rb_tree_rcached_t *tree, rb_pool_order_t order, void (*moved)(void *from, void *to, void *ctx), void *ctx) {
+	bool ok;
+	struct rb_pool_slab *old = __rb_pool_relocate(pool, (rb_tree_t *) tree, order, moved, ctx, &ok);
+
+	if (ok) rb_max(tree) = __rb_pool_forward(rb_max(tree));
+
+	__rb_pool_release(old);
+	return ok;
+}
+
+/**
+ * @fn rb_pool_lrcached_compact
+ * @brief Same as rb_pool_compact, keeping the cached min and max pointing at the moved nodes.
+ */
+bool rb_pool_lrcached_compact(rb_pool_t *pool, rb_tree_lrcached_t *tree, rb_pool_order_t order, void (*moved)(void *from, void *to, void *ctx), void *ctx) {
+	bool ok;
+	struct rb_pool_slab *old = __rb_pool_relocate(pool, (rb_tree_t *) tree, order, moved, ctx, &ok);
+
+	if (ok) {
+		rb_min(tree) = __rb_pool_forward(rb_min(tree));
+		rb_max(tree) = __rb_pool_forward(rb_max(tree));
+	}
+
+	__rb_pool_release(old);
+	return ok;
+}
+
+/** @} */
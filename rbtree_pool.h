@@ -0,0 +1,163 @@
+/**
+ * @file rbtree_pool.h
+ * @author krad2
+ * @brief A slab allocator for objects with an embedded rb_node_t, with a pass that lays a tree out in address order.
+ * @details Objects handed out one malloc at a time end up scattered across the heap, so every step of a lookup or an
+ * in-order scan is likely to miss cache. A pool carves same-sized objects out of large slabs instead, backed by huge
+ * pages where the OS allows it, and recycles freed ones through an O(1) free list. rb_pool_compact goes further and
+ * moves every node of a tree into one fresh slab, either in in-order sequence for scans or in breadth-first sequence
+ * for lookups, patching up the links as it goes.
+ */
+
+#ifndef RBTREE_POOL_H_
+#define RBTREE_POOL_H_
+
+#include "rbtree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @enum rb_pool_order
+ * @brief Address order rb_pool_compact lays nodes out in.
+ */
+typedef enum rb_pool_order {
+	rb_pool_inorder = 0,
+	rb_pool_breadth_first = 1
+} rb_pool_order_t;
+
+/**
+ * @struct rb_pool
+ * @brief A pool of same-sized objects, each with an rb_node_t at the same offset.
+ * @var rb_pool::size
+ * Bytes per object, rounded up to keep every object aligned.
+ * @var rb_pool::offset
+ * Offset of the rb_node_t within each object.
+ * @var rb_pool::slab_bytes
+ * Bytes requested from the OS per slab.
+ * @var rb_pool::slabs
+ * Every slab the pool owns, newest first.
+ * @var rb_pool::cursor
+ * Next never-used object in the newest slab.
+ * @var rb_pool::end
+ * End of the newest slab.
+ * @var rb_pool::free
+ * Freed objects, linked through their first bytes.
+ * @var rb_pool::live
+ * Number of objects handed out and not yet freed.
+ */
+typedef struct rb_pool {
+	size_t size;
+	size_t offset;
+	size_t slab_bytes;
+	struct rb_pool_slab *slabs;
+	char *cursor;
+	char *end;
+	void *free;
+	size_t live;
+} rb_pool_t;
+
+/**
+ * @defgroup rb_pool_macros Pool macros.
+ * @{
+ */
+
+/**
+ * Slab size used when rb_pool_init is passed 0: one huge page on x86-64 and arm64.
+ */
+#define RB_POOL_SLAB_BYTES									((size_t) 2 << 20)
+
+/**
+ * Returns the rb_node_t embedded in an object from a pool.
+ */
+#define rb_pool_node(pool, obj)								((rb_node_t *) ((char *) (obj) + (pool)->offset))
+
+/**
+ * Returns the object from a pool that an rb_node_t is embedded in.
+ */
+#define rb_pool_object(pool, rb)							((void *) ((char *) (rb) - (pool)->offset))
+
+/** @} */
+
+/**
+ * @defgroup rb_pool_api Pool API.
+ * @{
+ */
+
+/**
+ * @fn rb_pool_init
+ * @brief Sets up an empty pool. No memory is taken until the first allocation.
+ * @param[in] pool Pointer to an rb_pool instance.
+ * @param[in] size Size of each object, e.g. sizeof(struct a).
+ * @param[in] offset Offset of the rb_node_t within each object, e.g. offsetof(struct a, node).
+ * @param[in] slab_bytes Bytes to request from the OS at a time, or 0 for RB_POOL_SLAB_BYTES. Multiples of
+ * RB_POOL_SLAB_BYTES can be backed by huge pages.
+ * @return False if an object can't hold its node at that offset.
+ */
+bool rb_pool_init(rb_pool_t *pool, size_t size, size_t offset, size_t slab_bytes);
+
+/**
+ * @fn rb_pool_destroy
+ * @brief Returns every slab to the OS. Every object from the pool is gone afterwards, live or not.
+ * @param[in] pool Pointer to an rb_pool instance.
+ */
+void rb_pool_destroy(rb_pool_t *pool);
+
+/**
+ * @fn rb_pool_alloc
+ * @brief Hands out an object in O(1), reusing the most recently freed one if there is one.
+ * @param[in] pool Pointer to an rb_pool instance.
+ * @return An uninitialized object, or NULL if the OS is out of memory.
+ */
+void *rb_pool_alloc(rb_pool_t *pool);
+
+/**
+ * @fn rb_pool_free
+ * @brief Takes an object back in O(1). It must not be in any tree.
+ * @param[in] pool Pointer to the rb_pool instance the object came from.
+ * @param[in] obj Object to free, or NULL.
+ */
+void rb_pool_free(rb_pool_t *pool, void *obj);
+
+/**
+ * @fn rb_pool_compact
+ * @brief Moves every node of a tree into one fresh slab, in the given address order, and frees the old slabs.
+ * @details Every live object in the pool must be in the tree, since the old slabs are unmapped once their contents
+ * have moved. Objects are copied byte for byte, so anything outside the tree pointing into them, including other
+ * trees they're linked into, has to be repointed through the moved callback. The new slab is sized by walking the
+ * tree, and afterwards the pool counts exactly the tree's objects as live. O(n), with no comparisons.
+ * @param[in] pool Pointer to the rb_pool instance the tree's objects came from.
+ * @param[in] tree Pointer to an rb_tree instance.
+ * @param[in] order rb_pool_inorder to speed up scans, rb_pool_breadth_first to speed up lookups.
+ * @param[in] moved Callback told about each object's old and new address while both are still valid, or NULL.
+ * @param[in] ctx Passed through to moved.
+ * @return False if there wasn't memory for the new slab, in which case nothing was moved.
+ */
+bool rb_pool_compact(rb_pool_t *pool, rb_tree_t *tree, rb_pool_order_t order, void (*moved)(void *from, void *to, void *ctx), void *ctx);
+
+/**
+ * @fn rb_pool_lcached_compact
+ * @brief Same as rb_pool_compact, keeping the cached min pointing at the moved node.
+ */
+bool rb_pool_lcached_compact(rb_pool_t *pool, rb_tree_lcached_t *tree, rb_pool_order_t order, void (*moved)(void *from, void *to, void *ctx), void *ctx);
+
+/**
+ * @fn rb_pool_rcached_compact
+ * @brief Same as rb_pool_compact, keeping the cached max pointing at the moved node.
+ */
+bool rb_pool_rcached_compact(rb_pool_t *pool, rb_tree_rcached_t *tree, rb_pool_order_t order, void (*moved)(void *from, void *to, void *ctx), void *ctx);
+
+/**
+ * @fn rb_pool_lrcached_compact
+ * @brief Same as rb_pool_compact, keeping the cached min and max pointing at the moved nodes.
+ */
+bool rb_pool_lrcached_compact(rb_pool_t *pool, rb_tree_lrcached_t *tree, rb_pool_order_t order, void (*moved)(void *from, void *to, void *ctx), void *ctx);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RBTREE_POOL_H_ */
@@ -0,0 +1,218 @@
+/**
+ * @file rbtree_prefix.c
+ * @author krad2
+ * @brief A node that carries a 64-bit prefix of its key, so descents can mostly compare without leaving the node.
+ */
+
+#include "rbtree_prefix.h"
+
+/**
+ * @defgroup rb_prefix_helpers Prefix tree helpers.
+ * @{
+ */
+
+/**
+ * @brief Compares key against a tree node by prefix, falling back to the full comparator on a tie.
+ */
+static inline int __rb_prefix_cmp(const rb_prefix_node_t *key, const rb_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	uint64_t prefix = rb_prefix_entry(node)->prefix;
+
+	/* the prefix sits next to the links, so this usually settles it without touching the rest of the object */
+	if (key->prefix != prefix) return (key->prefix < prefix) ? -1 : 1;
+	return cmp ? cmp(&key->node, node) : 0;
+}
+
+/**
+ * @brief Descends to where node goes and links it in, like __rb_insert_unique.
+ * @param[in] unique Stop at a node with an equal key instead of going past it to the right.
+ * @param[out] leftmost Set if node went in as the new minimum, i.e. the descent never turned right.
+ * @param[out] rightmost Set if node went in as the new maximum, i.e. the descent never turned left.
+ * @return The node with an equal key if unique and there is one, else NULL once node is in.
+ */
+static inline rb_node_t *__rb_prefix_insert(rb_tree_t *tree, rb_prefix_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), bool unique, bool *leftmost, bool *rightmost) {
+	rb_node_t **link = &rb_root(tree);
+	rb_node_t *parent = NULL;
+
+	*leftmost = true;
+	*rightmost = true;
+
+	while (*link) {
+		int comparison = __rb_prefix_cmp(node, *link, cmp);
+
+		parent = *link;
+		if (comparison < 0) {
+			link = &rb_left(parent);
+			*rightmost = false;
+		} else if (comparison > 0 || !unique) {
+			link = &rb_right(parent);
+			*leftmost = false;
+		} else return parent;
+	}
+
+	/* the slot the descent fell out of is exactly where the node goes */
+	rb_link_node(&node->node, parent, link);
+	rb_insert_color(tree, &node->node);
+	return NULL;
+}
+
+/**
+ * @brief Shared descent of rb_prefix_lower_bound and rb_prefix_upper_bound. Equal nodes go left unless strict.
+ */
+static inline rb_node_t *__rb_prefix_bound(const rb_tree_t *tree, const rb_prefix_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right), bool strict) {
+	rb_node_t *cursor = rb_root(tree), *bound = NULL;
+
+	while (cursor) {
+		int comparison = __rb_prefix_cmp(key, cursor, cmp);
+
+		if (comparison < 0 || (comparison == 0 && !strict)) {
+			bound = cursor;
+			cursor = rb_left(cursor);
+		} else {
+			cursor = rb_right(cursor);
+		}
+	}
+
+	return bound;
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_prefix_api Prefix tree API.
+ * @{
+ */
+
+/**
+ * @fn rb_prefix_of_bytes
+ * @brief Prefix of a byte-string key ordered like memcmp: its first 8 bytes, big-endian, zero-padded.
+ * @param[in] bytes Key bytes.
+ * @param[in] len Length of the key.
+ */
+uint64_t rb_prefix_of_bytes(const void *bytes, size_t len) {
+	const unsigned char *byte = bytes;
+	uint64_t prefix = 0;
+
+	/* the first byte lands on top, so integer order is byte order */
+	for (size_t i = 0; i < sizeof(prefix); i++) prefix = (prefix << 8) | (i < len ? byte[i] : 0);
+	return prefix;
+}
+
+/**
+ * @fn rb_prefix_of_string
+ * @brief Prefix of a NUL-terminated key ordered like strcmp. Never reads past the terminator.
+ * @param[in] str Key string.
+ */
+uint64_t rb_prefix_of_string(const char *str) {
+	size_t len = 0;
+
+	while (len < sizeof(uint64_t) && str[len]) len++;
+	return rb_prefix_of_bytes(str, len);
+}
+
+/**
+ * @fn rb_prefix_tree_insert
+ * @brief Inserts a node, comparing prefixes first. Equal keys go after the ones already there, same as rb_tree_insert.
+ * @param[in] tree Pointer to an rb_tree instance holding only prefix nodes.
+ * @param[in] node Pointer to an rb_prefix_node instance with its prefix set.
+ * @param[in] cmp Comparator for the full keys, called only on a prefix tie, or NULL if the prefix is the whole key.
+ */
+void rb_prefix_tree_insert(rb_tree_t *tree, rb_prefix_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	bool leftmost, rightmost;
+
+	__rb_prefix_insert(tree, node, cmp, false, &leftmost, &rightmost);
+}
+
+/**
+ * @fn rb_prefix_tree_lcached_insert
+ * @brief Same as rb_prefix_tree_insert, keeping the cached min current.
+ */
+void rb_prefix_tree_lcached_insert(rb_tree_lcached_t *tree, rb_prefix_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	bool leftmost, rightmost;
+
+	__rb_prefix_insert((rb_tree_t *) tree, node, cmp, false, &leftmost, &rightmost);
+	if (leftmost) rb_min(tree) = &node->node;
+}
+
+/**
+ * @fn rb_prefix_tree_rcached_insert
+ * @brief Same as rb_prefix_tree_insert, keeping the cached max current.
+ */
+void rb_prefix_tree_rcached_insert(rb_tree_rcached_t *tree, rb_prefix_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	bool leftmost, rightmost;
+
+	__rb_prefix_insert((rb_tree_t *) tree, node, cmp, false, &leftmost, &rightmost);
+	if (rightmost) rb_max(tree) = &node->node;
+}
+
+/**
+ * @fn rb_prefix_tree_lrcached_insert
+ * @brief Same as rb_prefix_tree_insert, keeping the cached min and max current.
+ */
+void rb_prefix_tree_lrcached_insert(rb_tree_lrcached_t *tree, rb_prefix_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	bool leftmost, rightmost;
+
+	__rb_prefix_insert((rb_tree_t *) tree, node, cmp, false, &leftmost, &rightmost);
+	if (leftmost) rb_min(tree) = &node->node;
+	if (rightmost) rb_max(tree) = &node->node;
+}
+
+/**
+ * @fn rb_prefix_tree_insert_unique
+ * @brief Inserts a node unless one with an equal key is already there, in a single descent.
+ * @param[in] tree Pointer to an rb_tree instance holding only prefix nodes.
+ * @param[in] node Pointer to an rb_prefix_node instance with its prefix set.
+ * @param[in] cmp Comparator for the full keys, called only on a prefix tie, or NULL if the prefix is the whole key.
+ * @param[out] existing If not NULL, set to the node that blocked the insert, or NULL if node went in.
+ * @return True if node was inserted, false if an equal key was found instead.
+ */
+bool rb_prefix_tree_insert_unique(rb_tree_t *tree, rb_prefix_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_node_t **existing) {
+	bool leftmost, rightmost;
+	rb_node_t *found = __rb_prefix_insert(tree, node, cmp, true, &leftmost, &rightmost);
+
+	if (existing) *existing = found;
+	return !found;
+}
+
+/**
+ * @fn rb_prefix_find
+ * @brief Binary search to find 'key', comparing prefixes first. Returns NULL if not found.
+ * @param[in] tree Pointer to an rb_tree instance holding only prefix nodes.
+ * @param[in] key Pointer to an rb_prefix_node instance with its prefix set, embedded like the tree's nodes.
+ * @param[in] cmp Comparator for the full keys, called only on a prefix tie, or NULL if the prefix is the whole key.
+ */
+rb_node_t *rb_prefix_find(const rb_tree_t *tree, const rb_prefix_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	rb_node_t *cursor = rb_root(tree);
+
+	while (cursor) {
+		int comparison = __rb_prefix_cmp(key, cursor, cmp);
+
+		if (comparison == 0) break;
+		cursor = (comparison < 0) ? rb_left(cursor) : rb_right(cursor);
+	}
+
+	return cursor;
+}
+
+/**
+ * @fn rb_prefix_lower_bound
+ * @brief Returns the first node that does not compare less than key, or NULL.
+ * @param[in] tree Pointer to an rb_tree instance holding only prefix nodes.
+ * @param[in] key Pointer to an rb_prefix_node instance with its prefix set, embedded like the tree's nodes.
+ * @param[in] cmp Comparator for the full keys, called only on a prefix tie, or NULL if the prefix is the whole key.
+ */
+rb_node_t *rb_prefix_lower_bound(const rb_tree_t *tree, const rb_prefix_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	return __rb_prefix_bound(tree, key, cmp, false);
+}
+
+/**
+ * @fn rb_prefix_upper_bound
+ * @brief Returns the first node that compares greater than key, or NULL.
+ * @param[in] tree Pointer to an rb_tree instance holding only prefix nodes.
+ * @param[in] key Pointer to an rb_prefix_node instance with its prefix set, embedded like the tree's nodes.
+ * @param[in] cmp Comparator for the full keys, called only on a prefix tie, or NULL if the prefix is the whole key.
+ */
+rb_node_t *rb_prefix_upper_bound(const rb_tree_t *tree, const rb_prefix_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right)) {
+	return __rb_prefix_bound(tree, key, cmp, true);
+}
+
+/** @} */
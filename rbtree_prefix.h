@@ -0,0 +1,150 @@
+/**
+ * @file rbtree_prefix.h
+ * @author krad2
+ * @brief A node that carries a 64-bit prefix of its key, so descents can mostly compare without leaving the node.
+ * @details Every comparator call reaches into the containing object, and whatever the key lives in is often a cache
+ * line the node itself isn't on, or behind another pointer entirely. rb_prefix_node_t keeps the first 64 bits of the
+ * key, normalized so that comparing them as integers orders them the same way the comparator would, right next to
+ * the links. The descents below compare prefixes inline and only call the comparator when two prefixes tie. An
+ * integer key fits in its prefix whole, so its tree needs no comparator at all; strings get their first 8 bytes.
+ * The trees themselves are ordinary rb_tree_t, so deleting, iterating and everything else that doesn't compare
+ * keys works on them unchanged.
+ */
+
+#ifndef RBTREE_PREFIX_H_
+#define RBTREE_PREFIX_H_
+
+#include "rbtree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct rb_prefix_node
+ * @brief A tree node with a key prefix, to be embedded in something else.
+ * @var rb_prefix_node::node
+ * Tree linkage.
+ * @var rb_prefix_node::prefix
+ * Normalized first 64 bits of the key. Must be set before the node is inserted or used as a search key, and must
+ * order the same way as the comparator: a smaller prefix means a smaller key.
+ */
+typedef struct rb_prefix_node {
+	rb_node_t node;
+	uint64_t prefix;
+} rb_prefix_node_t;
+
+/**
+ * @defgroup rb_prefix_macros Prefix node macros.
+ * @{
+ */
+
+/**
+ * Returns the containing rb_prefix_node_t of a node in a prefix tree.
+ */
+#define rb_prefix_entry(rb)									container_of(rb, rb_prefix_node_t, node)
+
+/**
+ * Prefix of an unsigned integer key: the key itself.
+ */
+#define rb_prefix_of_uint64(x)								((uint64_t) (x))
+
+/**
+ * Prefix of a signed integer key: flipping the sign bit makes negative numbers sort below positive ones.
+ */
+#define rb_prefix_of_int64(x)								((uint64_t) (int64_t) (x) ^ ((uint64_t) 1 << 63))
+
+/** @} */
+
+/**
+ * @defgroup rb_prefix_api Prefix tree API.
+ * @{
+ */
+
+/**
+ * @fn rb_prefix_of_bytes
+ * @brief Prefix of a byte-string key ordered like memcmp: its first 8 bytes, big-endian, zero-padded.
+ * @param[in] bytes Key bytes.
+ * @param[in] len Length of the key.
+ */
+uint64_t rb_prefix_of_bytes(const void *bytes, size_t len);
+
+/**
+ * @fn rb_prefix_of_string
+ * @brief Prefix of a NUL-terminated key ordered like strcmp. Never reads past the terminator.
+ * @param[in] str Key string.
+ */
+uint64_t rb_prefix_of_string(const char *str);
+
+/**
+ * @fn rb_prefix_tree_insert
+ * @brief Inserts a node, comparing prefixes first. Equal keys go after the ones already there, same as rb_tree_insert.
+ * @param[in] tree Pointer to an rb_tree instance holding only prefix nodes.
+ * @param[in] node Pointer to an rb_prefix_node instance with its prefix set.
+ * @param[in] cmp Comparator for the full keys, called only on a prefix tie, or NULL if the prefix is the whole key.
+ */
+void rb_prefix_tree_insert(rb_tree_t *tree, rb_prefix_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_prefix_tree_lcached_insert
+ * @brief Same as rb_prefix_tree_insert, keeping the cached min current.
+ */
+void rb_prefix_tree_lcached_insert(rb_tree_lcached_t *tree, rb_prefix_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_prefix_tree_rcached_insert
+ * @brief Same as rb_prefix_tree_insert, keeping the cached max current.
+ */
+void rb_prefix_tree_rcached_insert(rb_tree_rcached_t *tree, rb_prefix_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_prefix_tree_lrcached_insert
+ * @brief Same as rb_prefix_tree_insert, keeping the cached min and max current.
+ */
+void rb_prefix_tree_lrcached_insert(rb_tree_lrcached_t *tree, rb_prefix_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_prefix_tree_insert_unique
+ * @brief Inserts a node unless one with an equal key is already there, in a single descent.
+ * @param[in] tree Pointer to an rb_tree instance holding only prefix nodes.
+ * @param[in] node Pointer to an rb_prefix_node instance with its prefix set.
+ * @param[in] cmp Comparator for the full keys, called only on a prefix tie, or NULL if the prefix is the whole key.
+ * @param[out] existing If not NULL, set to the node that blocked the insert, or NULL if node went in.
+ * @return True if node was inserted, false if an equal key was found instead.
+ */
+bool rb_prefix_tree_insert_unique(rb_tree_t *tree, rb_prefix_node_t *node, int (*cmp)(const rb_node_t *left, const rb_node_t *right), rb_node_t **existing);
+
+/**
+ * @fn rb_prefix_find
+ * @brief Binary search to find 'key', comparing prefixes first. Returns NULL if not found.
+ * @param[in] tree Pointer to an rb_tree instance holding only prefix nodes.
+ * @param[in] key Pointer to an rb_prefix_node instance with its prefix set, embedded like the tree's nodes.
+ * @param[in] cmp Comparator for the full keys, called only on a prefix tie, or NULL if the prefix is the whole key.
+ */
+rb_node_t *rb_prefix_find(const rb_tree_t *tree, const rb_prefix_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_prefix_lower_bound
+ * @brief Returns the first node that does not compare less than key, or NULL.
+ * @param[in] tree Pointer to an rb_tree instance holding only prefix nodes.
+ * @param[in] key Pointer to an rb_prefix_node instance with its prefix set, embedded like the tree's nodes.
+ * @param[in] cmp Comparator for the full keys, called only on a prefix tie, or NULL if the prefix is the whole key.
+ */
+rb_node_t *rb_prefix_lower_bound(const rb_tree_t *tree, const rb_prefix_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/**
+ * @fn rb_prefix_upper_bound
+ * @brief Returns the first node that compares greater than key, or NULL.
+ * @param[in] tree Pointer to an rb_tree instance holding only prefix nodes.
+ * @param[in] key Pointer to an rb_prefix_node instance with its prefix set, embedded like the tree's nodes.
+ * @param[in] cmp Comparator for the full keys, called only on a prefix tie, or NULL if the prefix is the whole key.
+ */
+rb_node_t *rb_prefix_upper_bound(const rb_tree_t *tree, const rb_prefix_node_t *key, int (*cmp)(const rb_node_t *left, const rb_node_t *right));
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RBTREE_PREFIX_H_ */
@@ -0,0 +1,590 @@
+/**
+ * @file rbtree_slim.c
+ * @author krad2
+ * @brief A red-black tree whose node has no parent link, with a 16-byte node.
+ */
+
+#include "rbtree_slim.h"
+
+/**
+ * @defgroup rb_slim_links Helper functions for the __rb_left_color member of rb_slim_node_t.
+ * @{
+ */
+
+#define RB_SLIM_BLACK										((uintptr_t) rb_black)
+
+/* --- */
+
+static inline bool __rb_slim_is_black(const rb_slim_node_t *rb) {
+	return rb_slim_color(rb) == rb_black;
+}
+
+static inline bool __rb_slim_is_red(const rb_slim_node_t *rb) {
+	return rb_slim_color(rb) == rb_red;
+}
+
+static inline void __rb_slim_set_black(rb_slim_node_t *rb) {
+	rb->__rb_left_color |= RB_SLIM_BLACK;
+}
+
+static inline void __rb_slim_set_red(rb_slim_node_t *rb) {
+	rb->__rb_left_color &= ~RB_SLIM_BLACK;
+}
+
+static inline void __rb_slim_set_color(rb_slim_node_t *rb, rb_color_t color) {
+	rb->__rb_left_color = (rb->__rb_left_color & ~RB_SLIM_BLACK) | (uintptr_t) color;
+}
+
+static inline void __rb_slim_set_left(rb_slim_node_t *rb, rb_slim_node_t *left) {
+
+	/* same packing as __rb_set_parent, on the left link instead */
+	rb->__rb_left_color = (uintptr_t) left | (rb->__rb_left_color & RB_SLIM_BLACK);
+}
+
+static inline void __rb_slim_replace_child(rb_slim_tree_t *tree, rb_slim_node_t *root, rb_slim_node_t *old, rb_slim_node_t *nw) {
+	if (root) {
+
+		/* links 'new' in place of 'old' on the side of 'root' that 'old' was on */
+		if (rb_slim_left(root) == old) __rb_slim_set_left(root, nw);
+		else root->right = nw;
+
+	/* 'old' had no parent, so 'new' is the tree's root now */
+	} else tree->root = nw;
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_slim_rotations Slim tree rotation operations
+ * @{
+ */
+
+/**
+ * @brief Rotates the subtree at root to the left and returns its new root, which the caller links in above.
+ * @details With no parent links, that's two stores instead of the regular tree's six.
+ */
+static inline rb_slim_node_t *__rb_slim_left_rotate(rb_slim_node_t *root) {
+	rb_slim_node_t *pivot = root->right;
+
+	root->right = rb_slim_left(pivot);
+	__rb_slim_set_left(pivot, root);
+
+	return pivot;
+}
+
+/**
+ * @brief Rotates the subtree at root to the right and returns its new root, which the caller links in above.
+ */
+static inline rb_slim_node_t *__rb_slim_right_rotate(rb_slim_node_t *root) {
+	rb_slim_node_t *pivot = rb_slim_left(root);
+
+	__rb_slim_set_left(root, pivot->right);
+	pivot->right = root;
+
+	return pivot;
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_slim_updates Slim tree insertion and deletion helpers.
+ * @{
+ */
+
+/**
+ * @brief Restores the red-black invariants above a freshly linked red node.
+ * @param[in] tree Tree the node was linked into.
+ * @param[in] path The node's ancestors, root first, standing in for the parent links.
+ * @param[in] depth Number of ancestors.
+ * @param[in] node Red node that may have a red parent.
+ */
+static inline void __rb_slim_insert_rebalance(rb_slim_tree_t *tree, rb_slim_node_t **path, size_t depth, rb_slim_node_t *node) {
+	for (;;) {
+		rb_slim_node_t *parent, *grandparent, *great_grandparent, *uncle;
+
+		/* hitting the root means we're done - make sure it's black afterwards */
+		if (depth == 0) {
+			__rb_slim_set_black(node);
+			return;
+		}
+
+		/* a black parent can take a red child */
+		parent = path[depth - 1];
+		if (__rb_slim_is_black(parent)) return;
+
+		/* a red parent is never the root, so the grandparent is on the path too */
+		grandparent = path[depth - 2];
+		great_grandparent = (depth >= 3) ? path[depth - 3] : NULL;
+		uncle = (rb_slim_left(grandparent) == parent) ? grandparent->right : rb_slim_left(grandparent);
+
+		/* try a recolor first, and carry on two levels up */
+		if (__rb_slim_is_red(uncle)) {
+			__rb_slim_set_black(parent);
+			__rb_slim_set_black(uncle);
+			__rb_slim_set_red(grandparent);
+			node = grandparent;
+			depth -= 2;
+			continue;
+		}
+
+		if (parent == rb_slim_left(grandparent)) {
+
+			/* left-right: convert it to the left-left case, which swaps the roles of node and parent */
+			if (node == parent->right) {
+				__rb_slim_set_left(grandparent, __rb_slim_left_rotate(parent));
+				parent = node;
+			}
+
+			/* left-left */
+			__rb_slim_set_black(parent);
+			__rb_slim_set_red(grandparent);
+			__rb_slim_replace_child(tree, great_grandparent, grandparent, __rb_slim_right_rotate(grandparent));
+		} else {
+
+			/* right-left: convert it to the right-right case */
+			if (node == rb_slim_left(parent)) {
+				grandparent->right = __rb_slim_right_rotate(parent);
+				parent = node;
+			}
+
+			/* right-right */
+			__rb_slim_set_black(parent);
+			__rb_slim_set_red(grandparent);
+			__rb_slim_replace_child(tree, great_grandparent, grandparent, __rb_slim_left_rotate(grandparent));
+		}
+
+		/* the subtree's new root is black, so nothing above it can be in violation */
+		return;
+	}
+}
+
+/**
+ * @brief Restores the black height after a black leaf was spliced out, leaving node (possibly NULL) in its place.
+ * @details A rotation that moves the sibling above the parent also makes it one of node's ancestors, so the path is
+ * patched to match. That only lengthens it by one, and never past the height the tree had before the delete.
+ * @param[in] tree Tree the leaf was removed from.
+ * @param[in] path Node's ancestors, root first, standing in for the parent links.
+ * @param[in] depth Number of ancestors.
+ * @param[in] node Node one black short, or NULL.
+ */
+static inline void __rb_slim_delete_rebalance(rb_slim_tree_t *tree, rb_slim_node_t **path, size_t depth, rb_slim_node_t *node) {
+	while (depth > 0 && __rb_slim_is_black(node)) {
+		rb_slim_node_t *parent = path[depth - 1];
+		rb_slim_node_t *grandparent = (depth >= 2) ? path[depth - 2] : NULL;
+		rb_slim_node_t *sibling;
+
+		/* the short side is never empty on both sides, so a NULL node still tells which side it's on */
+		if (node == rb_slim_left(parent)) {
+			sibling = parent->right;
+
+			/* move a red sibling above the parent so the new sibling is black */
+			if (__rb_slim_is_red(sibling)) {
+				__rb_slim_set_black(sibling);
+				__rb_slim_set_red(parent);
+				__rb_slim_replace_child(tree, grandparent, parent, __rb_slim_left_rotate(parent));
+
+				path[depth - 1] = grandparent = sibling;
+				path[depth++] = parent;
+				sibling = parent->right;
+			}
+
+			/* if the nephew / niece can't take the black recolor, try to propagate it up and dissolve it further up */
+			if (__rb_slim_is_black(rb_slim_left(sibling)) && __rb_slim_is_black(sibling->right)) {
+				__rb_slim_set_red(sibling);
+				node = parent;
+				depth--;
+				continue;
+			}
+
+			/* right-left: pull the inner red up so the far one is red */
+			if (__rb_slim_is_black(sibling->right)) {
+				__rb_slim_set_black(rb_slim_left(sibling));
+				__rb_slim_set_red(sibling);
+				parent->right = sibling = __rb_slim_right_rotate(sibling);
+			}
+
+			/* right-right */
+			__rb_slim_set_color(sibling, rb_slim_color(parent));
+			__rb_slim_set_black(parent);
+			__rb_slim_set_black(sibling->right);
+			__rb_slim_replace_child(tree, grandparent, parent, __rb_slim_left_rotate(parent));
+		} else {
+			sibling = rb_slim_left(parent);
+
+			if (__rb_slim_is_red(sibling)) {
+				__rb_slim_set_black(sibling);
+				__rb_slim_set_red(parent);
+				__rb_slim_replace_child(tree, grandparent, parent, __rb_slim_right_rotate(parent));
+
+				path[depth - 1] = grandparent = sibling;
+				path[depth++] = parent;
+				sibling = rb_slim_left(parent);
+			}
+
+			if (__rb_slim_is_black(rb_slim_left(sibling)) && __rb_slim_is_black(sibling->right)) {
+				__rb_slim_set_red(sibling);
+				node = parent;
+				depth--;
+				continue;
+			}
+
+			/* left-right */
+			if (__rb_slim_is_black(rb_slim_left(sibling))) {
+				__rb_slim_set_black(sibling->right);
+				__rb_slim_set_red(sibling);
+				sibling = __rb_slim_left_rotate(sibling);
+				__rb_slim_set_left(parent, sibling);
+			}
+
+			/* left-left */
+			__rb_slim_set_color(sibling, rb_slim_color(parent));
+			__rb_slim_set_black(parent);
+			__rb_slim_set_black(rb_slim_left(sibling));
+			__rb_slim_replace_child(tree, grandparent, parent, __rb_slim_right_rotate(parent));
+		}
+
+		return;
+	}
+
+	/* deleting a red doesn't break any invariants, and a red that takes over a black's spot just turns black */
+	if (node) __rb_slim_set_black(node);
+}
+
+/**
+ * @brief Trades tree positions between target and its in-order successor, like __rb_swap_successor.
+ * @details Afterwards, target sits where the successor was and has at most a right child.
+ */
+static inline void __rb_slim_swap_successor(rb_slim_tree_t *tree, rb_slim_node_t *parent, rb_slim_node_t *target, rb_slim_node_t *successor_parent, rb_slim_node_t *successor) {
+	rb_slim_node_t *left = rb_slim_left(target);
+	rb_slim_node_t *right = target->right;
+	rb_slim_node_t *successor_right = successor->right;
+	rb_color_t target_color = rb_slim_color(target);
+	rb_color_t successor_color = rb_slim_color(successor);
+
+	/* the successor takes over the target's link from above, along with its color */
+	__rb_slim_replace_child(tree, parent, target, successor);
+	successor->__rb_left_color = (uintptr_t) left | (uintptr_t) target_color;
+
+	/* if the successor was the target's right child, the target simply hangs off of it on that side */
+	if (successor == right) {
+		successor->right = target;
+	} else {
+		successor->right = right;
+		__rb_slim_set_left(successor_parent, target);
+	}
+
+	/* the target adopts whatever the successor left behind */
+	target->__rb_left_color = (uintptr_t) successor_color;
+	target->right = successor_right;
+}
+
+/**
+ * @brief Unlinks the node at the end of a path.
+ * @param[in] tree Tree containing the path.
+ * @param[in] path Nodes from the root down to the target. Overwritten.
+ * @param[in] depth Index of the target in the path, i.e. its number of ancestors.
+ */
+static void __rb_slim_erase(rb_slim_tree_t *tree, rb_slim_node_t **path, size_t depth) {
+	rb_slim_node_t *target = path[depth], *parent, *child;
+
+	/* with two children, swap into the successor's spot first, extending the path down to it */
+	if (rb_slim_left(target) && target->right) {
+		size_t target_depth = depth;
+		rb_slim_node_t *successor;
+
+		path[++depth] = target->right;
+		while (rb_slim_left(path[depth])) {
+			path[depth + 1] = rb_slim_left(path[depth]);
+			depth++;
+		}
+
+		successor = path[depth];
+		__rb_slim_swap_successor(tree, target_depth ? path[target_depth - 1] : NULL, target, path[depth - 1], successor);
+
+		path[target_depth] = successor;
+		path[depth] = target;
+	}
+
+	child = rb_slim_left(target) ? rb_slim_left(target) : target->right;
+	parent = depth ? path[depth - 1] : NULL;
+	__rb_slim_replace_child(tree, parent, target, child);
+
+	/**
+	 * a red leaf can just go, and a lone child is always red, so it can take over the target's black.
+	 * removing a black leaf shortens its path, so that has to be fixed up from the empty slot.
+	 */
+	if (__rb_slim_is_black(target)) __rb_slim_delete_rebalance(tree, path, depth, child);
+
+	target->__rb_left_color = RB_SLIM_BLACK;
+	target->right = NULL;
+}
+
+/**
+ * @brief Descends to where node goes, after any equal nodes, recording the path. Stops early on an equal one if unique.
+ * @return The equal node found, or NULL once path and *left describe the empty slot.
+ */
+static inline rb_slim_node_t *__rb_slim_descend(const rb_slim_tree_t *tree, const rb_slim_node_t *node, int (*cmp)(const rb_slim_node_t *left, const rb_slim_node_t *right), bool unique, rb_slim_node_t **path, size_t *depth, bool *left) {
+	rb_slim_node_t *cursor = tree->root;
+
+	*depth = 0;
+	*left = false;
+
+	while (cursor) {
+		int comparison = cmp(node, cursor);
+
+		if (unique && comparison == 0) return cursor;
+
+		path[(*depth)++] = cursor;
+		*left = comparison < 0;
+		cursor = *left ? rb_slim_left(cursor) : cursor->right;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Hangs node off of the end of a path as a red leaf and rebalances.
+ */
+static inline void __rb_slim_link(rb_slim_tree_t *tree, rb_slim_node_t **path, size_t depth, rb_slim_node_t *node, bool left) {
+	node->__rb_left_color = (uintptr_t) rb_red;
+	node->right = NULL;
+
+	if (depth == 0) tree->root = node;
+	else if (left) __rb_slim_set_left(path[depth - 1], node);
+	else path[depth - 1]->right = node;
+
+	__rb_slim_insert_rebalance(tree, path, depth, node);
+}
+
+/**
+ * @brief Shared descent of rb_slim_lower_bound and rb_slim_upper_bound. Equal nodes go left unless strict.
+ */
+static inline rb_slim_node_t *__rb_slim_bound(const rb_slim_tree_t *tree, const rb_slim_node_t *key, int (*cmp)(const rb_slim_node_t *left, const rb_slim_node_t *right), bool strict, rb_slim_iter_t *iter) {
+	rb_slim_node_t *cursor = tree->root, *bound = NULL;
+	size_t depth = 0, bound_depth = 0;
+
+	while (cursor) {
+		int comparison = cmp(key, cursor);
+
+		/* the whole descent is recorded, then cut back to the last node that qualified */
+		if (iter) iter->path[depth] = cursor;
+		depth++;
+
+		if (comparison < 0 || (comparison == 0 && !strict)) {
+			bound = cursor;
+			bound_depth = depth;
+			cursor = rb_slim_left(cursor);
+		} else {
+			cursor = cursor->right;
+		}
+	}
+
+	if (iter) iter->depth = bound_depth;
+	return bound;
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_slim_api Slim tree API.
+ * @{
+ */
+
+/**
+ * @fn rb_slim_tree_init
+ * @brief Initializes an empty slim tree.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ */
+void rb_slim_tree_init(rb_slim_tree_t *tree) {
+	tree->root = NULL;
+}
+
+/**
+ * @fn rb_slim_tree_insert
+ * @brief Inserts a node. Equal keys go after the ones already there, same as rb_tree_insert.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ * @param[in] node Pointer to an rb_slim_node instance embedded in something else.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+void rb_slim_tree_insert(rb_slim_tree_t *tree, rb_slim_node_t *node, int (*cmp)(const rb_slim_node_t *left, const rb_slim_node_t *right)) {
+	rb_slim_node_t *path[RB_SLIM_STACK];
+	size_t depth;
+	bool left;
+
+	__rb_slim_descend(tree, node, cmp, false, path, &depth, &left);
+	__rb_slim_link(tree, path, depth, node, left);
+}
+
+/**
+ * @fn rb_slim_tree_insert_unique
+ * @brief Inserts a node unless an equal one is already in the tree.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ * @param[in] node Pointer to an rb_slim_node instance embedded in something else.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ * @return NULL if the node was inserted, else the equal node that blocked it.
+ */
+rb_slim_node_t *rb_slim_tree_insert_unique(rb_slim_tree_t *tree, rb_slim_node_t *node, int (*cmp)(const rb_slim_node_t *left, const rb_slim_node_t *right)) {
+	rb_slim_node_t *path[RB_SLIM_STACK], *existing;
+	size_t depth;
+	bool left;
+
+	existing = __rb_slim_descend(tree, node, cmp, true, path, &depth, &left);
+	if (!existing) __rb_slim_link(tree, path, depth, node, left);
+
+	return existing;
+}
+
+/**
+ * @fn rb_slim_tree_delete_at
+ * @brief Unlinks the node an iterator is at, using the path it already holds. The iterator is spent afterwards.
+ * @param[in] tree Pointer to the rb_slim_tree instance the iterator is in.
+ * @param[in] iter Iterator at the node to delete.
+ */
+void rb_slim_tree_delete_at(rb_slim_tree_t *tree, rb_slim_iter_t *iter) {
+	if (iter->depth == 0) return;
+
+	__rb_slim_erase(tree, iter->path, iter->depth - 1);
+	iter->depth = 0;
+}
+
+/**
+ * @fn rb_slim_tree_delete
+ * @brief Searches for a node by its key and unlinks that exact node, even among equal ones.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ * @param[in] node Node to delete.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ * @return False if the node wasn't in the tree.
+ */
+bool rb_slim_tree_delete(rb_slim_tree_t *tree, rb_slim_node_t *node, int (*cmp)(const rb_slim_node_t *left, const rb_slim_node_t *right)) {
+	rb_slim_iter_t iter;
+	rb_slim_node_t *cursor = rb_slim_lower_bound(tree, node, cmp, &iter);
+
+	/* equal keys sit in one in-order run, so the node is somewhere in it or nowhere */
+	while (cursor != node) {
+		if (!cursor || cmp(node, cursor) != 0) return false;
+		cursor = rb_slim_next(&iter);
+	}
+
+	rb_slim_tree_delete_at(tree, &iter);
+	return true;
+}
+
+/**
+ * @fn rb_slim_find
+ * @brief Binary search to find 'key'. Returns NULL if not found.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ * @param[in] key Pointer to the node to be found.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+rb_slim_node_t *rb_slim_find(const rb_slim_tree_t *tree, const rb_slim_node_t *key, int (*cmp)(const rb_slim_node_t *left, const rb_slim_node_t *right)) {
+	rb_slim_node_t *cursor = tree->root;
+
+	while (cursor) {
+		int comparison = cmp(key, cursor);
+
+		if (comparison == 0) break;
+		cursor = (comparison < 0) ? rb_slim_left(cursor) : cursor->right;
+	}
+
+	return cursor;
+}
+
+/**
+ * @fn rb_slim_lower_bound
+ * @brief Returns the first node that does not compare less than key, or NULL.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used for the search.
+ * @param[out] iter Iterator to leave at the result, or NULL.
+ */
+rb_slim_node_t *rb_slim_lower_bound(const rb_slim_tree_t *tree, const rb_slim_node_t *key, int (*cmp)(const rb_slim_node_t *left, const rb_slim_node_t *right), rb_slim_iter_t *iter) {
+	return __rb_slim_bound(tree, key, cmp, false, iter);
+}
+
+/**
+ * @fn rb_slim_upper_bound
+ * @brief Returns the first node that compares greater than key, or NULL.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used for the search.
+ * @param[out] iter Iterator to leave at the result, or NULL.
+ */
+rb_slim_node_t *rb_slim_upper_bound(const rb_slim_tree_t *tree, const rb_slim_node_t *key, int (*cmp)(const rb_slim_node_t *left, const rb_slim_node_t *right), rb_slim_iter_t *iter) {
+	return __rb_slim_bound(tree, key, cmp, true, iter);
+}
+
+/**
+ * @fn rb_slim_first
+ * @brief Points an iterator at the smallest node and returns it, or NULL if the tree is empty.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ * @param[out] iter Iterator to set up.
+ */
+rb_slim_node_t *rb_slim_first(const rb_slim_tree_t *tree, rb_slim_iter_t *iter) {
+	iter->depth = 0;
+	for (rb_slim_node_t *cursor = tree->root; cursor; cursor = rb_slim_left(cursor)) iter->path[iter->depth++] = cursor;
+
+	return rb_slim_iter_node(iter);
+}
+
+/**
+ * @fn rb_slim_last
+ * @brief Points an iterator at the largest node and returns it, or NULL if the tree is empty.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ * @param[out] iter Iterator to set up.
+ */
+rb_slim_node_t *rb_slim_last(const rb_slim_tree_t *tree, rb_slim_iter_t *iter) {
+	iter->depth = 0;
+	for (rb_slim_node_t *cursor = tree->root; cursor; cursor = cursor->right) iter->path[iter->depth++] = cursor;
+
+	return rb_slim_iter_node(iter);
+}
+
+/**
+ * @fn rb_slim_next
+ * @brief Steps an iterator to the in-order successor and returns it, or NULL past the last node.
+ * @param[in] iter Iterator into a slim tree.
+ */
+rb_slim_node_t *rb_slim_next(rb_slim_iter_t *iter) {
+	rb_slim_node_t *cursor;
+
+	if (iter->depth == 0) return NULL;
+	cursor = iter->path[iter->depth - 1];
+
+	/* the leftmost node of the right subtree, if there is one */
+	if (cursor->right) {
+		for (cursor = cursor->right; cursor; cursor = rb_slim_left(cursor)) iter->path[iter->depth++] = cursor;
+
+	/* otherwise climb out of every subtree we were the right side of */
+	} else {
+		do {
+			cursor = iter->path[--iter->depth];
+		} while (iter->depth && iter->path[iter->depth - 1]->right == cursor);
+	}
+
+	return rb_slim_iter_node(iter);
+}
+
+/**
+ * @fn rb_slim_prev
+ * @brief Steps an iterator to the in-order predecessor and returns it, or NULL before the first node.
+ * @param[in] iter Iterator into a slim tree.
+ */
+rb_slim_node_t *rb_slim_prev(rb_slim_iter_t *iter) {
+	rb_slim_node_t *cursor;
+
+	if (iter->depth == 0) return NULL;
+	cursor = iter->path[iter->depth - 1];
+
+	/* mirror image of rb_slim_next */
+	if (rb_slim_left(cursor)) {
+		for (cursor = rb_slim_left(cursor); cursor; cursor = cursor->right) iter->path[iter->depth++] = cursor;
+	} else {
+		do {
+			cursor = iter->path[--iter->depth];
+		} while (iter->depth && rb_slim_left(iter->path[iter->depth - 1]) == cursor);
+	}
+
+	return rb_slim_iter_node(iter);
+}
+
+/** @} */
@@ -0,0 +1,210 @@
+/**
+ * @file rbtree_slim.h
+ * @author krad2
+ * @brief A red-black tree whose node has no parent link, with a 16-byte node.
+ * @details Trees that are only ever searched, inserted into and scanned don't need to walk up from a node, so
+ * rb_slim_node_t drops the parent link and keeps the color in the low bit of its left link instead. Without parents,
+ * updates remember the path they took on a bounded stack and rebalance from it, and rotations have two fewer links
+ * to store. Iteration goes through an rb_slim_iter_t, which holds the path to the current node. What that gives up
+ * is anything that starts from a bare node: deleting a node without searching for it, or stepping to its neighbor.
+ * A slim tree can sit next to regular trees; the two node types just can't be mixed within one tree.
+ */
+
+#ifndef RBTREE_SLIM_H_
+#define RBTREE_SLIM_H_
+
+#include "rbtree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct rb_slim_node
+ * @brief A parent-less tree node to be embedded in something else.
+ * @var rb_slim_node::__rb_left_color
+ * Left child pointer with the color in the low bit. Maintained by the tree, don't touch; use rb_slim_left.
+ * @var rb_slim_node::right
+ * Right child.
+ */
+typedef struct rb_slim_node {
+	uintptr_t __rb_left_color;
+	struct rb_slim_node *right;
+} rb_slim_node_t;
+
+/**
+ * @struct rb_slim_tree
+ * @brief A tree of rb_slim_node_t.
+ * @var rb_slim_tree::root
+ * Root node, or NULL if the tree is empty.
+ */
+typedef struct rb_slim_tree {
+	rb_slim_node_t *root;
+} rb_slim_tree_t;
+
+/**
+ * @defgroup rb_slim_macros Slim tree macros.
+ * @{
+ */
+
+/**
+ * Longest path a slim tree can have: a red-black tree of n nodes is at most 2 * log2(n + 1) tall.
+ */
+#define RB_SLIM_STACK										(2 * 8 * sizeof(uintptr_t))
+
+/**
+ * Returns the left child of a node.
+ */
+#define rb_slim_left(rb)									((rb_slim_node_t *) ((rb)->__rb_left_color & ~(uintptr_t) rb_black))
+
+/**
+ * Returns the right child of a node.
+ */
+#define rb_slim_right(rb)									((rb)->right)
+
+/**
+ * Returns rb_black if the pointer is NULL or it is defined as a black node, else red.
+ */
+#define rb_slim_color(rb)									((rb_color_t) ((rb) == NULL || ((rb)->__rb_left_color & rb_black)))
+
+/**
+ * Returns true if the tree has no nodes.
+ */
+#define rb_slim_is_empty(tree)								((tree)->root == NULL)
+
+/**
+ * Returns the node an iterator is at, or NULL once it has run off either end.
+ */
+#define rb_slim_iter_node(iter)								((iter)->depth ? (iter)->path[(iter)->depth - 1] : NULL)
+
+/** @} */
+
+/**
+ * @struct rb_slim_iter
+ * @brief A position in a slim tree, kept as the path down to it.
+ * @details Any insertion or deletion in the tree invalidates every iterator into it.
+ * @var rb_slim_iter::path
+ * Nodes from the root down to the current one.
+ * @var rb_slim_iter::depth
+ * Number of nodes on the path. 0 once the iterator has run off either end.
+ */
+typedef struct rb_slim_iter {
+	rb_slim_node_t *path[RB_SLIM_STACK];
+	size_t depth;
+} rb_slim_iter_t;
+
+/**
+ * @defgroup rb_slim_api Slim tree API.
+ * @{
+ */
+
+/**
+ * @fn rb_slim_tree_init
+ * @brief Initializes an empty slim tree.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ */
+void rb_slim_tree_init(rb_slim_tree_t *tree);
+
+/**
+ * @fn rb_slim_tree_insert
+ * @brief Inserts a node. Equal keys go after the ones already there, same as rb_tree_insert.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ * @param[in] node Pointer to an rb_slim_node instance embedded in something else.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ */
+void rb_slim_tree_insert(rb_slim_tree_t *tree, rb_slim_node_t *node, int (*cmp)(const rb_slim_node_t *left, const rb_slim_node_t *right));
+
+/**
+ * @fn rb_slim_tree_insert_unique
+ * @brief Inserts a node unless an equal one is already in the tree.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ * @param[in] node Pointer to an rb_slim_node instance embedded in something else.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ * @return NULL if the node was inserted, else the equal node that blocked it.
+ */
+rb_slim_node_t *rb_slim_tree_insert_unique(rb_slim_tree_t *tree, rb_slim_node_t *node, int (*cmp)(const rb_slim_node_t *left, const rb_slim_node_t *right));
+
+/**
+ * @fn rb_slim_tree_delete_at
+ * @brief Unlinks the node an iterator is at, using the path it already holds. The iterator is spent afterwards.
+ * @param[in] tree Pointer to the rb_slim_tree instance the iterator is in.
+ * @param[in] iter Iterator at the node to delete.
+ */
+void rb_slim_tree_delete_at(rb_slim_tree_t *tree, rb_slim_iter_t *iter);
+
+/**
+ * @fn rb_slim_tree_delete
+ * @brief Searches for a node by its key and unlinks that exact node, even among equal ones.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ * @param[in] node Node to delete.
+ * @param[in] cmp Comparator callback used to traverse the tree.
+ * @return False if the node wasn't in the tree.
+ */
+bool rb_slim_tree_delete(rb_slim_tree_t *tree, rb_slim_node_t *node, int (*cmp)(const rb_slim_node_t *left, const rb_slim_node_t *right));
+
+/**
+ * @fn rb_slim_find
+ * @brief Binary search to find 'key'. Returns NULL if not found.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ * @param[in] key Pointer to the node to be found.
+ * @param[in] cmp Comparator callback used for the search.
+ */
+rb_slim_node_t *rb_slim_find(const rb_slim_tree_t *tree, const rb_slim_node_t *key, int (*cmp)(const rb_slim_node_t *left, const rb_slim_node_t *right));
+
+/**
+ * @fn rb_slim_lower_bound
+ * @brief Returns the first node that does not compare less than key, or NULL.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used for the search.
+ * @param[out] iter Iterator to leave at the result, or NULL.
+ */
+rb_slim_node_t *rb_slim_lower_bound(const rb_slim_tree_t *tree, const rb_slim_node_t *key, int (*cmp)(const rb_slim_node_t *left, const rb_slim_node_t *right), rb_slim_iter_t *iter);
+
+/**
+ * @fn rb_slim_upper_bound
+ * @brief Returns the first node that compares greater than key, or NULL.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ * @param[in] key Pointer to the node to be bounded.
+ * @param[in] cmp Comparator callback used for the search.
+ * @param[out] iter Iterator to leave at the result, or NULL.
+ */
+rb_slim_node_t *rb_slim_upper_bound(const rb_slim_tree_t *tree, const rb_slim_node_t *key, int (*cmp)(const rb_slim_node_t *left, const rb_slim_node_t *right), rb_slim_iter_t *iter);
+
+/**
+ * @fn rb_slim_first
+ * @brief Points an iterator at the smallest node and returns it, or NULL if the tree is empty.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ * @param[out] iter Iterator to set up.
+ */
+rb_slim_node_t *rb_slim_first(const rb_slim_tree_t *tree, rb_slim_iter_t *iter);
+
+/**
+ * @fn rb_slim_last
+ * @brief Points an iterator at the largest node and returns it, or NULL if the tree is empty.
+ * @param[in] tree Pointer to an rb_slim_tree instance.
+ * @param[out] iter Iterator to set up.
+ */
+rb_slim_node_t *rb_slim_last(const rb_slim_tree_t *tree, rb_slim_iter_t *iter);
+
+/**
+ * @fn rb_slim_next
+ * @brief Steps an iterator to the in-order successor and returns it, or NULL past the last node.
+ * @param[in] iter Iterator into a slim tree.
+ */
+rb_slim_node_t *rb_slim_next(rb_slim_iter_t *iter);
+
+/**
+ * @fn rb_slim_prev
+ * @brief Steps an iterator to the in-order predecessor and returns it, or NULL before the first node.
+ * @param[in] iter Iterator into a slim tree.
+ */
+rb_slim_node_t *rb_slim_prev(rb_slim_iter_t *iter);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RBTREE_SLIM_H_ */
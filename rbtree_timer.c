@@ -0,0 +1,144 @@
+/**
+ * @file rbtree_timer.c
+ * @author krad2
+ * @brief A high-resolution timer scheduler built on the min-cached red-black tree, in the spirit of the kernel's hrtimers.
+ */
+
+#include "rbtree_timer.h"
+
+/**
+ * @defgroup rb_timer_helpers Timer helpers.
+ * @{
+ */
+
+/**
+ * @brief Orders timers by expiry.
+ */
+static int __rb_timer_cmp(const rb_node_t *left, const rb_node_t *right) {
+	uint64_t l = rb_timer_entry(left)->expires;
+	uint64_t r = rb_timer_entry(right)->expires;
+
+	return (l > r) - (l < r);
+}
+
+/**
+ * @brief Hands an expired timer, already unlinked, to its callback.
+ */
+static void __rb_timer_fire(rb_node_t *node) {
+	rb_timer_t *timer = rb_timer_entry(node);
+	if (timer->fn) timer->fn(timer);
+}
+
+/** @} */
+
+/**
+ * @defgroup rb_timer_api Timer API.
+ * @{
+ */
+
+/**
+ * @fn rb_timer_base_init
+ * @brief Initializes a timer base with no pending timers.
+ * @param[in] base Pointer to an rb_timer_base instance.
+ */
+void rb_timer_base_init(rb_timer_base_t *base) {
+	rb_tree_lcached_init(&base->tree);
+}
+
+/**
+ * @fn rb_timer_init
+ * @brief Initializes a timer that isn't pending.
+ * @param[in] timer Pointer to an rb_timer instance.
+ * @param[in] fn Expiry callback.
+ */
+void rb_timer_init(rb_timer_t *timer, void (*fn)(rb_timer_t *timer)) {
+	rb_disconnect(&timer->node);
+	timer->expires = 0;
+	timer->fn = fn;
+}
+
+/**
+ * @fn rb_timer_add
+ * @brief Arms a timer that isn't pending to expire at a given time.
+ * @param[in] base Pointer to an rb_timer_base instance.
+ * @param[in] timer Pointer to an rb_timer instance that isn't pending.
+ * @param[in] expires Expiry time.
+ */
+void rb_timer_add(rb_timer_base_t *base, rb_timer_t *timer, uint64_t expires) {
+	timer->expires = expires;
+
+	/* earlier than everything goes straight under the min, same as any new min in an lcached tree */
+	rb_tree_lcached_insert(&base->tree, &timer->node, __rb_timer_cmp);
+}
+
+/**
+ * @fn rb_timer_cancel
+ * @brief Disarms a timer without searching for it.
+ * @param[in] base Pointer to the rb_timer_base instance the timer was added to.
+ * @param[in] timer Pointer to an rb_timer instance.
+ * @return True if the timer was pending, false if there was nothing to cancel.
+ */
+bool rb_timer_cancel(rb_timer_base_t *base, rb_timer_t *timer) {
+	if (!rb_timer_pending(timer)) return false;
+
+	/* the node is the timer's position in the tree, so it unlinks directly */
+	rb_tree_lcached_delete_at(&base->tree, &timer->node, __rb_timer_cmp);
+	return true;
+}
+
+/**
+ * @fn rb_timer_modify
+ * @brief Moves a timer to a new expiry time, arming it if it isn't pending.
+ * @details If the new time still falls between the timer's neighbors, it is updated in place without touching the tree.
+ * @param[in] base Pointer to an rb_timer_base instance.
+ * @param[in] timer Pointer to an rb_timer instance.
+ * @param[in] expires New expiry time.
+ * @return True if the timer was pending beforehand.
+ */
+bool rb_timer_modify(rb_timer_base_t *base, rb_timer_t *timer, uint64_t expires) {
+	if (rb_timer_pending(timer)) {
+		const rb_node_t *prev = rb_prev(&timer->node);
+		const rb_node_t *next = rb_next(&timer->node);
+
+		/* still sorted against both neighbors means the tree's shape doesn't need to change at all */
+		if ((!prev || rb_timer_entry(prev)->expires <= expires) && (!next || expires < rb_timer_entry(next)->expires)) {
+			timer->expires = expires;
+			return true;
+		}
+
+		rb_tree_lcached_delete_at(&base->tree, &timer->node, __rb_timer_cmp);
+		rb_timer_add(base, timer, expires);
+		return true;
+	}
+
+	rb_timer_add(base, timer, expires);
+	return false;
+}
+
+/**
+ * @fn rb_timer_next
+ * @brief Returns the pending timer that expires first, or NULL if there are none, in O(1).
+ * @param[in] base Pointer to an rb_timer_base instance.
+ */
+rb_timer_t *rb_timer_next(const rb_timer_base_t *base) {
+	return rb_min(&base->tree) ? rb_timer_entry(rb_min(&base->tree)) : NULL;
+}
+
+/**
+ * @fn rb_timer_expire
+ * @brief Runs every timer that expires at or before now, in expiry order.
+ * @details Each timer is disarmed before its callback runs. A timer re-added at or before now runs again.
+ * @param[in] base Pointer to an rb_timer_base instance.
+ * @param[in] now Current time.
+ * @return Number of timers run.
+ */
+size_t rb_timer_expire(rb_timer_base_t *base, uint64_t now) {
+	rb_timer_t key = { .expires = now };
+
+	/* nothing due yet is the common case, and the cached min answers it without a call */
+	if (!rb_min(&base->tree) || rb_timer_entry(rb_min(&base->tree))->expires > now) return 0;
+
+	return rb_lcached_pop_until(&base->tree, &key.node, __rb_timer_cmp, __rb_timer_fire);
+}
+
+/** @} */
@@ -0,0 +1,134 @@
+/**
+ * @file rbtree_timer.h
+ * @author krad2
+ * @brief A high-resolution timer scheduler built on the min-cached red-black tree, in the spirit of the kernel's hrtimers.
+ * @details Timers are ordered by expiry in an rb_tree_lcached_t, so the next deadline is always the cached min and can be
+ * read in O(1). Timers embed their own node, which makes cancelling one a straight unlink with no search. Timers with the
+ * same expiry fire in the order they were added.
+ */
+
+#ifndef RBTREE_TIMER_H_
+#define RBTREE_TIMER_H_
+
+#include "rbtree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct rb_timer
+ * @brief A timer to be embedded in something else.
+ * @var rb_timer::node
+ * Tree linkage. Disconnected while the timer isn't pending.
+ * @var rb_timer::expires
+ * Expiry time, in whatever unit the caller passes to rb_timer_expire.
+ * @var rb_timer::fn
+ * Called once the timer expires. The timer is no longer pending by then, so fn may add it again.
+ */
+typedef struct rb_timer {
+	rb_node_t node;
+	uint64_t expires;
+	void (*fn)(struct rb_timer *timer);
+} rb_timer_t;
+
+/**
+ * @struct rb_timer_base
+ * @brief A set of pending timers.
+ * @var rb_timer_base::tree
+ * Pending timers, ordered by expiry.
+ */
+typedef struct rb_timer_base {
+	rb_tree_lcached_t tree;
+} rb_timer_base_t;
+
+/**
+ * @defgroup rb_timer_macros Timer macros.
+ * @{
+ */
+
+/**
+ * Returns the containing rb_timer_t of a node in a timer base.
+ */
+#define rb_timer_entry(rb)									container_of(rb, rb_timer_t, node)
+
+/**
+ * Returns true if the timer is waiting to expire in some base.
+ */
+#define rb_timer_pending(timer)								(!rb_is_disconnected(&(timer)->node))
+
+/** @} */
+
+/**
+ * @defgroup rb_timer_api Timer API.
+ * @{
+ */
+
+/**
+ * @fn rb_timer_base_init
+ * @brief Initializes a timer base with no pending timers.
+ * @param[in] base Pointer to an rb_timer_base instance.
+ */
+void rb_timer_base_init(rb_timer_base_t *base);
+
+/**
+ * @fn rb_timer_init
+ * @brief Initializes a timer that isn't pending.
+ * @param[in] timer Pointer to an rb_timer instance.
+ * @param[in] fn Expiry callback.
+ */
+void rb_timer_init(rb_timer_t *timer, void (*fn)(rb_timer_t *timer));
+
+/**
+ * @fn rb_timer_add
+ * @brief Arms a timer that isn't pending to expire at a given time.
+ * @param[in] base Pointer to an rb_timer_base instance.
+ * @param[in] timer Pointer to an rb_timer instance that isn't pending.
+ * @param[in] expires Expiry time.
+ */
+void rb_timer_add(rb_timer_base_t *base, rb_timer_t *timer, uint64_t expires);
+
+/**
+ * @fn rb_timer_cancel
+ * @brief Disarms a timer without searching for it.
+ * @param[in] base Pointer to the rb_timer_base instance the timer was added to.
+ * @param[in] timer Pointer to an rb_timer instance.
+ * @return True if the timer was pending, false if there was nothing to cancel.
+ */
+bool rb_timer_cancel(rb_timer_base_t *base, rb_timer_t *timer);
+
+/**
+ * @fn rb_timer_modify
+ * @brief Moves a timer to a new expiry time, arming it if it isn't pending.
+ * @details If the new time still falls between the timer's neighbors, it is updated in place without touching the tree.
+ * @param[in] base Pointer to an rb_timer_base instance.
+ * @param[in] timer Pointer to an rb_timer instance.
+ * @param[in] expires New expiry time.
+ * @return True if the timer was pending beforehand.
+ */
+bool rb_timer_modify(rb_timer_base_t *base, rb_timer_t *timer, uint64_t expires);
+
+/**
+ * @fn rb_timer_next
+ * @brief Returns the pending timer that expires first, or NULL if there are none, in O(1).
+ * @param[in] base Pointer to an rb_timer_base instance.
+ */
+rb_timer_t *rb_timer_next(const rb_timer_base_t *base);
+
+/**
+ * @fn rb_timer_expire
+ * @brief Runs every timer that expires at or before now, in expiry order.
+ * @details Each timer is disarmed before its callback runs. A timer re-added at or before now runs again.
+ * @param[in] base Pointer to an rb_timer_base instance.
+ * @param[in] now Current time.
+ * @return Number of timers run.
+ */
+size_t rb_timer_expire(rb_timer_base_t *base, uint64_t now);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RBTREE_TIMER_H_ */
@@ -0,0 +1,44 @@
+/**
+ * @file test.h
+ * @author krad2
+ * @brief Checks shared by the regression tests in this directory.
+ * @details Every test is a single file that builds straight against the library sources, from the top of the
+ * repository, and is meant to be run under AddressSanitizer and UndefinedBehaviorSanitizer, e.g.:
+ *
+ *     cc -c -g -fsanitize=address,undefined -I. rbtree.c -o rbtree.o
+ *     c++ -std=c++17 -g -fsanitize=address,undefined -I. test/test_hpp.cpp rbtree.o -o test_hpp && ./test_hpp
+ *
+ * The comment at the top of each one gives its exact command line. A test prints every failed check and exits
+ * non-zero if there were any.
+ */
+
+#ifndef RBTREE_TEST_H_
+#define RBTREE_TEST_H_
+
+#include <stdio.h>
+
+/** Failed checks so far. */
+static int test_failures;
+
+/**
+ * @brief Records a failure, with where it happened, if cond is false. Carries on either way.
+ */
+#define TEST_CHECK(cond)																					\
+	do {																									\
+		if (!(cond)) {																						\
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);						\
+			test_failures++;																				\
+		}																									\
+	} while (0)
+
+/**
+ * @brief Reports the result. Return this from main.
+ */
+static inline int test_finish(const char *name) {
+	if (test_failures) fprintf(stderr, "%s: %d checks failed\n", name, test_failures);
+	else printf("%s: ok\n", name);
+
+	return test_failures ? 1 : 0;
+}
+
+#endif /* RBTREE_TEST_H_ */
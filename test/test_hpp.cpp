@@ -0,0 +1,140 @@
+/**
+ * @file test_hpp.cpp
+ * @author krad2
+ * @brief rb::intrusive_tree: empty trees, ordering, lookups, erasure, moves and finding objects from their nodes.
+ *
+ *     cc -c -g -fsanitize=address,undefined -I. rbtree.c -o rbtree.o
+ *     c++ -std=c++17 -g -fsanitize=address,undefined -I. test/test_hpp.cpp rbtree.o -o test_hpp && ./test_hpp
+ */
+
+#include "rbtree.hpp"
+#include "test/test.h"
+
+#include <iterator>
+#include <vector>
+
+namespace {
+
+/* the node deliberately isn't the first member, so finding an object from its node has to subtract a real offset */
+struct item {
+	long key;
+	int seq;
+	rb_node_t node;
+};
+
+struct by_key {
+	using is_transparent = void;
+	bool operator()(const item &l, const item &r) const { return l.key < r.key; }
+	bool operator()(const item &l, long r) const { return l.key < r; }
+	bool operator()(long l, const item &r) const { return l < r.key; }
+};
+
+using tree_t = rb::intrusive_tree<item, &item::node, by_key>;
+
+void test_empty() {
+	tree_t tree;
+	const tree_t &ctree = tree;
+	int visited = 0;
+
+	TEST_CHECK(tree.empty());
+	TEST_CHECK(tree.size() == 0);
+	TEST_CHECK(tree.begin() == tree.end());
+	TEST_CHECK(ctree.begin() == ctree.end());
+	TEST_CHECK(tree.cbegin() == tree.cend());
+	TEST_CHECK(tree.rbegin() == tree.rend());
+
+	for (item &obj : tree) {
+		(void) obj;
+		visited++;
+	}
+	TEST_CHECK(visited == 0);
+
+	TEST_CHECK(tree.erase(tree.begin(), tree.end()) == tree.end());
+	TEST_CHECK(--tree.end() == tree.end());
+	TEST_CHECK(tree.find(1) == tree.end());
+	TEST_CHECK(tree.lower_bound(1) == tree.end());
+	TEST_CHECK(tree.upper_bound(1) == tree.end());
+	TEST_CHECK(tree.count(1) == 0);
+}
+
+void test_order() {
+	std::vector<item> items;
+	tree_t tree;
+	long last = -1;
+	int last_seq = -1;
+
+	/* keys 0..49, each twice, inserted out of order */
+	for (int i = 0; i < 100; i++) items.push_back(item{ (i * 37) % 50, i, {} });
+	for (item &obj : items) TEST_CHECK(&*tree.insert(obj) == &obj);
+
+	TEST_CHECK(tree.size() == 100);
+	for (const item &obj : tree) {
+		TEST_CHECK(obj.key >= last);
+		if (obj.key == last) TEST_CHECK(obj.seq > last_seq);
+
+		last = obj.key;
+		last_seq = obj.seq;
+	}
+
+	TEST_CHECK((--tree.end())->key == 49);
+	TEST_CHECK(tree.rbegin()->key == 49);
+	TEST_CHECK(tree.begin()->key == 0);
+
+	TEST_CHECK(tree.count(7) == 2);
+	TEST_CHECK(tree.contains(49));
+	TEST_CHECK(!tree.contains(50));
+	TEST_CHECK(tree.lower_bound(10)->key == 10);
+	TEST_CHECK(tree.upper_bound(10)->key == 11);
+	TEST_CHECK(tree.upper_bound(49) == tree.end());
+
+	/* objects are found from their nodes at the right address */
+	for (item &obj : items) {
+		TEST_CHECK(tree_t::to_value(&obj.node) == &obj);
+		TEST_CHECK(&*tree.iterator_to(obj) == &obj);
+	}
+
+	auto range = tree.equal_range(20);
+	TEST_CHECK(std::distance(range.first, range.second) == 2);
+	TEST_CHECK(tree.erase(range.first, range.second)->key == 21);
+	TEST_CHECK(tree.count(20) == 0);
+	TEST_CHECK(tree.size() == 98);
+
+	tree.erase(items[0]);
+	TEST_CHECK(tree.size() == 97);
+
+	tree.erase(tree.begin(), tree.end());
+	TEST_CHECK(tree.empty());
+	TEST_CHECK(tree.begin() == tree.end());
+}
+
+void test_move() {
+	item a{ 1, 0, {} }, b{ 2, 1, {} };
+	tree_t from;
+
+	from.insert(b);
+	from.insert(a);
+
+	tree_t to(std::move(from));
+	TEST_CHECK(from.empty());
+	TEST_CHECK(from.size() == 0);
+	TEST_CHECK(from.begin() == from.end());
+	TEST_CHECK(--from.end() == from.end());
+
+	TEST_CHECK(to.size() == 2);
+	TEST_CHECK(&*to.begin() == &a);
+	TEST_CHECK(&*--to.end() == &b);
+
+	from = std::move(to);
+	TEST_CHECK(to.empty());
+	TEST_CHECK(from.size() == 2);
+}
+
+} // namespace
+
+int main() {
+	test_empty();
+	test_order();
+	test_move();
+
+	return test_finish("test_hpp");
+}
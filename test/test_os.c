@@ -0,0 +1,94 @@
+/**
+ * @file test_os.c
+ * @author krad2
+ * @brief rb_tree_os_replace_node keeps an order-statistic tree's subtree sizes exact.
+ * @details rb_replace_node copies links and color but not rb_os_node_t::size, so on an order-statistic tree the
+ * replacement's stale size threw off rb_rank, rb_select and rb_count_range above it. Here every node of a 2000-node
+ * tree is replaced by a copy carrying a bogus size, and ranks, selects and range counts are checked afterwards, as is
+ * deleting from the tree once it is made up of the replacements.
+ *
+ *     cc -g -fsanitize=address,undefined -I. test/test_os.c rbtree.c -o test_os && ./test_os
+ */
+
+#include "rbtree.h"
+#include "test/test.h"
+
+#include <stdlib.h>
+
+typedef struct item {
+	long key;
+	rb_os_node_t node;
+} item_t;
+
+#define ITEMS												2000
+
+static int cmp(const rb_node_t *left, const rb_node_t *right) {
+	long a = container_of(rb_os_entry(left), item_t, node)->key, b = container_of(rb_os_entry(right), item_t, node)->key;
+
+	return (a > b) - (a < b);
+}
+
+static long key_of(const rb_node_t *node) {
+	return container_of(rb_os_entry(node), item_t, node)->key;
+}
+
+/**
+ * @brief Checks that select and rank agree with key order over the n nodes left, and that every node is one of the
+ * replacements.
+ */
+static void check_tree(const rb_tree_t *tree, const item_t *replacements, size_t n) {
+	size_t k = 0;
+
+	TEST_CHECK(rb_os_size(rb_root(tree)) == n);
+	TEST_CHECK(rb_select(tree, n) == NULL);
+
+	for (const rb_node_t *node = rb_first(tree); node; node = rb_next((rb_iterator_t) node), k++) {
+		const item_t *obj = container_of(rb_os_entry(node), item_t, node);
+
+		TEST_CHECK(obj >= replacements && obj < replacements + ITEMS);
+		TEST_CHECK(rb_rank((rb_iterator_t) node) == k);
+		TEST_CHECK(rb_select(tree, k) == node);
+	}
+
+	TEST_CHECK(k == n);
+	TEST_CHECK(rb_count_range(tree, NULL, NULL) == n);
+}
+
+int main(void) {
+	item_t *originals = calloc(ITEMS, sizeof(*originals)), *replacements = calloc(ITEMS, sizeof(*replacements));
+	rb_tree_t tree;
+	size_t n = ITEMS;
+
+	rb_tree_init(&tree);
+
+	/* keys are shuffled so the tree isn't built from a single run of appends */
+	for (long i = 0; i < ITEMS; i++) {
+		originals[i].key = (i * 7919) % ITEMS;
+		rb_tree_os_insert(&tree, &originals[i].node, cmp);
+	}
+
+	for (size_t i = 0; i < ITEMS; i++) {
+		replacements[i].key = originals[i].key;
+		replacements[i].node.size = 12345;
+		rb_tree_os_replace_node(&tree, &originals[i].node, &replacements[i].node);
+	}
+
+	check_tree(&tree, replacements, n);
+
+	/* a range count between two keys, from rb_select's bounds */
+	TEST_CHECK(rb_count_range(&tree, rb_select(&tree, 100), rb_select(&tree, 1100)) == 1000);
+	TEST_CHECK(rb_select(&tree, 100) && key_of(rb_select(&tree, 100)) == 100);
+
+	/* deletes rebalance through the replacements, so their sizes have to be right for the tree to stay exact */
+	for (size_t i = 0; i < ITEMS; i += 3) {
+		rb_tree_os_delete_at(&tree, &replacements[i].node.node);
+		n--;
+	}
+
+	check_tree(&tree, replacements, n);
+
+	free(replacements);
+	free(originals);
+
+	return test_finish("test_os");
+}
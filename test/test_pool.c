@@ -0,0 +1,96 @@
+/**
+ * @file test_pool.c
+ * @author krad2
+ * @brief rb_pool_compact on a tree holding far more nodes than the pool counts as live.
+ * @details Compaction used to size its new slab from the pool's live count and then copy every tree node into it,
+ * so a tree with nodes from another allocator overran the slab. Here 10 pooled objects share a tree with 5000
+ * malloc'd ones, and the tree is compacted in both orders.
+ *
+ *     cc -g -fsanitize=address,undefined -I. test/test_pool.c rbtree.c rbtree_pool.c -o test_pool && ./test_pool
+ */
+
+#include "rbtree.h"
+#include "rbtree_pool.h"
+#include "test/test.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+typedef struct item {
+	long key;
+	rb_node_t node;
+} item_t;
+
+#define POOLED												10
+#define MALLOCED											5000
+
+static int cmp(const rb_node_t *left, const rb_node_t *right) {
+	long a = rb_entry(left, item_t, node)->key, b = rb_entry(right, item_t, node)->key;
+
+	return (a > b) - (a < b);
+}
+
+static void count_moved(void *from, void *to, void *ctx) {
+	TEST_CHECK(((item_t *) from)->key == ((item_t *) to)->key);
+	(*(size_t *) ctx)++;
+}
+
+/**
+ * @brief Checks the tree holds every key once, in order.
+ */
+static void check_tree(const rb_tree_t *tree) {
+	size_t n = 0;
+	long prev = -1;
+
+	for (const rb_node_t *node = rb_first(tree); node; node = rb_next((rb_iterator_t) node)) {
+		long key = rb_entry(node, item_t, node)->key;
+
+		TEST_CHECK(key > prev);
+		prev = key;
+		n++;
+	}
+
+	TEST_CHECK(n == POOLED + MALLOCED);
+}
+
+int main(void) {
+	item_t **malloced = malloc(MALLOCED * sizeof(*malloced));
+	rb_tree_t tree;
+	rb_pool_t pool;
+
+	/* small slabs, so the pool's own slab is nowhere near big enough for the whole tree */
+	TEST_CHECK(rb_pool_init(&pool, sizeof(item_t), offsetof(item_t, node), 4096));
+	rb_tree_init(&tree);
+
+	for (long i = 0; i < POOLED; i++) {
+		item_t *obj = rb_pool_alloc(&pool);
+
+		obj->key = i;
+		rb_tree_insert(&tree, &obj->node, cmp);
+	}
+
+	for (long i = 0; i < MALLOCED; i++) {
+		malloced[i] = malloc(sizeof(item_t));
+		malloced[i]->key = POOLED + i;
+		rb_tree_insert(&tree, &malloced[i]->node, cmp);
+	}
+
+	for (int order = rb_pool_inorder; order <= rb_pool_breadth_first; order++) {
+		size_t moved = 0;
+
+		TEST_CHECK(rb_pool_compact(&pool, &tree, (rb_pool_order_t) order, count_moved, &moved));
+		TEST_CHECK(moved == POOLED + MALLOCED);
+		TEST_CHECK(pool.live == POOLED + MALLOCED);
+		check_tree(&tree);
+
+		/* the first compaction copied the malloc'd objects into the pool, so the originals are done with */
+		if (order == rb_pool_inorder) {
+			for (long i = 0; i < MALLOCED; i++) free(malloced[i]);
+		}
+	}
+
+	rb_pool_destroy(&pool);
+	free(malloced);
+
+	return test_finish("test_pool");
+}